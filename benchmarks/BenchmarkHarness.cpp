@@ -0,0 +1,127 @@
+#include "BenchmarkHarness.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include "../shapes/PoolAllocator.h"
+
+namespace {
+
+std::atomic<std::uint64_t> allocations{0};
+volatile double sink = 0.0;
+
+std::string escape_json(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+} // namespace
+
+// Count every allocation of the process; the benchmarks report them per operation.
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+std::uint64_t allocation_count() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void do_not_optimize(const double value) {
+    sink = sink + value;
+}
+
+int run_benchmarks(const std::vector<Benchmark>& benchmarks, const BenchmarkOptions& options) {
+    typedef std::chrono::steady_clock Clock;
+    std::ostringstream json;
+    json << "{\n  \"benchmarks\": [";
+    bool first_benchmark = true;
+
+    std::fprintf(stderr, "%-28s %10s %12s %14s %12s %12s\n", "benchmark", "n", "iterations", "ns/op", "allocs/op", "pooled/op");
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos) continue;
+
+        std::vector<BenchmarkResult> results;
+        for (std::size_t n = options.min_n; n <= std::min(options.max_n, benchmark.max_n); n *= 10) {
+            std::function<void()> body = benchmark.setup(n);
+            body();   // warm-up: caches, lazily grown buffers, thread pools
+
+            BenchmarkResult result;
+            result.n = n;
+            std::uint64_t allocations_before = allocation_count();
+            std::uint64_t pooled_before = SmallObjectPool::total_stats().allocations;
+            Clock::time_point start = Clock::now();
+            double elapsed = 0.0;
+            do {
+                body();
+                ++result.iterations;
+                elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+            } while (elapsed < options.min_time);
+            std::uint64_t allocations_made = allocation_count() - allocations_before;
+            std::uint64_t pooled_made = SmallObjectPool::total_stats().allocations - pooled_before;
+
+            double operations = static_cast<double>(result.iterations) * static_cast<double>(n);
+            result.ns_per_op = elapsed * 1e9 / operations;
+            result.allocations_per_op = static_cast<double>(allocations_made) / operations;
+            result.pooled_allocations_per_op = static_cast<double>(pooled_made) / operations;
+            results.push_back(result);
+            std::fprintf(stderr, "%-28s %10zu %12llu %14.3f %12.3f %12.3f\n", benchmark.name.c_str(), n,
+                         static_cast<unsigned long long>(result.iterations), result.ns_per_op, result.allocations_per_op,
+                         result.pooled_allocations_per_op);
+        }
+
+        json << (first_benchmark ? "\n" : ",\n") << "    {\"name\": \"" << escape_json(benchmark.name) << "\", \"results\": [";
+        first_benchmark = false;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            json << (i == 0 ? "\n" : ",\n")
+                 << "      {\"n\": " << results[i].n
+                 << ", \"iterations\": " << results[i].iterations
+                 << ", \"ns_per_op\": " << results[i].ns_per_op
+                 << ", \"allocations_per_op\": " << results[i].allocations_per_op
+                 << ", \"pooled_allocations_per_op\": " << results[i].pooled_allocations_per_op << "}";
+        }
+        json << "\n    ]}";
+    }
+    json << "\n  ]\n}\n";
+
+    if (options.output.empty()) {
+        std::cout << json.str();
+    } else {
+        std::ofstream file(options.output);
+        if (!file) {
+            std::cerr << "Error: cannot write " << options.output << std::endl;
+            return 1;
+        }
+        file << json.str();
+    }
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef BENCHMARK_HARNESS_H
+#define BENCHMARK_HARNESS_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Number of heap allocations made so far by the process (counted by the benchmark's operator new).
+std::uint64_t allocation_count();
+
+// Keeps a value alive so the optimizer cannot drop the computation that produced it.
+void do_not_optimize(const double value);
+
+// One parameterized benchmark. setup(n) prepares the inputs for problem size n outside of the timed region
+// and returns the body to time; one call of the body performs n operations.
+struct Benchmark {
+    std::string name;
+    std::size_t max_n;
+    std::function<std::function<void()>(std::size_t)> setup;
+};
+
+struct BenchmarkResult {
+    std::size_t n = 0;
+    std::uint64_t iterations = 0;
+    double ns_per_op = 0.0;
+    double allocations_per_op = 0.0;
+    double pooled_allocations_per_op = 0.0;   // served by the shape pool, which operator new does not see
+};
+
+struct BenchmarkOptions {
+    std::size_t min_n = 100;
+    std::size_t max_n = 1000000;
+    double min_time = 0.2;        // seconds of timed runs per (benchmark, n)
+    std::string filter;           // only run benchmarks whose name contains this
+    std::string output;           // JSON file, empty for stdout
+};
+
+// Runs every benchmark at n = min_n, 10 * min_n, ... up to the smaller of options.max_n and benchmark.max_n,
+// prints a table to stderr and writes the scaling curves as JSON.
+int run_benchmarks(const std::vector<Benchmark>& benchmarks, const BenchmarkOptions& options);
+
+
+#endif // BENCHMARK_HARNESS_H
@@ -0,0 +1,339 @@
+#include <random>
+#include "BenchmarkHarness.h"
+#include "../shapes/Circle.h"
+#include "../shapes/Rectangle.h"
+#include "../shapes/Triangle.h"
+#include "../shapes/SegmentIntersection.h"
+#include "../physics/Simulation.h"
+#include "../physics/BarnesHut.h"
+#include "../physics/ParticleMesh.h"
+
+namespace {
+
+std::vector<std::shared_ptr<Point>> random_points(const std::size_t n, std::mt19937& rng, const double extent) {
+    std::uniform_real_distribution<double> coordinate(-extent, extent);
+    std::vector<std::shared_ptr<Point>> points;
+    points.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        points.push_back(std::make_shared<Point>(coordinate(rng), coordinate(rng)));
+    }
+    return points;
+}
+
+// A scene of resting balls spread over a square sized for a constant density, as in the simulator.
+std::shared_ptr<ParticleSystem> random_scene(const std::size_t n, const unsigned int seed) {
+    std::mt19937 rng(seed);
+    double extent = 20.0 * std::sqrt(static_cast<double>(n));
+    std::uniform_real_distribution<double> coordinate(-extent, extent);
+    std::uniform_int_distribution<int> radius(5, 9);
+    std::shared_ptr<ParticleSystem> particles = std::make_shared<ParticleSystem>();
+    particles->reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        particles->add(coordinate(rng), coordinate(rng), radius(rng), 1.0);
+    }
+    return particles;
+}
+
+std::function<void()> gravity_benchmark(const std::size_t n, std::shared_ptr<GravitySolver> solver) {
+    std::shared_ptr<ParticleSystem> particles = random_scene(n, 7);
+    return [particles, solver]() {
+        solver->compute(*particles);
+        do_not_optimize(particles->ax[0]);
+    };
+}
+
+std::vector<Benchmark> make_benchmarks() {
+    std::vector<Benchmark> benchmarks;
+    const std::size_t all = static_cast<std::size_t>(-1);
+    const double G = 5000;
+
+    benchmarks.push_back({"point_arithmetic", all, [](std::size_t n) {
+        std::mt19937 rng(1);
+        auto points = std::make_shared<std::vector<std::shared_ptr<Point>>>(random_points(n, rng, 100.0));
+        auto offset = std::make_shared<Point>(0.5, -0.25);
+        return std::function<void()>([points, offset]() {
+            double sum = 0.0;
+            for (auto& point : *points) {
+                sum += point->add(offset)->multiply(0.5)->dot(offset);
+            }
+            do_not_optimize(sum);
+        });
+    }});
+
+    benchmarks.push_back({"point_mid_point_to", all, [](std::size_t n) {
+        std::mt19937 rng(2);
+        auto points = std::make_shared<std::vector<std::shared_ptr<Point>>>(random_points(n + 1, rng, 100.0));
+        return std::function<void()>([points]() {
+            double sum = 0.0;
+            for (std::size_t i = 0; i + 1 < points->size(); ++i) {
+                sum += (*points)[i]->mid_point_to((*points)[i + 1])->get_x();
+            }
+            do_not_optimize(sum);
+        });
+    }});
+
+    benchmarks.push_back({"line_intersection", all, [](std::size_t n) {
+        std::mt19937 rng(3);
+        auto ends = random_points(4 * n, rng, 100.0);
+        auto lines = std::make_shared<std::vector<std::shared_ptr<Line>>>();
+        for (std::size_t i = 0; i < 2 * n; ++i) {
+            lines->push_back(std::make_shared<Line>(ends[2 * i], ends[2 * i + 1]));
+        }
+        return std::function<void()>([lines]() {
+            double sum = 0.0;
+            for (std::size_t i = 0; i + 1 < lines->size(); i += 2) {
+                try {
+                    sum += (*lines)[i]->intersection((*lines)[i + 1])->get_x();
+                } catch (const std::runtime_error&) {
+                    // parallel pair
+                }
+            }
+            do_not_optimize(sum);
+        });
+    }});
+
+    benchmarks.push_back({"line_intersection_vec2", all, [](std::size_t n) {
+        std::mt19937 rng(3);
+        auto ends = random_points(4 * n, rng, 100.0);
+        auto lines = std::make_shared<std::vector<std::shared_ptr<Line>>>();
+        auto others = std::make_shared<std::vector<Vec2>>();
+        for (std::size_t i = 0; i < n; ++i) {
+            lines->push_back(std::make_shared<Line>(ends[4 * i], ends[4 * i + 1]));
+            others->push_back(ends[4 * i + 2]->to_vec2());
+            others->push_back(ends[4 * i + 3]->to_vec2());
+        }
+        return std::function<void()>([lines, others]() {
+            double sum = 0.0;
+            for (std::size_t i = 0; i < lines->size(); ++i) {
+                try {
+                    sum += (*lines)[i]->intersection((*others)[2 * i], (*others)[2 * i + 1]).x;
+                } catch (const std::runtime_error&) {
+                    // parallel pair
+                }
+            }
+            do_not_optimize(sum);
+        });
+    }});
+
+    // Short segments at a constant density, a few crossings each, as in a drawn or generated layout.
+    auto segment_layout = [](const std::size_t n) {
+        std::mt19937 rng(9);
+        const double extent = 10.0 * std::sqrt(static_cast<double>(n));
+        std::uniform_real_distribution<double> coordinate(-extent, extent);
+        std::uniform_real_distribution<double> offset(-10.0, 10.0);
+        auto segments = std::make_shared<std::vector<Segment>>();
+        for (std::size_t i = 0; i < n; ++i) {
+            const Vec2 start(coordinate(rng), coordinate(rng));
+            segments->push_back({start, start + Vec2(offset(rng), offset(rng))});
+        }
+        return segments;
+    };
+
+    benchmarks.push_back({"segment_intersections_sweep", all, [segment_layout](std::size_t n) {
+        auto segments = segment_layout(n);
+        return std::function<void()>([segments]() {
+            do_not_optimize(find_intersections(*segments).size());
+        });
+    }});
+
+    benchmarks.push_back({"segment_intersections_pairwise", 10000, [segment_layout](std::size_t n) {
+        auto segments = segment_layout(n);
+        return std::function<void()>([segments]() {
+            std::size_t found = 0;
+            Vec2 point;
+            for (std::size_t i = 0; i < segments->size(); ++i) {
+                for (std::size_t j = i + 1; j < segments->size(); ++j) {
+                    found += segments_intersect((*segments)[i], (*segments)[j], point);
+                }
+            }
+            do_not_optimize(found);
+        });
+    }});
+
+    benchmarks.push_back({"circle_solve_with", all, [](std::size_t n) {
+        std::mt19937 rng(4);
+        auto centers = random_points(n, rng, 10.0);
+        auto circles = std::make_shared<std::vector<std::shared_ptr<Circle>>>();
+        for (auto& center : centers) {
+            circles->push_back(std::make_shared<Circle>(center, 20.0));
+        }
+        auto line = std::make_shared<Line>(std::make_shared<Point>(-50, -30), std::make_shared<Point>(50, 40));
+        return std::function<void()>([circles, line]() {
+            double sum = 0.0;
+            for (auto& circle : *circles) {
+                sum += circle->solve_with(line)->length();
+            }
+            do_not_optimize(sum);
+        });
+    }});
+
+    benchmarks.push_back({"shape_solve_quadratic", all, [](std::size_t n) {
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<double> coefficient(-10.0, 10.0);
+        auto coefficients = std::make_shared<std::vector<double>>();
+        for (std::size_t i = 0; i < 3 * n; ++i) {
+            coefficients->push_back(coefficient(rng));
+        }
+        return std::function<void()>([coefficients]() {
+            double sum = 0.0;
+            const std::vector<double>& c = *coefficients;
+            for (std::size_t i = 0; i + 2 < c.size(); i += 3) {
+                std::vector<double> roots = Shape::solve_quadratic(c[i], c[i + 1], c[i + 2]);
+                sum += roots.size();
+            }
+            do_not_optimize(sum);
+        });
+    }});
+
+    benchmarks.push_back({"rectangle_contains", all, [](std::size_t n) {
+        std::mt19937 rng(6);
+        auto points = std::make_shared<std::vector<std::shared_ptr<Point>>>(random_points(n, rng, 100.0));
+        auto rectangle = std::make_shared<Rectangle>(std::make_shared<Point>(-50, 50), std::make_shared<Point>(50, -50));
+        return std::function<void()>([points, rectangle]() {
+            double inside = 0.0;
+            for (auto& point : *points) {
+                inside += rectangle->contains(point) ? 1.0 : 0.0;
+            }
+            do_not_optimize(inside);
+        });
+    }});
+
+    benchmarks.push_back({"triangle_calculate_area", all, [](std::size_t n) {
+        std::mt19937 rng(7);
+        auto vertices = random_points(3 * n, rng, 100.0);
+        auto triangles = std::make_shared<std::vector<std::shared_ptr<Triangle>>>();
+        for (std::size_t i = 0; i < n; ++i) {
+            triangles->push_back(std::make_shared<Triangle>(vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]));
+        }
+        return std::function<void()>([triangles]() {
+            double sum = 0.0;
+            for (auto& triangle : *triangles) {
+                sum += triangle->calculate_area();
+            }
+            do_not_optimize(sum);
+        });
+    }});
+
+    // One operation is the net acceleration of one body. The O(n^2) engines stop at 100k bodies.
+    benchmarks.push_back({"gravity_brute_force", 100000, [G](std::size_t n) {
+        return gravity_benchmark(n, std::make_shared<BruteForceGravity>(G));
+    }});
+
+    benchmarks.push_back({"gravity_simd", 100000, [G](std::size_t n) {
+        std::shared_ptr<BruteForceGravity> solver = std::make_shared<BruteForceGravity>(G);
+        solver->set_kernel(std::make_shared<GravityKernel>());
+        return gravity_benchmark(n, solver);
+    }});
+
+    // The same kernel on float copies of the particles: twice the lanes and half the bytes per source.
+    benchmarks.push_back({"gravity_simd_float", 100000, [G](std::size_t n) {
+        std::shared_ptr<BruteForceGravity> solver = std::make_shared<BruteForceGravity>(G);
+        solver->set_kernel(std::make_shared<GravityKernel>(false, detect_simd_level(), Precision::Float));
+        return gravity_benchmark(n, solver);
+    }});
+
+    benchmarks.push_back({"gravity_barnes_hut", all, [G](std::size_t n) {
+        return gravity_benchmark(n, std::make_shared<BarnesHutGravity>(G, 0.5));
+    }});
+
+    // The mesh grows with n, the smallest power of two of at least sqrt(n) nodes per side.
+    benchmarks.push_back({"gravity_particle_mesh", all, [G](std::size_t n) {
+        std::size_t mesh_size = 16;
+        while (mesh_size * mesh_size < n) mesh_size *= 2;
+        return gravity_benchmark(n, std::make_shared<ParticleMeshGravity>(G, mesh_size));
+    }});
+
+    // One operation is one ball of the narrowphase pass.
+    benchmarks.push_back({"collision_brute_force", 100000, [](std::size_t n) {
+        std::shared_ptr<ParticleSystem> particles = random_scene(n, 11);
+        return std::function<void()>([particles]() {
+            do_not_optimize(static_cast<double>(resolve_collisions(*particles).contacts));
+        });
+    }});
+
+    benchmarks.push_back({"collision_grid", all, [](std::size_t n) {
+        std::shared_ptr<ParticleSystem> particles = random_scene(n, 11);
+        std::shared_ptr<SpatialGrid> grid = std::make_shared<SpatialGrid>();
+        return std::function<void()>([particles, grid]() {
+            do_not_optimize(static_cast<double>(resolve_collisions(*particles, *grid).contacts));
+        });
+    }});
+
+    // The grid pass with the colored contacts resolved on one thread per hardware thread.
+    benchmarks.push_back({"collision_colored", all, [](std::size_t n) {
+        std::shared_ptr<ParticleSystem> particles = random_scene(n, 11);
+        std::shared_ptr<SpatialGrid> grid = std::make_shared<SpatialGrid>();
+        std::shared_ptr<ContactSolver> solver = std::make_shared<ContactSolver>(std::make_shared<ThreadPool>());
+        return std::function<void()>([particles, grid, solver]() {
+            do_not_optimize(static_cast<double>(solver->resolve(*particles, *grid).contacts));
+        });
+    }});
+
+    // n balls against a maze of about as many wall segments, one 60-unit cell per ball, through the BVH.
+    benchmarks.push_back({"obstacle_collisions", all, [](std::size_t n) {
+        std::shared_ptr<ParticleSystem> particles = random_scene(n, 12);
+        std::shared_ptr<StaticObstacles> obstacles = std::make_shared<StaticObstacles>();
+        std::mt19937 rng(13);
+        std::bernoulli_distribution wall(0.5);
+        const double extent = 20.0 * std::sqrt(static_cast<double>(n));
+        for (double x = -extent; x < extent; x += 60.0) {
+            for (double y = -extent; y < extent; y += 60.0) {
+                if (wall(rng)) obstacles->add(Segment{Vec2(x, y), Vec2(x, y + 60.0)});
+                if (wall(rng)) obstacles->add(Segment{Vec2(x, y), Vec2(x + 60.0, y)});
+            }
+        }
+        obstacles->build();
+        return std::function<void()>([particles, obstacles]() {
+            do_not_optimize(static_cast<double>(obstacles->resolve(*particles, 0.5).contacts));
+        });
+    }});
+
+    return benchmarks;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--min-n N] [--max-n N] [--min-time SECONDS] [--filter NAME] [--output FILE.json]" << std::endl;
+}
+
+} // namespace
+
+/**
+ * @brief Entry point of the microbenchmark suite. Every benchmark runs at n = 100, 1000, ... up to --max-n
+ * and reports ns/op and allocations/op; the scaling curves are written as JSON.
+ */
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--help" || arg == "-h") {
+                print_usage(argv[0]);
+                return 0;
+            } else if (i + 1 >= argc) {
+                throw std::invalid_argument("Missing value for " + arg);
+            } else if (arg == "--min-n") {
+                options.min_n = std::max<std::size_t>(1, std::stoull(argv[++i]));
+            } else if (arg == "--max-n") {
+                options.max_n = std::stoull(argv[++i]);
+            } else if (arg == "--min-time") {
+                options.min_time = std::stod(argv[++i]);
+            } else if (arg == "--filter") {
+                options.filter = argv[++i];
+            } else if (arg == "--output") {
+                options.output = argv[++i];
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+    return run_benchmarks(make_benchmarks(), options);
+}
+
+// to run:
+// cmake -S . -B build -DCMAKE_BUILD_TYPE=Release
+// cmake --build build
+// ./build/PhysicsBenchmarks --max-n 100000 --output bench.json
@@ -0,0 +1,14 @@
+#include "physics/Headless.h"
+
+/**
+ * @brief Entry point of the headless simulator. It runs the same physics pipeline as the windowed
+ * PhysicsSimulator, without opening a window or linking SFML, and reports the throughput.
+ */
+int main(int argc, char** argv) {
+    return run_headless(argc, argv);
+}
+
+// to run:
+// cmake -S . -B build
+// cmake --build build
+// ./build/PhysicsHeadless --bodies 5000 --steps 200 --dt 0.01 --seed 1
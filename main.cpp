@@ -10,46 +10,44 @@
 #include "shapes/Triangle.h"
 #include "shapes/Rectangle.h"
 #include "shapes/Circle.h"
-
-// Function to handle collision between two balls
-void handle_ball_collision(std::shared_ptr<Circle> a, std::shared_ptr<Circle> b) {
-    auto dx = b->getCenter()->get_x() - a->getCenter()->get_x();
-    auto dy = b->getCenter()->get_y() - a->getCenter()->get_y();
-    double distance = std::sqrt(dx * dx + dy * dy);
-    double min_dist = a->getRadius() + b->getRadius();
-
-    if (distance < min_dist && distance > 0.0) { // Ensure actual overlap and avoid division by zero
-        double overlap = 0.5 * (min_dist - distance);
-
-        // Displace balls to prevent overlap
-        a->setCenterX(a->getCenter()->get_x() - overlap * (dx / distance));
-        a->setCenterY(a->getCenter()->get_y() - overlap * (dy / distance));
-        b->setCenterX(b->getCenter()->get_x() + overlap * (dx / distance));
-        b->setCenterY(b->getCenter()->get_y() + overlap * (dy / distance));
-
-        // Simple elastic collision response (equal mass assumption)
-        auto va = a->getVelocity();
-        auto vb = b->getVelocity();
-
-        double nx = dx / distance;
-        double ny = dy / distance;
-
-        double p = 2 * (va->get_x() * nx + va->get_y() * ny - vb->get_x() * nx - vb->get_y() * ny) / 2;
-
-        a->setVelocity(va->get_x() - p * nx, va->get_y() - p * ny);
-        b->setVelocity(vb->get_x() + p * nx, vb->get_y() + p * ny);
-    }
-}
+#include "physics/Simulation.h"
+#include "physics/SimulationThread.h"
+#include "physics/SceneLoader.h"
+#include "physics/Headless.h"
+#include "physics/Profiler.h"
+#include "render/BatchedCircleRenderer.h"
 
 /**
  * @brief The main function of this program. It sets up a window of size 1200x900 and a view that is centered at the origin.
- * It then creates a few shapes and draws them to the window in a loop until the window is closed.
+ * It then creates the balls and steps the simulation and draws it to the window in a loop until the window is closed.
  * The loop polls for events and if the window is closed, it closes the window.
- * It then clears the window to black, draws the x and y axes, and draws the shapes to the window.
- * It also rotates the line by 0.001 degrees each frame.
+ * It then clears the window to black, draws the x and y axes, the boundaries and the balls to the window.
  * It then displays the window on screen.
+ * Started with --headless as first argument, it runs the simulation without a window instead (see physics/Headless.h).
+ * Started with --restore FILE, it resumes from a checkpoint instead of creating new balls; F5 saves one.
+ * --scene FILE loads the initial balls, boundaries and constants from a scene file (see physics/SceneLoader.h).
+ * --record FILE writes every step to a trajectory file, --play FILE shows a recorded trajectory instead of simulating.
+ * --obstacles maze|funnel fills the box with static obstacles for the balls to bounce off.
+ * In a build with PHYSICS_PROFILE on, F2 writes the recent phase timings to profile.json (see physics/Profiler.h).
  */
-int main() {
+int main(int argc, char** argv) {
+    if (argc > 1 && std::string(argv[1]) == "--headless") {
+        return run_headless(argc - 1, argv + 1);
+    }
+    std::string restore_path;
+    std::string record_path;
+    std::string play_path;
+    std::string scene_path;
+    std::string obstacle_scene;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--restore") restore_path = argv[i + 1];
+        else if (arg == "--record") record_path = argv[i + 1];
+        else if (arg == "--play") play_path = argv[i + 1];
+        else if (arg == "--scene") scene_path = argv[i + 1];
+        else if (arg == "--obstacles") obstacle_scene = argv[i + 1];
+    }
+
     float width = 1200;
     float height = 900;
     sf::RenderWindow window(sf::VideoMode(static_cast<unsigned int>(width), static_cast<unsigned int>(height)), "SFML window");
@@ -63,124 +61,173 @@ int main() {
         std::make_shared<Point>(width / 2 - 1, -height / 2 + 1)
     );
 
-    sf::Clock clock;
     // Friction coefficient
     double diminishing_factor = 0.1;
-    // Gravitational constant (adjust this value for visible gravitational effects)
-    const double G = 5000;
 
-    std::vector<std::shared_ptr<Circle>> balls;
+    GravitySettings gravity_settings;
+    // Gravitational constant (adjust this value for visible gravitational effects)
+    gravity_settings.G = 5000;
+    // Gravity engine: "brute-force" is the exact O(n^2) reference, "simd" runs it through the vectorized kernel,
+    // "barnes-hut" scales to large n, "particle-mesh" solves on an FFT grid for very large n.
+    gravity_settings.engine = "barnes-hut";
+    // Barnes-Hut opening angle, 0 reproduces the brute-force sum.
+    gravity_settings.theta = 0.5;
+    // Threads used by the gravity pass, 0 means one per hardware thread.
+    gravity_settings.threads = 0;
+    // Keep the brute-force summation order bit-identical to the single-threaded pass.
+    gravity_settings.deterministic = false;
+    // Use the reciprocal square root estimate in the SIMD kernel.
+    gravity_settings.fast_rsqrt = false;
+    // Scalar type of the SIMD kernel: "float" doubles its throughput, "double" keeps orbits precise.
+    gravity_settings.precision = "double";
+    // Particle-mesh nodes per side (a power of two), mass assignment ("cic" or "tsc") and direct short-range
+    // correction. Around sqrt(n) nodes per side keeps the short-range pass cheap.
+    gravity_settings.mesh_size = 256;
+    gravity_settings.mesh_assignment = "cic";
+    gravity_settings.mesh_short_range = true;
+
+    Simulation simulation(boundaries, make_gravity_solver(gravity_settings), diminishing_factor);
     int num_balls = 100;
-
-    for (int i = 0; i < num_balls; ++i) {
-        int x = rand() % (int)width - width / 2;
-        int y = rand() % (int)height - height / 2;
-        int radius = rand() % 5 + 5;
-        int max_speed = 500;
-        int min_speed = -500;
-        // int speed_x = rand() % (max_speed - min_speed + 1) + min_speed;
-        // int speed_y = rand() % (max_speed - min_speed + 1) + min_speed;
-        int speed_x = 0;
-        int speed_y = 0;
-        int max_acc = 5000;
-        int min_acc = -5000;
-        // int acc_x = rand() % (max_acc - min_acc + 1) + min_acc;
-        // int acc_y = rand() % (max_acc - min_acc + 1) + min_acc;
-        int acc_x = 0;
-        // int acc_y = -5000;
-        // For this simulation we use gravitational interaction between balls, so a constant acceleration is no longer added.
-        int acc_y = 0;
-        int max_mass = 1000;
-        int min_mass = 100;
-        // int mass = rand() % (max_mass - min_mass + 1) + min_mass;
-        int mass = 1;
-
-        // Create the ball with its radius (you might want to use the 'radius' variable here if needed)
-        balls.push_back(std::make_shared<Circle>(std::make_shared<Point>(x, y), radius));
-        balls[i]->setVelocity(std::make_shared<Point>(speed_x, speed_y))
-                 ->setAcceleration(acc_x, acc_y)
-                 ->setMass(mass);
+    // Time integration: "euler", "leapfrog", "yoshida4", "rk4" or "block". The symplectic leapfrog and Yoshida
+    // schemes keep the energy error bounded at much larger timesteps than Euler; "block" gives every ball its own
+    // power-of-two fraction of the step.
+    simulation.set_integrator(make_integrator("euler"));
+    // Ball-ball contacts are resolved in parallel batches that share no ball; 1 resolves them serially.
+    simulation.set_collision_threads(gravity_settings.threads);
+    // Resume from a checkpoint (see physics/Checkpoint.h) if one was given, F5 saves the current state.
+    const std::string checkpoint_path = "simulation.ckpt";
+    if (!restore_path.empty()) {
+        load_checkpoint(restore_path, simulation);
+        boundaries = simulation.get_boundaries();
+    } else if (!scene_path.empty()) {
+        load_scene(scene_path, simulation);
+        boundaries = simulation.get_boundaries();
+    } else {
+        simulation.add_random_balls(num_balls, 1);
+    }
+    if (!obstacle_scene.empty()) simulation.add_obstacle_scene(obstacle_scene, 1);
+
+    // Balls that settle into a pile stop being integrated and collided until something hits their pile.
+    SleepSettings sleep_settings;
+    sleep_settings.enabled = true;
+    // Speed below which a ball counts as still, and for how many steps it has to stay that way.
+    sleep_settings.velocity_threshold = 2.0;
+    sleep_settings.steps = 120;
+    simulation.set_sleep_settings(sleep_settings);
+    // Fast balls are swept along the step, so they bounce off each other and the walls instead of passing through.
+    ContinuousCollisionSettings sweep_settings;
+    sweep_settings.enabled = true;
+    simulation.set_continuous_collision_settings(sweep_settings);
+
+    // The physics runs on its own thread with a fixed timestep; the window only draws the published states.
+    const double fixed_delta_time = 1.0 / 240.0;
+    // Blend between the two newest states so the motion stays smooth when the frame rate and step rate differ.
+    bool interpolate = true;
+    SnapshotBuffer snapshots;
+    CheckpointWriter checkpoints;
+    std::unique_ptr<TrajectoryRecorder> recorder;
+    if (!record_path.empty()) recorder.reset(new TrajectoryRecorder(record_path));
+    SimulationThread physics_thread(simulation, snapshots, fixed_delta_time);
+    physics_thread.set_checkpoint_writer(&checkpoints, checkpoint_path);
+    physics_thread.set_trajectory_recorder(recorder.get());
+    // A recording plays into the same snapshot buffer in place of the physics thread.
+    std::unique_ptr<TrajectoryReader> recording;
+    std::unique_ptr<TrajectoryPlayer> player;
+    if (!play_path.empty()) {
+        recording.reset(new TrajectoryReader(play_path));
+        player.reset(new TrajectoryPlayer(*recording, snapshots));
+        player->start();
+    } else {
+        physics_thread.start();
     }
 
+    sf::Clock since_snapshot;
+    std::size_t shown_asleep = 0;
+    std::size_t shown_size = 0;
+    // All balls go into one vertex array and one draw call.
+    BatchedCircleRenderer ball_renderer(BatchedCircleRenderer::Mode::TexturedQuad);
+    // The axes and the boundaries never change: build their drawables once.
+    std::shared_ptr<sf::VertexArray> x_axis_vertices = x_axis->to_vertex_array();
+    std::shared_ptr<sf::VertexArray> y_axis_vertices = y_axis->to_vertex_array();
+    std::shared_ptr<sf::ConvexShape> boundaries_shape = boundaries->to_convex_shape(sf::Color::Transparent, sf::Color::White, 3.0);
+    // Neither do the obstacles, all their edges in one vertex array.
+    const std::vector<Segment>& obstacle_segments = simulation.get_obstacles().get_segments();
+    sf::VertexArray obstacle_vertices(sf::PrimitiveType::Lines, 2 * obstacle_segments.size());
+    for (std::size_t k = 0; k < obstacle_segments.size(); ++k) {
+        obstacle_vertices[2 * k].position = sf::Vector2f(static_cast<float>(obstacle_segments[k].start.x), static_cast<float>(obstacle_segments[k].start.y));
+        obstacle_vertices[2 * k + 1].position = sf::Vector2f(static_cast<float>(obstacle_segments[k].end.x), static_cast<float>(obstacle_segments[k].end.y));
+    }
 
+    Profiler::instance().set_thread_name("render");
     while (window.isOpen()) {
-        float delta_time = clock.restart().asSeconds();
-
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed) {
-                window.close();
+        PROFILE_SCOPE("frame");
+        {
+            PROFILE_SCOPE("events");
+            sf::Event event;
+            while (window.pollEvent(event)) {
+                if (event.type == sf::Event::Closed) {
+                    window.close();
+                } else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F5) {
+                    physics_thread.request_checkpoint();
+                } else if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::F2 && Profiler::enabled()) {
+                    try {
+                        Profiler::instance().write_chrome_trace("profile.json");
+                        std::cout << "Wrote profile.json" << std::endl;
+                    } catch (const std::exception& e) {
+                        std::cerr << e.what() << std::endl;
+                    }
+                }
             }
         }
 
-        // Compute gravitational acceleration for each ball due to every other ball.
-        // For ball i, the acceleration from ball j is: a = G * mass_j / (r^2) in the direction of ball j,
-        // or more precisely: a = G * mass_j * (r_vector) / |r|^3.
-        for (auto& ball : balls) {
-            double net_ax = 0.0;
-            double net_ay = 0.0;
-            for (auto& other : balls) {
-                if (ball == other) continue;
-                double dx = other->getCenter()->get_x() - ball->getCenter()->get_x();
-                double dy = other->getCenter()->get_y() - ball->getCenter()->get_y();
-                double distance = std::sqrt(dx * dx + dy * dy);
-                // Avoid division by zero (or extremely small distances) which can lead to huge forces.
-                if (distance < 1.0) distance = 1.0;
-                net_ax += G * other->getMass() * dx / (distance * distance * distance);
-                net_ay += G * other->getMass() * dy / (distance * distance * distance);
+        if (snapshots.acquire()) {
+            since_snapshot.restart();
+            // Show the awake and asleep counts, touching the title only when they change.
+            const Snapshot& published = snapshots.latest();
+            if (published.asleep != shown_asleep || published.size() != shown_size) {
+                shown_asleep = published.asleep;
+                shown_size = published.size();
+                window.setTitle("SFML window - awake: " + std::to_string(shown_size - shown_asleep)
+                                + ", asleep: " + std::to_string(shown_asleep));
             }
-            ball->setAcceleration(net_ax, net_ay);
         }
-
-        // Update physics and handle boundary collisions
-        for (auto& ball : balls) {
-            ball->update_physics(delta_time);
-
-            float left = boundaries->get_left_boundry();
-            float right = boundaries->get_right_boundry();
-            float top = boundaries->get_top_boundry();
-            float bottom = boundaries->get_bottom_boundry();
-
-            float x = ball->getCenter()->get_x();
-            float y = ball->getCenter()->get_y();
-            float r = ball->getRadius();
-
-            if (x - r < left) {
-                ball->setCenterX(left + r);
-                ball->setVelocity(-diminishing_factor * ball->getVelocity()->get_x(), ball->getVelocity()->get_y());
-            }
-            if (x + r > right) {
-                ball->setCenterX(right - r);
-                ball->setVelocity(-diminishing_factor * ball->getVelocity()->get_x(), ball->getVelocity()->get_y());
-            }
-            if (y + r > top) {
-                ball->setCenterY(top - r);
-                ball->setVelocity(ball->getVelocity()->get_x(), -diminishing_factor * ball->getVelocity()->get_y());
-            }
-            if (y - r < bottom) {
-                ball->setCenterY(bottom + r);
-                ball->setVelocity(ball->getVelocity()->get_x(), -diminishing_factor * ball->getVelocity()->get_y());
-            }
+        const Snapshot& latest = snapshots.latest();
+        const Snapshot& previous = snapshots.previous();
+        double alpha = 1.0;
+        double span = latest.time - previous.time;
+        if (interpolate && span > 0.0 && previous.size() == latest.size()) {
+            alpha = std::min(1.0, since_snapshot.getElapsedTime().asSeconds() / span);
         }
 
-        // Handle collisions between balls
-        for (size_t i = 0; i < balls.size(); ++i) {
-            for (size_t j = i + 1; j < balls.size(); ++j) {
-                handle_ball_collision(balls[i], balls[j]);
-            }
+        {
+            PROFILE_SCOPE("render_update");
+            ball_renderer.update(latest, previous, alpha);
         }
-
-        window.clear(sf::Color::Black);
-        window.draw(*x_axis->to_vertex_array());
-        window.draw(*y_axis->to_vertex_array());
-        window.draw(*boundaries->to_convex_shape(sf::Color::Transparent, sf::Color::White, 3.0));
-
-        // Draw balls
-        for (const auto& ball : balls) {
-            window.draw(*ball->to_circle_shape(sf::Color::White));
+        {
+            PROFILE_SCOPE("draw");
+            window.clear(sf::Color::Black);
+            window.draw(*x_axis_vertices);
+            window.draw(*y_axis_vertices);
+            window.draw(*boundaries_shape);
+            window.draw(obstacle_vertices);
+
+            // Draw balls
+            ball_renderer.draw(window);
+        }
+        {
+            PROFILE_SCOPE("display");
+            window.display();
+        }
+    }
+    physics_thread.stop();
+    if (player != nullptr) player->stop();
+    if (recorder != nullptr) {
+        try {
+            recorder->close();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
         }
-
-        window.display();
     }
 
     return 0;
@@ -189,4 +236,5 @@ int main() {
 // to run:
 // cmake -S . -B build
 // cmake --build build
-// ./build/PhysicsSimulator
\ No newline at end of file
+// ./build/PhysicsSimulator
+// ./build/PhysicsSimulator --headless --bodies 5000 --steps 200
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "BarnesHut.h"
+#include <algorithm>
+#include "Profiler.h"
+
+int QuadTree::add_node(const double center_x, const double center_y, const double half_size) {
+    Node node;
+    node.center_x = center_x;
+    node.center_y = center_y;
+    node.half_size = half_size;
+    node.mass = 0.0;
+    node.com_x = 0.0;
+    node.com_y = 0.0;
+    node.first_child = -1;
+    node.first_body = -1;
+    nodes.push_back(node);
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+int QuadTree::child_for(const Node& node, const double x, const double y) const {
+    int quadrant = (x >= node.center_x ? 1 : 0) + (y >= node.center_y ? 2 : 0);
+    return node.first_child + quadrant;
+}
+
+void QuadTree::subdivide(const int node) {
+    // Copy the values out, add_node may reallocate the node storage.
+    const double cx = nodes[node].center_x;
+    const double cy = nodes[node].center_y;
+    const double quarter = nodes[node].half_size * 0.5;
+
+    int first = add_node(cx - quarter, cy - quarter, quarter);
+    add_node(cx + quarter, cy - quarter, quarter);
+    add_node(cx - quarter, cy + quarter, quarter);
+    add_node(cx + quarter, cy + quarter, quarter);
+    nodes[node].first_child = first;
+}
+
+void QuadTree::insert(const ParticleSystem& particles, const int body) {
+    const double x = particles.x[body];
+    const double y = particles.y[body];
+    int node = 0;
+    int depth = 0;
+
+    while (true) {
+        if (nodes[node].first_child >= 0) {
+            node = child_for(nodes[node], x, y);
+            ++depth;
+            continue;
+        }
+        if (nodes[node].first_body < 0) {
+            nodes[node].first_body = body;
+            next_body[body] = -1;
+            return;
+        }
+        if (depth >= MAX_DEPTH) {
+            // (Nearly) coincident particles: chain them in this leaf.
+            next_body[body] = nodes[node].first_body;
+            nodes[node].first_body = body;
+            return;
+        }
+
+        // An occupied leaf above the depth limit holds exactly one particle: push it one level down.
+        int resident = nodes[node].first_body;
+        nodes[node].first_body = -1;
+        subdivide(node);
+        int child = child_for(nodes[node], particles.x[resident], particles.y[resident]);
+        nodes[child].first_body = resident;
+        next_body[resident] = -1;
+    }
+}
+
+void QuadTree::aggregate(const ParticleSystem& particles) {
+    // Children are always created after their parent, so a reverse sweep visits them first.
+    for (int i = static_cast<int>(nodes.size()) - 1; i >= 0; --i) {
+        Node& node = nodes[i];
+        double mass = 0.0;
+        double mx = 0.0;
+        double my = 0.0;
+
+        if (node.first_child < 0) {
+            for (int body = node.first_body; body >= 0; body = next_body[body]) {
+                mass += particles.mass[body];
+                mx += particles.mass[body] * particles.x[body];
+                my += particles.mass[body] * particles.y[body];
+            }
+        } else {
+            for (int c = node.first_child; c < node.first_child + 4; ++c) {
+                mass += nodes[c].mass;
+                mx += nodes[c].mass * nodes[c].com_x;
+                my += nodes[c].mass * nodes[c].com_y;
+            }
+        }
+
+        node.mass = mass;
+        if (mass != 0.0) {
+            node.com_x = mx / mass;
+            node.com_y = my / mass;
+        } else {
+            node.com_x = node.center_x;
+            node.com_y = node.center_y;
+        }
+    }
+}
+
+void QuadTree::build(const ParticleSystem& particles) {
+    const std::size_t n = particles.size();
+    nodes.clear();
+    next_body.assign(n, -1);
+
+    double min_x = 0.0, max_x = 0.0, min_y = 0.0, max_y = 0.0;
+    if (n > 0) {
+        min_x = max_x = particles.x[0];
+        min_y = max_y = particles.y[0];
+    }
+    for (std::size_t i = 1; i < n; ++i) {
+        min_x = std::min(min_x, particles.x[i]);
+        max_x = std::max(max_x, particles.x[i]);
+        min_y = std::min(min_y, particles.y[i]);
+        max_y = std::max(max_y, particles.y[i]);
+    }
+    // Pad the root a little so particles on the far edge still fall strictly inside it.
+    double half_size = 0.5 * std::max(max_x - min_x, max_y - min_y) * (1.0 + 1e-6) + 1.0;
+    add_node(0.5 * (min_x + max_x), 0.5 * (min_y + max_y), half_size);
+
+    for (std::size_t i = 0; i < n; ++i) {
+        insert(particles, static_cast<int>(i));
+    }
+    aggregate(particles);
+}
+
+const std::vector<QuadTree::Node>& QuadTree::get_nodes() const {
+    return nodes;
+}
+
+const std::vector<int>& QuadTree::get_next_body() const {
+    return next_body;
+}
+
+
+BarnesHutGravity::BarnesHutGravity(const double G, const double theta, std::shared_ptr<ThreadPool> pool)
+    : GravitySolver(G), theta(theta), pool(pool) {}
+
+double BarnesHutGravity::getTheta() const {
+    return theta;
+}
+
+void BarnesHutGravity::setTheta(const double theta) {
+    this->theta = theta;
+}
+
+const QuadTree& BarnesHutGravity::get_tree() const {
+    return tree;
+}
+
+void BarnesHutGravity::compute(ParticleSystem& particles) {
+    PROFILE_SCOPE("gravity");
+    const std::size_t n = particles.size();
+    if (n == 0) return;
+
+    {
+        PROFILE_SCOPE("tree_build");
+        tree.build(particles);
+    }
+    if (pool == nullptr || pool->size() == 1) {
+        stacks.resize(1);
+        accumulate(particles, 0, n, stacks[0]);
+        return;
+    }
+
+    stacks.resize(pool->size());
+    std::size_t chunk = std::max<std::size_t>(64, n / (pool->size() * 8));
+    pool->parallel_for(n, chunk, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+        accumulate(particles, begin, end, stacks[worker]);
+    });
+}
+
+void BarnesHutGravity::compute_targets(ParticleSystem& particles, const std::vector<std::uint32_t>& targets) {
+    PROFILE_SCOPE("gravity");
+    if (targets.empty()) return;
+
+    // Building the tree costs about as much as twenty direct sums, so a handful of targets is summed directly.
+    if (targets.size() <= DIRECT_SUM_TARGETS) {
+        for (std::uint32_t i : targets) compute_gravity(particles, G, i, i + 1);
+        return;
+    }
+
+    {
+        PROFILE_SCOPE("tree_build");
+        tree.build(particles);
+    }
+    stacks.resize(pool == nullptr ? 1 : pool->size());
+    if (pool == nullptr || pool->size() == 1) {
+        for (std::uint32_t i : targets) accumulate(particles, i, i + 1, stacks[0]);
+        return;
+    }
+    std::size_t chunk = std::max<std::size_t>(64, targets.size() / (pool->size() * 8));
+    pool->parallel_for(targets.size(), chunk, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+        for (std::size_t k = begin; k < end; ++k) {
+            accumulate(particles, targets[k], targets[k] + 1, stacks[worker]);
+        }
+    });
+}
+
+void BarnesHutGravity::accumulate(ParticleSystem& particles, const std::size_t begin, const std::size_t end, std::vector<int>& stack) const {
+    const std::vector<QuadTree::Node>& nodes = tree.get_nodes();
+    const std::vector<int>& next_body = tree.get_next_body();
+    const double theta_squared = theta * theta;
+
+    for (std::size_t i = begin; i < end; ++i) {
+        const double xi = particles.x[i];
+        const double yi = particles.y[i];
+        double net_ax = 0.0;
+        double net_ay = 0.0;
+
+        stack.clear();
+        stack.push_back(0);
+        while (!stack.empty()) {
+            const QuadTree::Node& node = nodes[stack.back()];
+            stack.pop_back();
+            if (node.mass == 0.0) continue;
+
+            if (node.first_child < 0) {
+                for (int j = node.first_body; j >= 0; j = next_body[j]) {
+                    if (static_cast<std::size_t>(j) == i) continue;
+                    double dx = particles.x[j] - xi;
+                    double dy = particles.y[j] - yi;
+                    double distance = std::sqrt(dx * dx + dy * dy);
+                    if (distance < 1.0) distance = 1.0;
+                    net_ax += G * particles.mass[j] * dx / (distance * distance * distance);
+                    net_ay += G * particles.mass[j] * dy / (distance * distance * distance);
+                }
+                continue;
+            }
+
+            double dx = node.com_x - xi;
+            double dy = node.com_y - yi;
+            double distance_squared = dx * dx + dy * dy;
+            double size = 2.0 * node.half_size;
+            if (size * size < theta_squared * distance_squared) {
+                // Far enough: treat the whole cell as one body at its center of mass.
+                double distance = std::sqrt(distance_squared);
+                if (distance < 1.0) distance = 1.0;
+                net_ax += G * node.mass * dx / (distance * distance * distance);
+                net_ay += G * node.mass * dy / (distance * distance * distance);
+            } else {
+                for (int c = node.first_child; c < node.first_child + 4; ++c) {
+                    stack.push_back(c);
+                }
+            }
+        }
+
+        particles.ax[i] = net_ax;
+        particles.ay[i] = net_ay;
+    }
+}
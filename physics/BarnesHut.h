@@ -0,0 +1,70 @@
+#ifndef BARNES_HUT_H
+#define BARNES_HUT_H
+
+#include "Gravity.h"
+
+// Quadtree over the particle positions. Every node stores the total mass and center of mass of the
+// particles below it. The node storage is kept between builds, so rebuilding every step does not allocate
+// once the tree has reached its working size.
+class QuadTree {
+    public:
+        // Below this depth coincident particles are chained in a single leaf instead of splitting forever.
+        static constexpr int MAX_DEPTH = 48;
+
+        struct Node {
+            double center_x;     // geometric center of the (square) cell
+            double center_y;
+            double half_size;
+            double mass;         // aggregated mass of the subtree
+            double com_x;        // aggregated center of mass of the subtree
+            double com_y;
+            int first_child;     // index of the first of four consecutive children, -1 for a leaf
+            int first_body;      // head of the particle list of a leaf, -1 if empty
+        };
+
+    private:
+        std::vector<Node> nodes;
+        std::vector<int> next_body;
+
+        int add_node(const double center_x, const double center_y, const double half_size);
+        int child_for(const Node& node, const double x, const double y) const;
+        void subdivide(const int node);
+        void insert(const ParticleSystem& particles, const int body);
+        void aggregate(const ParticleSystem& particles);
+
+    public:
+        void build(const ParticleSystem& particles);
+        const std::vector<Node>& get_nodes() const;
+        const std::vector<int>& get_next_body() const;
+};
+
+// Barnes-Hut approximation of the pairwise gravity sum in O(n log n).
+// A cell of width s at distance d from a particle is replaced by its center of mass when s / d < theta.
+// theta = 0 opens every cell and reproduces the brute-force sum; the usual trade-off is around 0.5.
+// With a thread pool the tree walks of the particles are split across its threads.
+class BarnesHutGravity : public GravitySolver {
+    public:
+        // compute_targets sums up to this many targets exactly instead of building the tree for them.
+        static constexpr std::size_t DIRECT_SUM_TARGETS = 16;
+
+    private:
+        double theta;
+        QuadTree tree;
+        std::shared_ptr<ThreadPool> pool;
+        std::vector<std::vector<int>> stacks;   // one traversal stack per thread
+
+        void accumulate(ParticleSystem& particles, const std::size_t begin, const std::size_t end, std::vector<int>& stack) const;
+
+    public:
+        BarnesHutGravity(const double G, const double theta = 0.5, std::shared_ptr<ThreadPool> pool = nullptr);
+        double getTheta() const;
+        void setTheta(const double theta);
+        const QuadTree& get_tree() const;
+        void compute(ParticleSystem& particles) override;
+        // The tree is still built over all particles, only the walks of the targets are done.
+        // Up to DIRECT_SUM_TARGETS targets are summed exactly instead.
+        void compute_targets(ParticleSystem& particles, const std::vector<std::uint32_t>& targets) override;
+};
+
+
+#endif // BARNES_HUT_H
@@ -0,0 +1,141 @@
+#include "BlockTimestep.h"
+
+BlockTimestepIntegrator::BlockTimestepIntegrator(const BlockTimestepSettings& settings) : settings(settings) {
+    // Levels are stored in a byte and ticks counted in 64 bits.
+    this->settings.max_level = std::max(0, std::min(settings.max_level, 30));
+}
+
+const BlockTimestepSettings& BlockTimestepIntegrator::get_settings() const {
+    return settings;
+}
+
+const char* BlockTimestepIntegrator::name() const {
+    return "block";
+}
+
+double BlockTimestepIntegrator::force_evaluations() const {
+    return last_body_count == 0 ? 0.0 : static_cast<double>(last_evaluated_bodies) / static_cast<double>(last_body_count);
+}
+
+const std::vector<std::size_t>& BlockTimestepIntegrator::get_level_counts() const {
+    return level_counts;
+}
+
+int BlockTimestepIntegrator::choose_level(const ParticleSystem& particles, const std::size_t i, const double delta_time,
+                                          const double body_step) const {
+    const double ax = particles.ax[i];
+    const double ay = particles.ay[i];
+    const double a = std::sqrt(ax * ax + ay * ay);
+    double h = delta_time;
+    if (a > 0.0) {
+        h = std::min(h, std::sqrt(2.0 * settings.eta * settings.softening / a));
+    }
+    if (has_last[i] && body_step > 0.0) {
+        const double jx = (ax - last_ax[i]) / body_step;
+        const double jy = (ay - last_ay[i]) / body_step;
+        const double j = std::sqrt(jx * jx + jy * jy);
+        if (j > 0.0) h = std::min(h, settings.eta * a / j);
+    }
+    int result = 0;
+    double step = delta_time;
+    while (result < settings.max_level && step > h) {
+        step *= 0.5;
+        ++result;
+    }
+    return result;
+}
+
+void BlockTimestepIntegrator::drift(ParticleSystem& particles, const double h) const {
+    const std::size_t n = particles.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        if (particles.asleep[i]) continue;
+        particles.x[i] += particles.vx[i] * h;
+        particles.y[i] += particles.vy[i] * h;
+    }
+}
+
+void BlockTimestepIntegrator::step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) {
+    const std::size_t n = particles.size();
+    const int max_level = settings.max_level;
+    const std::uint64_t total = std::uint64_t(1) << max_level;
+    const double tick = delta_time / static_cast<double>(total);
+    last_evaluated_bodies = 0;
+    last_body_count = n;
+
+    // A new or resized system starts from one full evaluation, placed by its acceleration alone.
+    if (level.size() != n) {
+        level.assign(n, 0);
+        last_ax.assign(n, 0.0);
+        last_ay.assign(n, 0.0);
+        has_last.assign(n, 0);
+        gravity.compute(particles);
+        last_evaluated_bodies += n;
+        for (std::size_t i = 0; i < n; ++i) {
+            level[i] = static_cast<std::uint8_t>(choose_level(particles, i, delta_time, 0.0));
+            last_ax[i] = particles.ax[i];
+            last_ay[i] = particles.ay[i];
+            has_last[i] = 1;
+        }
+    }
+
+    level_counts.assign(max_level + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (particles.asleep[i]) continue;
+        level[i] = static_cast<std::uint8_t>(std::min<int>(level[i], max_level));
+        ++level_counts[level[i]];
+        // Every block starts at the beginning of the step: opening half kick with the last acceleration.
+        const double h = std::ldexp(delta_time, -level[i]);
+        particles.vx[i] += 0.5 * h * particles.ax[i];
+        particles.vy[i] += 0.5 * h * particles.ay[i];
+    }
+
+    std::uint64_t t = 0;
+    while (t < total) {
+        // Jump straight to the next tick where some block ends, drifting everything over the gap.
+        std::uint64_t next = total;
+        for (int l = 0; l <= max_level; ++l) {
+            if (level_counts[l] == 0) continue;
+            const std::uint64_t stride = total >> l;
+            next = std::min(next, (t / stride + 1) * stride);
+        }
+        drift(particles, static_cast<double>(next - t) * tick);
+        t = next;
+
+        active.clear();
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!particles.asleep[i] && t % (total >> level[i]) == 0) active.push_back(static_cast<std::uint32_t>(i));
+        }
+        gravity.compute_targets(particles, active);
+        last_evaluated_bodies += active.size();
+
+        for (std::uint32_t i : active) {
+            const int current = level[i];
+            const double h = std::ldexp(delta_time, -current);
+            // Closing half kick of the block that ends here.
+            particles.vx[i] += 0.5 * h * particles.ax[i];
+            particles.vy[i] += 0.5 * h * particles.ay[i];
+
+            const int desired = choose_level(particles, i, delta_time, h);
+            last_ax[i] = particles.ax[i];
+            last_ay[i] = particles.ay[i];
+            has_last[i] = 1;
+
+            int chosen = current;
+            if (t == total || desired > current) {
+                chosen = desired;
+            } else if (desired < current && t % ((total >> current) * 2) == 0) {
+                chosen = current - 1;
+            }
+            --level_counts[current];
+            ++level_counts[chosen];
+            level[i] = static_cast<std::uint8_t>(chosen);
+
+            if (t < total) {
+                // Opening half kick of the next block.
+                const double next_h = std::ldexp(delta_time, -chosen);
+                particles.vx[i] += 0.5 * next_h * particles.ax[i];
+                particles.vy[i] += 0.5 * next_h * particles.ay[i];
+            }
+        }
+    }
+}
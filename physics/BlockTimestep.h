@@ -0,0 +1,48 @@
+#ifndef BLOCK_TIMESTEP_H
+#define BLOCK_TIMESTEP_H
+
+#include <cstdint>
+#include "Integrator.h"
+
+struct BlockTimestepSettings {
+    int max_level = 10;        // the smallest step is delta_time / 2^max_level
+    double eta = 0.03;         // accuracy parameter of the step criteria, smaller is more accurate
+    double softening = 1.0;    // length scale of the acceleration criterion, the clamp radius of the force law
+};
+
+// Hierarchical block timesteps: every body advances with its own step delta_time / 2^level, so one tight pair
+// no longer forces the whole system onto its small step. Each body runs kick-drift-kick leapfrog on its own
+// step. At every substep all awake bodies are drifted, but only the bodies whose step ends there have their
+// gravity recomputed and are kicked.
+//
+// The step of a body is the smaller of sqrt(2 eta softening / |a|) and eta |a| / |jerk|, with the jerk taken
+// from the change of the acceleration over the body's last step. A body may move to a smaller step at the end
+// of any of its steps, but to a larger one only one level at a time and only where the larger block starts,
+// so all steps stay nested and every body is synchronized again at the end of delta_time.
+class BlockTimestepIntegrator : public Integrator {
+    private:
+        BlockTimestepSettings settings;
+        std::vector<std::uint8_t> level;
+        std::vector<double> last_ax;        // acceleration at the previous evaluation, for the jerk
+        std::vector<double> last_ay;
+        std::vector<char> has_last;
+        std::vector<std::size_t> level_counts;
+        std::vector<std::uint32_t> active;
+        std::size_t last_evaluated_bodies = 0;
+        std::size_t last_body_count = 0;
+
+        int choose_level(const ParticleSystem& particles, const std::size_t i, const double delta_time, const double body_step) const;
+        void drift(ParticleSystem& particles, const double h) const;
+
+    public:
+        explicit BlockTimestepIntegrator(const BlockTimestepSettings& settings = BlockTimestepSettings());
+        const BlockTimestepSettings& get_settings() const;
+        const char* name() const override;
+        double force_evaluations() const override;
+        // Number of bodies on each level after the last step, level 0 being the full delta_time.
+        const std::vector<std::size_t>& get_level_counts() const;
+        void step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) override;
+};
+
+
+#endif // BLOCK_TIMESTEP_H
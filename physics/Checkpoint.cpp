@@ -0,0 +1,269 @@
+#include "Checkpoint.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include "MappedFile.h"
+#include "Profiler.h"
+
+namespace {
+
+const char MAGIC[8] = {'P', 'H', 'Y', 'S', 'C', 'K', 'P', 'T'};
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+const std::size_t ALIGNMENT = 64;
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t body_count;
+    std::uint64_t step_count;
+    double G;
+    double diminishing_factor;
+    double boundaries[8];
+    char reserved[16];
+};
+static_assert(sizeof(FileHeader) == 128, "the checkpoint header is 128 bytes");
+
+// The double arrays in file order; asleep follows them.
+std::vector<double> ParticleSystem::* const ARRAYS[8] = {
+    &ParticleSystem::x, &ParticleSystem::y, &ParticleSystem::vx, &ParticleSystem::vy,
+    &ParticleSystem::ax, &ParticleSystem::ay, &ParticleSystem::mass, &ParticleSystem::radius
+};
+
+std::size_t aligned(const std::size_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// Offsets of the 8 double arrays, then of the asleep array, then the file size.
+void array_offsets(const std::uint64_t n, std::size_t offsets[10]) {
+    std::size_t offset = sizeof(FileHeader);
+    for (int a = 0; a < 8; ++a) {
+        offsets[a] = aligned(offset);
+        offset = offsets[a] + n * sizeof(double);
+    }
+    offsets[8] = aligned(offset);
+    offsets[9] = offsets[8] + n;
+}
+
+const FileHeader& read_header(const MappedFile& file, const std::string& path) {
+    if (file.size() < sizeof(FileHeader) || std::memcmp(file.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(path + " is not a checkpoint");
+    }
+    const FileHeader& header = *reinterpret_cast<const FileHeader*>(file.data());
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error(path + " was written on a machine with another byte order");
+    }
+    if (header.version != Checkpoint::VERSION) {
+        throw std::runtime_error(path + " is a version " + std::to_string(header.version) + " checkpoint, expected version "
+                                 + std::to_string(Checkpoint::VERSION));
+    }
+    std::size_t offsets[10];
+    array_offsets(header.body_count, offsets);
+    if (file.size() < offsets[9]) {
+        throw std::runtime_error(path + " is truncated");
+    }
+    return header;
+}
+
+void read_particles(const MappedFile& file, const std::uint64_t n, ParticleSystem& particles) {
+    std::size_t offsets[10];
+    array_offsets(n, offsets);
+    for (int a = 0; a < 8; ++a) {
+        std::vector<double>& array = particles.*ARRAYS[a];
+        array.resize(n);
+        if (n > 0) std::memcpy(array.data(), file.data() + offsets[a], n * sizeof(double));
+    }
+    particles.asleep.resize(n);
+    if (n > 0) std::memcpy(particles.asleep.data(), file.data() + offsets[8], n);
+}
+
+// Applies everything but the particles.
+void restore_scalars(Simulation& simulation, const Checkpoint& checkpoint) {
+    simulation.set_boundaries(checkpoint.make_boundaries());
+    if (simulation.get_gravity() != nullptr) simulation.get_gravity()->setG(checkpoint.G);
+    simulation.set_diminishing_factor(checkpoint.diminishing_factor);
+    simulation.set_step_count(checkpoint.step_count);
+}
+
+} // namespace
+
+
+constexpr std::uint32_t Checkpoint::VERSION;
+
+void Checkpoint::capture(const Simulation& simulation) {
+    const ParticleSystem& source = simulation.get_particles();
+    for (int a = 0; a < 8; ++a) {
+        (particles.*ARRAYS[a]).assign((source.*ARRAYS[a]).begin(), (source.*ARRAYS[a]).end());
+    }
+    particles.asleep.assign(source.asleep.begin(), source.asleep.end());
+
+    std::shared_ptr<Rectangle> rectangle = simulation.get_boundaries();
+    const std::shared_ptr<Point> corners[4] = {rectangle->get_upper_left(), rectangle->get_upper_right(),
+                                               rectangle->get_lower_right(), rectangle->get_lower_left()};
+    for (int c = 0; c < 4; ++c) {
+        boundaries[2 * c] = corners[c]->get_x();
+        boundaries[2 * c + 1] = corners[c]->get_y();
+    }
+    G = simulation.get_gravity() != nullptr ? simulation.get_gravity()->getG() : 0.0;
+    diminishing_factor = simulation.get_diminishing_factor();
+    step_count = simulation.get_step_count();
+}
+
+void Checkpoint::restore(Simulation& simulation) const {
+    simulation.get_particles() = particles;
+    restore_scalars(simulation, *this);
+}
+
+std::shared_ptr<Rectangle> Checkpoint::make_boundaries() const {
+    return std::make_shared<Rectangle>(
+        std::make_shared<Point>(boundaries[0], boundaries[1]),
+        std::make_shared<Point>(boundaries[2], boundaries[3]),
+        std::make_shared<Point>(boundaries[4], boundaries[5]),
+        std::make_shared<Point>(boundaries[6], boundaries[7])
+    );
+}
+
+
+bool is_checkpoint(const char* data, const std::size_t size) {
+    return size >= sizeof(MAGIC) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+void save_checkpoint(const Checkpoint& checkpoint, const std::string& path) {
+    const ParticleSystem& particles = checkpoint.particles;
+    const std::uint64_t n = particles.size();
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = Checkpoint::VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.body_count = n;
+    header.step_count = checkpoint.step_count;
+    header.G = checkpoint.G;
+    header.diminishing_factor = checkpoint.diminishing_factor;
+    std::memcpy(header.boundaries, checkpoint.boundaries, sizeof(header.boundaries));
+
+    std::size_t offsets[10];
+    array_offsets(n, offsets);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Cannot write " + temporary);
+        }
+        const char padding[ALIGNMENT] = {};
+        std::size_t written = sizeof(header);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (int a = 0; a < 9; ++a) {
+            out.write(padding, static_cast<std::streamsize>(offsets[a] - written));
+            if (a < 8) {
+                out.write(reinterpret_cast<const char*>((particles.*ARRAYS[a]).data()), static_cast<std::streamsize>(n * sizeof(double)));
+            } else {
+                out.write(particles.asleep.data(), static_cast<std::streamsize>(n));
+            }
+            written = a < 8 ? offsets[a] + n * sizeof(double) : offsets[9];
+        }
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Cannot write " + temporary);
+        }
+    }
+#ifdef _WIN32
+    // rename does not replace an existing file on Windows.
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Cannot replace " + path);
+    }
+}
+
+Checkpoint load_checkpoint(const std::string& path) {
+    MappedFile file(path);
+    const FileHeader& header = read_header(file, path);
+    Checkpoint checkpoint;
+    read_particles(file, header.body_count, checkpoint.particles);
+    std::memcpy(checkpoint.boundaries, header.boundaries, sizeof(checkpoint.boundaries));
+    checkpoint.G = header.G;
+    checkpoint.diminishing_factor = header.diminishing_factor;
+    checkpoint.step_count = header.step_count;
+    return checkpoint;
+}
+
+void load_checkpoint(const std::string& path, Simulation& simulation) {
+    MappedFile file(path);
+    const FileHeader& header = read_header(file, path);
+    read_particles(file, header.body_count, simulation.get_particles());
+    Checkpoint scalars;
+    std::memcpy(scalars.boundaries, header.boundaries, sizeof(scalars.boundaries));
+    scalars.G = header.G;
+    scalars.diminishing_factor = header.diminishing_factor;
+    scalars.step_count = header.step_count;
+    restore_scalars(simulation, scalars);
+}
+
+
+CheckpointWriter::CheckpointWriter() : worker(&CheckpointWriter::run, this) {}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    worker.join();
+}
+
+bool CheckpointWriter::save(const Simulation& simulation, const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (has_pending || writing) return false;
+        // The writer thread only reads pending while writing is set, so it is safe to fill it here.
+        pending.capture(simulation);
+        pending_path = path;
+        has_pending = true;
+    }
+    changed.notify_all();
+    return true;
+}
+
+void CheckpointWriter::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [this]() { return !has_pending && !writing; });
+}
+
+std::uint64_t CheckpointWriter::get_saved_count() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return saved;
+}
+
+std::string CheckpointWriter::get_last_error() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return last_error;
+}
+
+void CheckpointWriter::run() {
+    Profiler::instance().set_thread_name("checkpoint writer");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this]() { return has_pending || stopping; });
+        // A queued checkpoint is still written on shutdown.
+        if (!has_pending) return;
+        has_pending = false;
+        writing = true;
+        lock.unlock();
+        std::string error;
+        try {
+            PROFILE_SCOPE("checkpoint_write");
+            save_checkpoint(pending, pending_path);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+        lock.lock();
+        writing = false;
+        if (error.empty()) {
+            ++saved;
+        } else {
+            last_error = error;
+        }
+        changed.notify_all();
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "Simulation.h"
+
+// The full state of a simulation, enough to resume it where it stopped: every particle array, the boundary
+// corners, G, the damping factor and the step count.
+//
+// On disk (version 1, native byte order, which the header records) it is a 128 byte header followed by the
+// x, y, vx, vy, ax, ay, mass and radius arrays of doubles and the asleep array of bytes, each starting on a
+// 64 byte boundary. The arrays are the in-memory layout of ParticleSystem, so a restore is one copy per array
+// straight out of the mapped file.
+struct Checkpoint {
+    static constexpr std::uint32_t VERSION = 1;
+
+    ParticleSystem particles;
+    // Upper left, upper right, lower right and lower left corner, x then y.
+    double boundaries[8] = {0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0};
+    double G = 0.0;                      // zero for a simulation without a gravity engine
+    double diminishing_factor = 0.0;
+    std::uint64_t step_count = 0;
+
+    // Copies the state out of the simulation, reusing this checkpoint's storage.
+    void capture(const Simulation& simulation);
+    // Puts the state into the simulation. The boundaries are replaced by a new Rectangle.
+    void restore(Simulation& simulation) const;
+    std::shared_ptr<Rectangle> make_boundaries() const;
+};
+
+// True if the bytes start with a checkpoint header, of any version.
+bool is_checkpoint(const char* data, const std::size_t size);
+// Writes the checkpoint to path + ".tmp" and renames it over path, so a crash mid-write never leaves a
+// truncated checkpoint behind. Throws std::runtime_error if the file cannot be written.
+void save_checkpoint(const Checkpoint& checkpoint, const std::string& path);
+// Maps the file and copies the arrays out. Throws std::runtime_error for a file that is not a checkpoint, has
+// another version or byte order, or is truncated.
+Checkpoint load_checkpoint(const std::string& path);
+// Same, but copies the arrays straight into the simulation and applies the rest of the state as restore does.
+void load_checkpoint(const std::string& path, Simulation& simulation);
+
+// Saves checkpoints on a background thread. save() only copies the state, which is a memcpy per array; the
+// file is written while the simulation keeps stepping.
+class CheckpointWriter {
+    private:
+        Checkpoint pending;
+        std::string pending_path;
+        bool has_pending = false;
+        bool writing = false;
+        bool stopping = false;
+        std::uint64_t saved = 0;
+        std::string last_error;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::thread worker;
+
+        void run();
+
+    public:
+        CheckpointWriter();
+        // Finishes the save in flight before returning.
+        ~CheckpointWriter();
+        CheckpointWriter(const CheckpointWriter&) = delete;
+        CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+        // Captures the simulation and queues it for writing. Returns false, and captures nothing, while the
+        // previous checkpoint is still being written: the step loop never waits on the disk.
+        bool save(const Simulation& simulation, const std::string& path);
+        // Blocks until every queued checkpoint is on disk.
+        void wait();
+        std::uint64_t get_saved_count();
+        // The error of the last failed save, empty if none failed.
+        std::string get_last_error();
+};
+
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,278 @@
+#include "Collision.h"
+#include <algorithm>
+#include "Profiler.h"
+
+bool handle_ball_collision(ParticleSystem& particles, const std::size_t a, const std::size_t b) {
+    double dx = particles.x[b] - particles.x[a];
+    double dy = particles.y[b] - particles.y[a];
+    double distance_squared = dx * dx + dy * dy;
+    double min_dist = particles.radius[a] + particles.radius[b];
+
+    // Reject separated pairs before paying for the square root.
+    if (distance_squared >= min_dist * min_dist || distance_squared <= 0.0) {
+        return false;
+    }
+
+    double distance = std::sqrt(distance_squared);
+    double nx = dx / distance;
+    double ny = dy / distance;
+    double overlap = 0.5 * (min_dist - distance);
+
+    // Displace balls to prevent overlap
+    particles.x[a] -= overlap * nx;
+    particles.y[a] -= overlap * ny;
+    particles.x[b] += overlap * nx;
+    particles.y[b] += overlap * ny;
+
+    // Simple elastic collision response (equal mass assumption)
+    double p = (particles.vx[a] - particles.vx[b]) * nx + (particles.vy[a] - particles.vy[b]) * ny;
+
+    particles.vx[a] -= p * nx;
+    particles.vy[a] -= p * ny;
+    particles.vx[b] += p * nx;
+    particles.vy[b] += p * ny;
+    return true;
+}
+
+bool handle_ball_collision(std::shared_ptr<Circle> a, std::shared_ptr<Circle> b) {
+    auto dx = b->getCenter()->get_x() - a->getCenter()->get_x();
+    auto dy = b->getCenter()->get_y() - a->getCenter()->get_y();
+    double distance = std::sqrt(dx * dx + dy * dy);
+    double min_dist = a->getRadius() + b->getRadius();
+
+    if (distance < min_dist && distance > 0.0) { // Ensure actual overlap and avoid division by zero
+        double overlap = 0.5 * (min_dist - distance);
+
+        // Displace balls to prevent overlap
+        a->setCenterX(a->getCenter()->get_x() - overlap * (dx / distance));
+        a->setCenterY(a->getCenter()->get_y() - overlap * (dy / distance));
+        b->setCenterX(b->getCenter()->get_x() + overlap * (dx / distance));
+        b->setCenterY(b->getCenter()->get_y() + overlap * (dy / distance));
+
+        // Simple elastic collision response (equal mass assumption)
+        auto va = a->getVelocity();
+        auto vb = b->getVelocity();
+
+        double nx = dx / distance;
+        double ny = dy / distance;
+
+        double p = 2 * (va->get_x() * nx + va->get_y() * ny - vb->get_x() * nx - vb->get_y() * ny) / 2;
+
+        a->setVelocity(va->get_x() - p * nx, va->get_y() - p * ny);
+        b->setVelocity(vb->get_x() + p * nx, vb->get_y() + p * ny);
+        return true;
+    }
+    return false;
+}
+
+CollisionStats resolve_collisions(ParticleSystem& particles) {
+    CollisionStats stats;
+    const std::size_t n = particles.size();
+    for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = i + 1; j < n; ++j) {
+            if (handle_ball_collision(particles, i, j)) ++stats.contacts;
+        }
+    }
+    stats.candidate_pairs = n * (n - (n > 0 ? 1 : 0)) / 2;
+    return stats;
+}
+
+CollisionStats resolve_collisions(ParticleSystem& particles, SpatialGrid& grid) {
+    CollisionStats stats;
+    {
+        PROFILE_SCOPE("broadphase");
+        grid.build(particles);
+    }
+    PROFILE_SCOPE("narrowphase");
+    const std::vector<CandidatePair>& pairs = grid.get_pairs();
+    for (const CandidatePair& pair : pairs) {
+        if (handle_ball_collision(particles, pair.a, pair.b)) ++stats.contacts;
+    }
+    stats.candidate_pairs = pairs.size();
+    return stats;
+}
+
+CollisionStats resolve_collisions(ParticleSystem& particles, SpatialGrid& grid, SleepSystem& sleep) {
+    CollisionStats stats;
+    {
+        PROFILE_SCOPE("broadphase");
+        grid.build(particles);
+    }
+    PROFILE_SCOPE("narrowphase");
+    const std::vector<CandidatePair>& pairs = grid.get_pairs();
+    const char* asleep = particles.asleep.data();
+    for (const CandidatePair& pair : pairs) {
+        if (asleep[pair.a] && asleep[pair.b]) continue;
+        ++stats.candidate_pairs;
+        if (handle_ball_collision(particles, pair.a, pair.b)) {
+            ++stats.contacts;
+            if (asleep[pair.a]) sleep.wake(particles, pair.a);
+            if (asleep[pair.b]) sleep.wake(particles, pair.b);
+        }
+    }
+    return stats;
+}
+
+constexpr std::size_t ContactSolver::MAX_COLORS;
+constexpr std::size_t ContactSolver::CONTACT_BLOCK;
+
+ContactSolver::ContactSolver(std::shared_ptr<ThreadPool> pool) : pool(pool) {}
+
+template <typename Skip>
+std::size_t ContactSolver::find_contacts(const ParticleSystem& particles, const std::vector<CandidatePair>& pairs, Skip skip) {
+    // The pairs are tested in fixed blocks, each compacting its contacts to the front of its own range of the
+    // contact array. Read back block by block, the contacts are in grid order for any number of threads, and so is
+    // the coloring.
+    const double* x = particles.x.data();
+    const double* y = particles.y.data();
+    const double* radius = particles.radius.data();
+    const std::size_t block_count = (pairs.size() + CONTACT_BLOCK - 1) / CONTACT_BLOCK;
+    contacts.resize(pairs.size());
+    block_contacts.resize(block_count);
+    block_candidates.resize(block_count);
+    auto test = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t block = begin; block < end; ++block) {
+            const std::size_t first = block * CONTACT_BLOCK;
+            const std::size_t last = std::min(first + CONTACT_BLOCK, pairs.size());
+            std::size_t found = first;
+            std::size_t candidates = 0;
+            for (std::size_t k = first; k < last; ++k) {
+                const std::uint32_t a = pairs[k].a;
+                const std::uint32_t b = pairs[k].b;
+                if (skip(a, b)) continue;
+                ++candidates;
+                double dx = x[b] - x[a];
+                double dy = y[b] - y[a];
+                double distance_squared = dx * dx + dy * dy;
+                double min_dist = radius[a] + radius[b];
+                // Branch-free: about half the candidate pairs of a pile touch, which no predictor guesses.
+                contacts[found] = pairs[k];
+                found += distance_squared < min_dist * min_dist && distance_squared > 0.0;
+            }
+            block_contacts[block] = static_cast<std::uint32_t>(found - first);
+            block_candidates[block] = static_cast<std::uint32_t>(candidates);
+        }
+    };
+    pool->parallel_for(block_count, std::max<std::size_t>(1, block_count / (pool->size() * 8)), test);
+
+    std::size_t candidates = 0;
+    for (std::uint32_t count : block_candidates) candidates += count;
+    return candidates;
+}
+
+void ContactSolver::color_contacts(const std::size_t ball_count) {
+    PROFILE_SCOPE("contact_coloring");
+    // Greedy: every contact takes the lowest color neither of its balls has yet. A ball in d contacts needs at
+    // most 2d - 1 colors, a handful for a pile of similar balls.
+    used_colors.assign(ball_count, 0);
+    contact_color.resize(contacts.size());
+    color_start.assign(MAX_COLORS + 2, 0);
+    for (std::size_t block = 0; block < block_contacts.size(); ++block) {
+        const std::size_t first = block * CONTACT_BLOCK;
+        for (std::size_t k = first; k < first + block_contacts[block]; ++k) {
+            std::uint64_t& used_a = used_colors[contacts[k].a];
+            std::uint64_t& used_b = used_colors[contacts[k].b];
+            const std::uint64_t used = used_a | used_b;
+            std::size_t color = MAX_COLORS;
+            if (~used != 0) {
+#if defined(__GNUC__)
+                color = static_cast<std::size_t>(__builtin_ctzll(~used));
+#else
+                for (color = 0; (used >> color & 1) != 0; ++color) {}
+#endif
+            }
+            if (color < MAX_COLORS) {
+                used_a |= std::uint64_t(1) << color;
+                used_b |= std::uint64_t(1) << color;
+            }
+            contact_color[k] = static_cast<std::uint8_t>(color);
+            ++color_start[color + 1];
+        }
+    }
+
+    // Counting sort of the contacts by color.
+    color_count = 0;
+    for (std::size_t color = 0; color <= MAX_COLORS; ++color) {
+        if (color_start[color + 1] != 0) color_count = color + 1;
+        color_start[color + 1] += color_start[color];
+    }
+    ordered.resize(color_start[MAX_COLORS + 1]);
+    color_fill.assign(color_start.begin(), color_start.end() - 1);
+    for (std::size_t block = 0; block < block_contacts.size(); ++block) {
+        const std::size_t first = block * CONTACT_BLOCK;
+        for (std::size_t k = first; k < first + block_contacts[block]; ++k) {
+            ordered[color_fill[contact_color[k]]++] = contacts[k];
+        }
+    }
+}
+
+std::size_t ContactSolver::resolve_colors(ParticleSystem& particles) {
+    // No two contacts of a color share a ball, so each one owns the positions and velocities it writes.
+    touched.assign(ordered.size(), 0);
+    auto resolve = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t k = begin; k < end; ++k) {
+            touched[k] = handle_ball_collision(particles, ordered[k].a, ordered[k].b) ? 1 : 0;
+        }
+    };
+    // A batch this small costs less than waking the pool.
+    const std::size_t min_parallel = 2048;
+    for (std::size_t color = 0; color < MAX_COLORS; ++color) {
+        const std::size_t first = color_start[color];
+        const std::size_t count = color_start[color + 1] - first;
+        if (count < min_parallel) {
+            resolve(first, first + count);
+            continue;
+        }
+        std::size_t chunk = std::max<std::size_t>(512, count / (pool->size() * 8));
+        pool->parallel_for(count, chunk, [&](std::size_t begin, std::size_t end, std::size_t) {
+            resolve(first + begin, first + end);
+        });
+    }
+    // The contacts of balls that ran out of colors, if any.
+    resolve(color_start[MAX_COLORS], color_start[MAX_COLORS + 1]);
+
+    std::size_t resolved = 0;
+    for (char hit : touched) resolved += static_cast<std::size_t>(hit);
+    return resolved;
+}
+
+CollisionStats ContactSolver::resolve(ParticleSystem& particles, SpatialGrid& grid) {
+    if (pool == nullptr || pool->size() == 1) return resolve_collisions(particles, grid);
+    CollisionStats stats;
+    {
+        PROFILE_SCOPE("broadphase");
+        grid.build(particles);
+    }
+    PROFILE_SCOPE("narrowphase");
+    stats.candidate_pairs = find_contacts(particles, grid.get_pairs(), [](std::uint32_t, std::uint32_t) { return false; });
+    color_contacts(particles.size());
+    stats.contacts = resolve_colors(particles);
+    return stats;
+}
+
+CollisionStats ContactSolver::resolve(ParticleSystem& particles, SpatialGrid& grid, SleepSystem& sleep) {
+    if (pool == nullptr || pool->size() == 1) return resolve_collisions(particles, grid, sleep);
+    CollisionStats stats;
+    {
+        PROFILE_SCOPE("broadphase");
+        grid.build(particles);
+    }
+    PROFILE_SCOPE("narrowphase");
+    const char* asleep = particles.asleep.data();
+    stats.candidate_pairs = find_contacts(particles, grid.get_pairs(), [asleep](std::uint32_t a, std::uint32_t b) {
+        return asleep[a] && asleep[b];
+    });
+    color_contacts(particles.size());
+    stats.contacts = resolve_colors(particles);
+    // Waking touches whole islands, so it waits until every color is done.
+    for (std::size_t k = 0; k < ordered.size(); ++k) {
+        if (!touched[k]) continue;
+        if (asleep[ordered[k].a]) sleep.wake(particles, ordered[k].a);
+        if (asleep[ordered[k].b]) sleep.wake(particles, ordered[k].b);
+    }
+    return stats;
+}
+
+std::size_t ContactSolver::get_color_count() const {
+    return color_count;
+}
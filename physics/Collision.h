@@ -0,0 +1,75 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <memory>
+#include "ParticleSystem.h"
+#include "SpatialGrid.h"
+#include "Sleep.h"
+#include "ThreadPool.h"
+
+// Per-frame counters of the collision pass: how many pairs reached the narrowphase and how many touched.
+struct CollisionStats {
+    std::size_t candidate_pairs = 0;
+    std::size_t contacts = 0;
+};
+
+// Separates two overlapping balls and applies a simple elastic response (equal mass assumption).
+// Returns true if the balls were in contact.
+bool handle_ball_collision(ParticleSystem& particles, const std::size_t a, const std::size_t b);
+bool handle_ball_collision(std::shared_ptr<Circle> a, std::shared_ptr<Circle> b);
+
+// Runs the narrowphase over every i < j pair of the system.
+CollisionStats resolve_collisions(ParticleSystem& particles);
+// Rebuilds the grid and runs the narrowphase only over the candidate pairs from neighboring cells.
+CollisionStats resolve_collisions(ParticleSystem& particles, SpatialGrid& grid);
+// Same, but pairs of sleeping balls are skipped, and a sleeping ball touched by an awake one is woken
+// together with its island.
+CollisionStats resolve_collisions(ParticleSystem& particles, SpatialGrid& grid, SleepSystem& sleep);
+
+// Resolves the contacts of a frame on several threads without locks. The candidate pairs that overlap are
+// collected, then colored greedily so that no two contacts of one color share a ball; the colors are resolved
+// one after the other, the contacts of a color in parallel. The result does not depend on the number of threads,
+// but differs from the serial pass, which resolves the pairs in grid order and also catches pairs pushed into
+// contact during the pass (those wait for the next frame here). Without a pool, or with a single thread, it
+// falls back to the serial pass.
+class ContactSolver {
+    public:
+        // A ball in more contacts than this (never the case for balls of similar size) sends the contacts past
+        // the limit to one extra batch, resolved serially after the colors.
+        static constexpr std::size_t MAX_COLORS = 64;
+
+    private:
+        // Candidate pairs tested by one task; each block keeps its contacts at the front of its own range.
+        static constexpr std::size_t CONTACT_BLOCK = 4096;
+
+        std::shared_ptr<ThreadPool> pool;
+        std::vector<CandidatePair> contacts;          // one slot per candidate pair
+        std::vector<std::uint32_t> block_contacts;
+        std::vector<std::uint32_t> block_candidates;
+        std::vector<std::uint64_t> used_colors;       // per ball, bit c set once a contact of color c touches it
+        std::vector<std::uint8_t> contact_color;      // per slot of contacts
+        std::vector<CandidatePair> ordered;           // contacts grouped by color
+        std::vector<std::uint32_t> color_start;       // prefix sums, MAX_COLORS + 2 entries
+        std::vector<std::uint32_t> color_fill;
+        std::vector<char> touched;                    // per ordered contact, whether it was still in contact
+        std::size_t color_count = 0;
+
+        // Collects the pairs that overlap, skipping the ones for which skip(a, b) is true. Returns the
+        // number of pairs not skipped.
+        template <typename Skip>
+        std::size_t find_contacts(const ParticleSystem& particles, const std::vector<CandidatePair>& pairs, Skip skip);
+        void color_contacts(const std::size_t ball_count);
+        std::size_t resolve_colors(ParticleSystem& particles);
+
+    public:
+        explicit ContactSolver(std::shared_ptr<ThreadPool> pool = nullptr);
+
+        // Same contract as resolve_collisions with a grid, and with a grid and a sleep system.
+        CollisionStats resolve(ParticleSystem& particles, SpatialGrid& grid);
+        CollisionStats resolve(ParticleSystem& particles, SpatialGrid& grid, SleepSystem& sleep);
+        // Colors used by the last parallel pass, the serial overflow batch included.
+        std::size_t get_color_count() const;
+};
+
+
+#endif // COLLISION_H
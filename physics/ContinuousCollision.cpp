@@ -0,0 +1,208 @@
+#include "ContinuousCollision.h"
+#include <algorithm>
+
+ContinuousCollision::ContinuousCollision(const ContinuousCollisionSettings& settings) : settings(settings) {}
+
+const ContinuousCollisionSettings& ContinuousCollision::get_settings() const {
+    return settings;
+}
+
+void ContinuousCollision::set_settings(const ContinuousCollisionSettings& settings) {
+    this->settings = settings;
+}
+
+const ContinuousCollisionStats& ContinuousCollision::get_stats() const {
+    return stats;
+}
+
+void ContinuousCollision::begin_step(const ParticleSystem& particles) {
+    start_x.assign(particles.x.begin(), particles.x.end());
+    start_y.assign(particles.y.begin(), particles.y.end());
+}
+
+bool ContinuousCollision::ball_impact(const ParticleSystem& particles, const std::uint32_t a, const std::uint32_t b, double& t) const {
+    const double rx = start_x[b] - start_x[a];
+    const double ry = start_y[b] - start_y[a];
+    const double drx = (particles.x[b] - start_x[b]) - (particles.x[a] - start_x[a]);
+    const double dry = (particles.y[b] - start_y[b]) - (particles.y[a] - start_y[a]);
+    const double qa = drx * drx + dry * dry;
+    if (qa <= Shape::EPSILON_ERROR) return false;
+    const double min_dist = particles.radius[a] + particles.radius[b];
+    double roots[2];
+    // One root is a graze, no root a miss. The balls overlap between the roots, so the first one is the impact,
+    // provided both balls are already on their paths by then; otherwise they overlapped before and the discrete
+    // pass has to separate them.
+    if (Shape::solve_quadratic(qa, 2.0 * (rx * drx + ry * dry), rx * rx + ry * ry - min_dist * min_dist, roots) < 2) return false;
+    const double first = std::min(roots[0], roots[1]);
+    if (first <= std::max(from[a], from[b]) || first > 1.0) return false;
+    t = first;
+    return true;
+}
+
+void ContinuousCollision::add_swept(const std::uint32_t i) {
+    swept[i] = 1;
+    active[i] = 1;
+    swept_balls.push_back(i);
+    earliest.push_back({2.0, i, i, NO_WALL});
+}
+
+void ContinuousCollision::find_impacts(const ParticleSystem& particles, const std::shared_ptr<Rectangle> boundaries) {
+    const double left = boundaries->get_left_boundry();
+    const double right = boundaries->get_right_boundry();
+    const double top = boundaries->get_top_boundry();
+    const double bottom = boundaries->get_bottom_boundry();
+    // The balls outside the swept set have not moved since they were binned, and end the step within fast_fraction
+    // of their radius of every point of their path.
+    const double slow_margin = particles.max_radius() * (1.0 + settings.fast_fraction);
+    impacts.clear();
+    boxes.clear();
+
+    // Against the walls and the balls outside the swept set, found in the grid around the path.
+    for (std::size_t slot = 0; slot < swept_balls.size(); ++slot) {
+        const std::uint32_t a = swept_balls[slot];
+        const double r = particles.radius[a];
+        const double dx = particles.x[a] - start_x[a];
+        const double dy = particles.y[a] - start_y[a];
+        const double path_x = start_x[a] + from[a] * dx;
+        const double path_y = start_y[a] + from[a] * dy;
+        const double min_x = std::min(path_x, particles.x[a]) - r;
+        const double max_x = std::max(path_x, particles.x[a]) + r;
+        const double min_y = std::min(path_y, particles.y[a]) - r;
+        const double max_y = std::max(path_y, particles.y[a]) + r;
+        boxes.push_back({min_x, max_x, min_y, max_y, static_cast<std::uint32_t>(slot)});
+        if (!active[a]) continue;
+
+        Impact& first = earliest[slot];
+        first = {2.0, a, a, NO_WALL};
+        auto wall = [&](const double t, const int side) {
+            if (t > from[a] && t <= 1.0 && t < first.t) first = {t, a, a, side};
+        };
+        if (dx < 0.0) wall((left + r - start_x[a]) / dx, LEFT);
+        if (dx > 0.0) wall((right - r - start_x[a]) / dx, RIGHT);
+        if (dy > 0.0) wall((top - r - start_y[a]) / dy, TOP);
+        if (dy < 0.0) wall((bottom + r - start_y[a]) / dy, BOTTOM);
+
+        found.clear();
+        grid.query(min_x - slow_margin, min_y - slow_margin, max_x + slow_margin, max_y + slow_margin, found);
+        for (std::uint32_t b : found) {
+            double t;
+            if (!swept[b] && ball_impact(particles, a, b, t) && t < first.t) first = {t, a, b, NO_WALL};
+        }
+    }
+
+    // Swept against swept: sweep and prune over the path boxes along x. Two inactive balls had no impact on these
+    // same paths in the last pass.
+    std::sort(boxes.begin(), boxes.end(), [](const SweptBox& p, const SweptBox& q) {
+        return p.min_x < q.min_x || (p.min_x == q.min_x && p.slot < q.slot);
+    });
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+        for (std::size_t j = i + 1; j < boxes.size() && boxes[j].min_x <= boxes[i].max_x; ++j) {
+            if (boxes[j].min_y > boxes[i].max_y || boxes[j].max_y < boxes[i].min_y) continue;
+            const std::uint32_t a = swept_balls[boxes[i].slot];
+            const std::uint32_t b = swept_balls[boxes[j].slot];
+            double t;
+            if ((!active[a] && !active[b]) || !ball_impact(particles, a, b, t)) continue;
+            if (active[a] && t < earliest[boxes[i].slot].t) earliest[boxes[i].slot] = {t, a, b, NO_WALL};
+            if (active[b] && t < earliest[boxes[j].slot].t) earliest[boxes[j].slot] = {t, b, a, NO_WALL};
+        }
+    }
+
+    for (std::size_t slot = 0; slot < swept_balls.size(); ++slot) {
+        const std::uint32_t a = swept_balls[slot];
+        if (active[a] && earliest[slot].t <= 1.0) impacts.push_back(earliest[slot]);
+        active[a] = 0;
+    }
+}
+
+void ContinuousCollision::restart_path(ParticleSystem& particles, const std::size_t i, const double x, const double y,
+                                       const double t, const double delta_time) {
+    particles.x[i] = x + particles.vx[i] * (1.0 - t) * delta_time;
+    particles.y[i] = y + particles.vy[i] * (1.0 - t) * delta_time;
+    start_x[i] = x - particles.vx[i] * t * delta_time;
+    start_y[i] = y - particles.vy[i] * t * delta_time;
+    from[i] = t;
+}
+
+void ContinuousCollision::resolve(ParticleSystem& particles, const std::shared_ptr<Rectangle> boundaries,
+                                  const double diminishing_factor, const double delta_time, SleepSystem* sleep) {
+    stats = ContinuousCollisionStats();
+    const std::size_t n = particles.size();
+    // Without a begin_step for these particles there is no path to sweep.
+    if (start_x.size() != n) return;
+    from.assign(n, 0.0);
+    swept.assign(n, 0);
+    active.assign(n, 0);
+    handled.assign(n, 0);
+    swept_balls.clear();
+    earliest.clear();
+    for (std::size_t i = 0; i < n; ++i) {
+        const double dx = particles.x[i] - start_x[i];
+        const double dy = particles.y[i] - start_y[i];
+        const double reach = settings.fast_fraction * particles.radius[i];
+        if (dx * dx + dy * dy > reach * reach) add_swept(static_cast<std::uint32_t>(i));
+    }
+    stats.fast = swept_balls.size();
+    if (swept_balls.empty()) return;
+    grid.bin(particles);
+
+    for (int pass = 0; pass < settings.max_passes; ++pass) {
+        find_impacts(particles, boundaries);
+        if (impacts.empty()) break;
+        ++stats.passes;
+
+        std::sort(impacts.begin(), impacts.end(), [](const Impact& p, const Impact& q) {
+            return p.t < q.t || (p.t == q.t && (p.a < q.a || (p.a == q.a && p.b < q.b)));
+        });
+        for (const Impact& impact : impacts) {
+            const std::uint32_t a = impact.a;
+            const std::uint32_t b = impact.b;
+            if (handled[a] || (impact.wall == NO_WALL && handled[b])) continue;
+            handled[a] = 1;
+            const double t = impact.t;
+            const double ax = start_x[a] + t * (particles.x[a] - start_x[a]);
+            const double ay = start_y[a] + t * (particles.y[a] - start_y[a]);
+            if (impact.wall != NO_WALL) {
+                if (impact.wall == LEFT || impact.wall == RIGHT) {
+                    particles.vx[a] = -diminishing_factor * particles.vx[a];
+                } else {
+                    particles.vy[a] = -diminishing_factor * particles.vy[a];
+                }
+                restart_path(particles, a, ax, ay, t, delta_time);
+                ++stats.wall_impacts;
+                continue;
+            }
+
+            // The response of handle_ball_collision, at the moment of contact instead of after the overlap.
+            handled[b] = 1;
+            if (!swept[b]) add_swept(b);
+            const double bx = start_x[b] + t * (particles.x[b] - start_x[b]);
+            const double by = start_y[b] + t * (particles.y[b] - start_y[b]);
+            const double distance = std::sqrt((bx - ax) * (bx - ax) + (by - ay) * (by - ay));
+            const double nx = (bx - ax) / distance;
+            const double ny = (by - ay) / distance;
+            // The paths meet, but a scheme whose drift is not v dt may leave the velocities already separating.
+            const double p = std::max(0.0, (particles.vx[a] - particles.vx[b]) * nx + (particles.vy[a] - particles.vy[b]) * ny);
+            particles.vx[a] -= p * nx;
+            particles.vy[a] -= p * ny;
+            particles.vx[b] += p * nx;
+            particles.vy[b] += p * ny;
+            restart_path(particles, a, ax, ay, t, delta_time);
+            restart_path(particles, b, bx, by, t, delta_time);
+            ++stats.ball_impacts;
+            if (sleep != nullptr) {
+                if (particles.asleep[a]) sleep->wake(particles, a);
+                if (particles.asleep[b]) sleep->wake(particles, b);
+            }
+        }
+
+        // The next pass searches again for the balls that moved to a new path and for those whose impact waited.
+        for (const Impact& impact : impacts) {
+            active[impact.a] = 1;
+            handled[impact.a] = 0;
+            if (impact.wall == NO_WALL) {
+                active[impact.b] = 1;
+                handled[impact.b] = 0;
+            }
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef CONTINUOUS_COLLISION_H
+#define CONTINUOUS_COLLISION_H
+
+#include "ParticleSystem.h"
+#include "SpatialGrid.h"
+#include "Sleep.h"
+
+// When and whether fast balls are swept instead of only checked for overlap at the end of the step.
+struct ContinuousCollisionSettings {
+    bool enabled = false;
+    double fast_fraction = 0.5;          // a ball moving more than this fraction of its radius in a step is swept
+    int max_passes = 4;                  // impacts resolved per fast ball and step, at most
+};
+
+// Per-frame counters of the swept pass.
+struct ContinuousCollisionStats {
+    std::size_t fast = 0;                // balls moving fast enough to be swept
+    std::size_t ball_impacts = 0;
+    std::size_t wall_impacts = 0;
+    int passes = 0;
+};
+
+// Continuous collision detection for balls that move far enough in one step to pass through another ball or to
+// lose part of a bounce off a wall. Every ball is taken to move on a straight line from its position at the start
+// of the step to the one the integrator left it at. For each fast ball the earliest time of impact is found, with
+// another ball by solving the relative-motion quadratic |r0 + t dr| = ra + rb, with a wall by the linear equivalent.
+// The impacts are resolved in time order: the balls are moved back to the impact, bounce as in the discrete pass
+// (handle_ball_collision, apply_boundaries) and travel the rest of the step with their new velocities. A ball takes
+// part in one impact per pass; the next passes only search again for the balls whose paths changed or whose
+// impact had to wait, until no impact is left or max_passes is reached. The discrete pass of the step cleans up
+// what remains.
+class ContinuousCollision {
+    private:
+        enum Wall { NO_WALL = -1, LEFT, RIGHT, TOP, BOTTOM };
+        struct Impact {
+            double t;
+            std::uint32_t a;
+            std::uint32_t b;                 // the other ball, unused for a wall
+            int wall;
+        };
+        // The bounding box of a fast ball's remaining path, radius included.
+        struct SweptBox {
+            double min_x, max_x, min_y, max_y;
+            std::uint32_t slot;              // index into swept_balls
+        };
+
+        ContinuousCollisionSettings settings;
+        ContinuousCollisionStats stats;
+        std::vector<double> start_x;         // where each ball would have been at t = 0 on its current path
+        std::vector<double> start_y;
+        std::vector<double> from;            // the time each ball's current path starts at
+        // Balls that were fast or took part in an impact during this step. They are swept against each other;
+        // the rest stay where the grid binned them and are only looked up around the swept paths.
+        std::vector<char> swept;
+        std::vector<std::uint32_t> swept_balls;
+        std::vector<char> active;            // swept balls whose next impact has to be searched again
+        std::vector<char> handled;           // balls that took part in an impact of the current pass
+        std::vector<Impact> earliest;        // per slot of swept_balls
+        std::vector<std::uint32_t> found;
+        std::vector<Impact> impacts;
+        std::vector<SweptBox> boxes;
+        SpatialGrid grid;
+
+        // Earliest impact of ball a with ball b after both their paths start, false if there is none.
+        bool ball_impact(const ParticleSystem& particles, const std::uint32_t a, const std::uint32_t b, double& t) const;
+        // Fills impacts with the earliest impact of every active ball.
+        void find_impacts(const ParticleSystem& particles, const std::shared_ptr<Rectangle> boundaries);
+        // Puts ball i on the path through (x, y) at time t with its current velocity.
+        void restart_path(ParticleSystem& particles, const std::size_t i, const double x, const double y, const double t,
+                          const double delta_time);
+        void add_swept(const std::uint32_t i);
+
+    public:
+        explicit ContinuousCollision(const ContinuousCollisionSettings& settings = ContinuousCollisionSettings());
+        const ContinuousCollisionSettings& get_settings() const;
+        void set_settings(const ContinuousCollisionSettings& settings);
+        const ContinuousCollisionStats& get_stats() const;
+
+        // Remembers where every ball starts the step. Called before the integration.
+        void begin_step(const ParticleSystem& particles);
+        // Sweeps the fast balls from their start to their integrated positions and resolves their impacts.
+        // Sleeping balls that are hit are woken through sleep when one is given.
+        void resolve(ParticleSystem& particles, const std::shared_ptr<Rectangle> boundaries, const double diminishing_factor,
+                     const double delta_time, SleepSystem* sleep = nullptr);
+};
+
+
+#endif // CONTINUOUS_COLLISION_H
@@ -0,0 +1,107 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <vector>
+#include "ThreadPool.h"
+
+// Iterative radix-2 Cooley-Tukey FFT of a fixed power-of-two length. The bit-reversal permutation and the
+// twiddle factors are computed once by the constructor, so a 1D transform does no trigonometry and no allocation.
+// Header-only so it can be dropped into any tool without touching the build.
+class FFT {
+    public:
+        typedef std::complex<double> Complex;
+
+    private:
+        std::size_t n;
+        std::vector<std::size_t> reversed;
+        std::vector<Complex> twiddles;      // exp(-2 pi i k / n) for k < n / 2
+
+    public:
+        explicit FFT(const std::size_t n) : n(n), reversed(n), twiddles(n / 2) {
+            if (n == 0 || (n & (n - 1)) != 0) {
+                throw std::invalid_argument("FFT length must be a power of two");
+            }
+            int bits = 0;
+            while ((std::size_t(1) << bits) < n) ++bits;
+            for (std::size_t i = 0; i < n; ++i) {
+                std::size_t r = 0;
+                for (int b = 0; b < bits; ++b) {
+                    if (i & (std::size_t(1) << b)) r |= std::size_t(1) << (bits - 1 - b);
+                }
+                reversed[i] = r;
+            }
+            for (std::size_t k = 0; k < n / 2; ++k) {
+                double angle = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(n);
+                twiddles[k] = Complex(std::cos(angle), std::sin(angle));
+            }
+        }
+
+        std::size_t size() const {
+            return n;
+        }
+
+        // In-place transform of n values spaced stride apart. The inverse is unnormalized: a forward and an
+        // inverse transform multiply the data by n.
+        void transform(Complex* data, const bool inverse, const std::size_t stride = 1) const {
+            for (std::size_t i = 0; i < n; ++i) {
+                std::size_t r = reversed[i];
+                if (i < r) std::swap(data[i * stride], data[r * stride]);
+            }
+            for (std::size_t length = 2; length <= n; length <<= 1) {
+                const std::size_t half = length / 2;
+                const std::size_t step = n / length;
+                for (std::size_t start = 0; start < n; start += length) {
+                    for (std::size_t k = 0; k < half; ++k) {
+                        Complex w = twiddles[k * step];
+                        if (inverse) w = std::conj(w);
+                        Complex& a = data[(start + k) * stride];
+                        Complex& b = data[(start + k + half) * stride];
+                        Complex t = w * b;
+                        b = a - t;
+                        a += t;
+                    }
+                }
+            }
+        }
+
+        // In-place transform of an n x n row-major grid: every row, then every column. Columns are copied into
+        // contiguous scratch lines first, a strided butterfly would miss the cache on every access.
+        void transform_2d(std::vector<Complex>& grid, const bool inverse, ThreadPool* pool = nullptr) const {
+            if (grid.size() != n * n) {
+                throw std::invalid_argument("FFT grid must be n x n");
+            }
+            auto rows = [&](std::size_t begin, std::size_t end, std::size_t) {
+                for (std::size_t row = begin; row < end; ++row) transform(grid.data() + row * n, inverse);
+            };
+            // Columns are handled in blocks of 8: each row contributes 8 neighboring values per cache line read.
+            const std::size_t block = std::min<std::size_t>(8, n);
+            const std::size_t blocks = n / block;
+            auto columns = [&](std::size_t begin, std::size_t end, std::size_t) {
+                std::vector<Complex> lines(block * n);
+                for (std::size_t b = begin; b < end; ++b) {
+                    const std::size_t first = b * block;
+                    for (std::size_t row = 0; row < n; ++row) {
+                        for (std::size_t c = 0; c < block; ++c) lines[c * n + row] = grid[row * n + first + c];
+                    }
+                    for (std::size_t c = 0; c < block; ++c) transform(lines.data() + c * n, inverse);
+                    for (std::size_t row = 0; row < n; ++row) {
+                        for (std::size_t c = 0; c < block; ++c) grid[row * n + first + c] = lines[c * n + row];
+                    }
+                }
+            };
+            if (pool == nullptr || pool->size() == 1) {
+                rows(0, n, 0);
+                columns(0, blocks, 0);
+                return;
+            }
+            pool->parallel_for(n, std::max<std::size_t>(4, n / (pool->size() * 4)), rows);
+            pool->parallel_for(blocks, std::max<std::size_t>(1, blocks / (pool->size() * 4)), columns);
+        }
+};
+
+
+#endif // FFT_H
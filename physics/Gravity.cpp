@@ -0,0 +1,205 @@
+#include "Gravity.h"
+#include <algorithm>
+#include "Profiler.h"
+
+void compute_gravity(ParticleSystem& particles, const double G) {
+    compute_gravity(particles, G, 0, particles.size());
+}
+
+void compute_gravity(ParticleSystem& particles, const double G, const std::size_t begin, const std::size_t end) {
+    const std::size_t n = particles.size();
+    const double* x = particles.x.data();
+    const double* y = particles.y.data();
+    const double* mass = particles.mass.data();
+    double* ax = particles.ax.data();
+    double* ay = particles.ay.data();
+
+    for (std::size_t i = begin; i < end; ++i) {
+        const double xi = x[i];
+        const double yi = y[i];
+        double net_ax = 0.0;
+        double net_ay = 0.0;
+        for (std::size_t j = 0; j < n; ++j) {
+            if (i == j) continue;
+            double dx = x[j] - xi;
+            double dy = y[j] - yi;
+            double distance = std::sqrt(dx * dx + dy * dy);
+            // Avoid division by zero (or extremely small distances) which can lead to huge forces.
+            if (distance < 1.0) distance = 1.0;
+            net_ax += G * mass[j] * dx / (distance * distance * distance);
+            net_ay += G * mass[j] * dy / (distance * distance * distance);
+        }
+        ax[i] = net_ax;
+        ay[i] = net_ay;
+    }
+}
+
+
+double potential_energy(const ParticleSystem& particles, const double G) {
+    const std::size_t n = particles.size();
+    double energy = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        double sum = 0.0;
+        for (std::size_t j = i + 1; j < n; ++j) {
+            double dx = particles.x[j] - particles.x[i];
+            double dy = particles.y[j] - particles.y[i];
+            double r2 = dx * dx + dy * dy;
+            sum += particles.mass[j] * (r2 >= 1.0 ? -1.0 / std::sqrt(r2) : 0.5 * (r2 - 3.0));
+        }
+        energy += particles.mass[i] * sum;
+    }
+    return G * energy;
+}
+
+GravitySolver::GravitySolver(const double G) : G(G) {}
+
+double GravitySolver::getG() const {
+    return G;
+}
+
+void GravitySolver::setG(const double G) {
+    this->G = G;
+}
+
+void GravitySolver::compute_targets(ParticleSystem& particles, const std::vector<std::uint32_t>&) {
+    compute(particles);
+}
+
+
+BruteForceGravity::BruteForceGravity(const double G, std::shared_ptr<ThreadPool> pool, const bool deterministic)
+    : GravitySolver(G), pool(pool), deterministic(deterministic) {}
+
+bool BruteForceGravity::is_deterministic() const {
+    return deterministic;
+}
+
+void BruteForceGravity::set_deterministic(const bool deterministic) {
+    this->deterministic = deterministic;
+}
+
+std::shared_ptr<GravityKernel> BruteForceGravity::get_kernel() const {
+    return kernel;
+}
+
+void BruteForceGravity::set_kernel(std::shared_ptr<GravityKernel> kernel) {
+    this->kernel = kernel;
+}
+
+void BruteForceGravity::compute(ParticleSystem& particles) {
+    PROFILE_SCOPE("gravity");
+    const std::size_t n = particles.size();
+    if (kernel != nullptr) {
+        kernel->prepare(particles);
+        if (pool == nullptr || pool->size() == 1) {
+            kernel->accumulate(particles, G, 0, n);
+            return;
+        }
+        std::size_t chunk = std::max<std::size_t>(64, n / (pool->size() * 8));
+        pool->parallel_for(n, chunk, [&](std::size_t begin, std::size_t end, std::size_t) {
+            kernel->accumulate(particles, G, begin, end);
+        });
+        return;
+    }
+    if (pool == nullptr || pool->size() == 1) {
+        compute_gravity(particles, G);
+        return;
+    }
+    if (!deterministic) {
+        compute_symmetric(particles);
+        return;
+    }
+
+    // Small chunks keep the threads balanced, large enough to amortize the dispatch.
+    std::size_t chunk = std::max<std::size_t>(16, n / (pool->size() * 8));
+    pool->parallel_for(n, chunk, [&](std::size_t begin, std::size_t end, std::size_t) {
+        compute_gravity(particles, G, begin, end);
+    });
+}
+
+void BruteForceGravity::compute_symmetric(ParticleSystem& particles) {
+    const std::size_t n = particles.size();
+    const std::size_t threads = pool->size();
+    partial_ax.resize(threads);
+    partial_ay.resize(threads);
+
+    const double* x = particles.x.data();
+    const double* y = particles.y.data();
+    const double* mass = particles.mass.data();
+
+    // Row i evaluates the pairs (i, j > i), so the rows shrink along the range: hand them out in small chunks.
+    std::size_t chunk = std::max<std::size_t>(4, n / (threads * 32));
+    std::vector<char> used(threads, 0);
+    pool->parallel_for(n, chunk, [&](std::size_t begin, std::size_t end, std::size_t worker) {
+        std::vector<double>& acc_x = partial_ax[worker];
+        std::vector<double>& acc_y = partial_ay[worker];
+        if (!used[worker]) {
+            acc_x.assign(n, 0.0);
+            acc_y.assign(n, 0.0);
+            used[worker] = 1;
+        }
+        double* pax = acc_x.data();
+        double* pay = acc_y.data();
+
+        for (std::size_t i = begin; i < end; ++i) {
+            const double xi = x[i];
+            const double yi = y[i];
+            const double mi = mass[i];
+            double net_ax = 0.0;
+            double net_ay = 0.0;
+            for (std::size_t j = i + 1; j < n; ++j) {
+                double dx = x[j] - xi;
+                double dy = y[j] - yi;
+                double distance = std::sqrt(dx * dx + dy * dy);
+                if (distance < 1.0) distance = 1.0;
+                double scale = G / (distance * distance * distance);
+                net_ax += scale * mass[j] * dx;
+                net_ay += scale * mass[j] * dy;
+                pax[j] -= scale * mi * dx;
+                pay[j] -= scale * mi * dy;
+            }
+            pax[i] += net_ax;
+            pay[i] += net_ay;
+        }
+    });
+
+    // Reduce the per-thread buffers of the threads that took part in this pass.
+    std::size_t reduce_chunk = std::max<std::size_t>(1024, n / threads);
+    pool->parallel_for(n, reduce_chunk, [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            double sum_x = 0.0;
+            double sum_y = 0.0;
+            for (std::size_t t = 0; t < threads; ++t) {
+                if (!used[t]) continue;
+                sum_x += partial_ax[t][i];
+                sum_y += partial_ay[t][i];
+            }
+            particles.ax[i] = sum_x;
+            particles.ay[i] = sum_y;
+        }
+    });
+}
+
+void BruteForceGravity::compute_targets(ParticleSystem& particles, const std::vector<std::uint32_t>& targets) {
+    PROFILE_SCOPE("gravity");
+    if (kernel != nullptr) kernel->prepare(particles);
+    // Every target sums its sources in index order, so the result does not depend on the threads either way. The
+    // kernel takes a whole batch of targets at once, so each source tile is reused by all of them.
+    auto evaluate = [&](std::size_t begin, std::size_t end) {
+        if (kernel != nullptr) {
+            kernel->accumulate(particles, G, targets, begin, end);
+            return;
+        }
+        for (std::size_t k = begin; k < end; ++k) {
+            const std::size_t i = targets[k];
+            compute_gravity(particles, G, i, i + 1);
+        }
+    };
+    if (pool == nullptr || pool->size() == 1) {
+        evaluate(0, targets.size());
+        return;
+    }
+    std::size_t chunk = std::max<std::size_t>(16, targets.size() / (pool->size() * 8));
+    pool->parallel_for(targets.size(), chunk, [&](std::size_t begin, std::size_t end, std::size_t) {
+        evaluate(begin, end);
+    });
+}
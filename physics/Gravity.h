@@ -0,0 +1,67 @@
+#ifndef GRAVITY_H
+#define GRAVITY_H
+
+#include <cstdint>
+#include "ParticleSystem.h"
+#include "ThreadPool.h"
+#include "GravityKernel.h"
+
+// Overwrites every particle's acceleration with the gravitational pull of all the others.
+// For particle i the contribution of particle j is a = G * mass_j * (r_vector) / |r|^3,
+// with |r| clamped to 1.0 to avoid the huge forces of (nearly) coincident balls.
+void compute_gravity(ParticleSystem& particles, const double G);
+// Same as above, restricted to the target particles [begin, end). The sources are always all particles.
+void compute_gravity(ParticleSystem& particles, const double G, const std::size_t begin, const std::size_t end);
+// Potential energy of the same softened law: -G m_i m_j / |r| for |r| >= 1 and the matching harmonic well
+// G m_i m_j (|r|^2 - 3) / 2 below. O(n^2), meant for diagnostics.
+double potential_energy(const ParticleSystem& particles, const double G);
+
+// Common interface of the gravity engines, so the simulation loop can switch between them.
+class GravitySolver {
+    protected:
+        double G;
+
+    public:
+        explicit GravitySolver(const double G);
+        virtual ~GravitySolver() = default;
+        double getG() const;
+        void setG(const double G);
+        // Fills particles.ax / particles.ay with the gravitational acceleration of every particle.
+        virtual void compute(ParticleSystem& particles) = 0;
+        // Same, but only the accelerations of the targets are required to be updated; the sources are still all
+        // particles. The default evaluates everything, engines override it when a subset is cheaper.
+        virtual void compute_targets(ParticleSystem& particles, const std::vector<std::uint32_t>& targets);
+};
+
+// The exact O(n^2) pairwise sum. It is the reference every other engine is checked against.
+//
+// With a thread pool the pass runs on all of its threads. In deterministic mode the target particles are
+// split across the threads and each one still sums its sources in index order, so the result is bit-identical
+// to the serial path. Otherwise every pair is evaluated once and applied to both particles (Newton's third law)
+// through per-thread buffers, which halves the work but makes the summation order depend on the scheduling.
+//
+// With a GravityKernel the accumulation goes through the vectorized kernel instead of the reference loop.
+// The kernel always splits the targets across the threads, so the result does not depend on the thread count.
+class BruteForceGravity : public GravitySolver {
+    private:
+        std::shared_ptr<ThreadPool> pool;
+        bool deterministic;
+        std::shared_ptr<GravityKernel> kernel;
+        std::vector<std::vector<double>> partial_ax;
+        std::vector<std::vector<double>> partial_ay;
+
+        void compute_symmetric(ParticleSystem& particles);
+
+    public:
+        explicit BruteForceGravity(const double G, std::shared_ptr<ThreadPool> pool = nullptr, const bool deterministic = false);
+        bool is_deterministic() const;
+        void set_deterministic(const bool deterministic);
+        std::shared_ptr<GravityKernel> get_kernel() const;
+        // nullptr switches back to the reference loop.
+        void set_kernel(std::shared_ptr<GravityKernel> kernel);
+        void compute(ParticleSystem& particles) override;
+        void compute_targets(ParticleSystem& particles, const std::vector<std::uint32_t>& targets) override;
+};
+
+
+#endif // GRAVITY_H
@@ -0,0 +1,438 @@
+#include "GravityKernel.h"
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PHYSICS_X86_SIMD 1
+#include <immintrin.h>
+#else
+#define PHYSICS_X86_SIMD 0
+#endif
+
+namespace {
+
+// One block of work: the targets [i0, i1) against the source tile [j0, j1), with positions and masses in T. The
+// targets are the particles of those indices, or with a target list the particles targets[i0, i1). The sums of
+// a tile are kept in T and added to the double accelerations.
+template <typename T>
+struct TileArgs {
+    const T* x;
+    const T* y;
+    const T* mass;
+    const std::uint32_t* targets;
+    std::size_t i0, i1;
+    std::size_t j0, j1;
+    double* ax;
+    double* ay;
+};
+
+// Sum over the sources [j0, j1) for one target, one pair at a time. Also used for the SIMD remainders.
+template <typename T>
+inline void accumulate_scalar(const TileArgs<T>& t, const std::size_t i, std::size_t j0, T& sum_x, T& sum_y) {
+    const T xi = t.x[i];
+    const T yi = t.y[i];
+    for (std::size_t j = j0; j < t.j1; ++j) {
+        T dx = t.x[j] - xi;
+        T dy = t.y[j] - yi;
+        T r2 = std::max(dx * dx + dy * dy, T(1));
+        T inv = T(1) / std::sqrt(r2);
+        T s = t.mass[j] * inv * inv * inv;
+        sum_x += s * dx;
+        sum_y += s * dy;
+    }
+}
+
+template <typename T>
+void tile_scalar(const TileArgs<T>& t) {
+    for (std::size_t k = t.i0; k < t.i1; ++k) {
+        const std::size_t i = t.targets != nullptr ? t.targets[k] : k;
+        T sum_x = T(0);
+        T sum_y = T(0);
+        accumulate_scalar(t, i, t.j0, sum_x, sum_y);
+        t.ax[i] += sum_x;
+        t.ay[i] += sum_y;
+    }
+}
+
+#if PHYSICS_X86_SIMD
+
+template <bool Fast>
+__attribute__((target("sse2")))
+void tile_sse2(const TileArgs<double>& t) {
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    const __m128d three_halves = _mm_set1_pd(1.5);
+    for (std::size_t k = t.i0; k < t.i1; ++k) {
+        const std::size_t i = t.targets != nullptr ? t.targets[k] : k;
+        const __m128d xi = _mm_set1_pd(t.x[i]);
+        const __m128d yi = _mm_set1_pd(t.y[i]);
+        __m128d sum_x = _mm_setzero_pd();
+        __m128d sum_y = _mm_setzero_pd();
+        std::size_t j = t.j0;
+        for (; j + 2 <= t.j1; j += 2) {
+            __m128d dx = _mm_sub_pd(_mm_loadu_pd(t.x + j), xi);
+            __m128d dy = _mm_sub_pd(_mm_loadu_pd(t.y + j), yi);
+            __m128d r2 = _mm_max_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)), one);
+            __m128d inv;
+            if (Fast) {
+                inv = _mm_cvtps_pd(_mm_rsqrt_ps(_mm_cvtpd_ps(r2)));
+                inv = _mm_mul_pd(inv, _mm_sub_pd(three_halves, _mm_mul_pd(_mm_mul_pd(half, r2), _mm_mul_pd(inv, inv))));
+            } else {
+                inv = _mm_div_pd(one, _mm_sqrt_pd(r2));
+            }
+            __m128d s = _mm_mul_pd(_mm_loadu_pd(t.mass + j), _mm_mul_pd(inv, _mm_mul_pd(inv, inv)));
+            sum_x = _mm_add_pd(sum_x, _mm_mul_pd(s, dx));
+            sum_y = _mm_add_pd(sum_y, _mm_mul_pd(s, dy));
+        }
+        double lanes_x[2], lanes_y[2];
+        _mm_storeu_pd(lanes_x, sum_x);
+        _mm_storeu_pd(lanes_y, sum_y);
+        double total_x = lanes_x[0] + lanes_x[1];
+        double total_y = lanes_y[0] + lanes_y[1];
+        accumulate_scalar(t, i, j, total_x, total_y);
+        t.ax[i] += total_x;
+        t.ay[i] += total_y;
+    }
+}
+
+template <bool Fast>
+__attribute__((target("avx2,fma")))
+void tile_avx2(const TileArgs<double>& t) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d three_halves = _mm256_set1_pd(1.5);
+    for (std::size_t k = t.i0; k < t.i1; ++k) {
+        const std::size_t i = t.targets != nullptr ? t.targets[k] : k;
+        const __m256d xi = _mm256_set1_pd(t.x[i]);
+        const __m256d yi = _mm256_set1_pd(t.y[i]);
+        __m256d sum_x = _mm256_setzero_pd();
+        __m256d sum_y = _mm256_setzero_pd();
+        std::size_t j = t.j0;
+        for (; j + 4 <= t.j1; j += 4) {
+            __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(t.x + j), xi);
+            __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(t.y + j), yi);
+            __m256d r2 = _mm256_max_pd(_mm256_fmadd_pd(dx, dx, _mm256_mul_pd(dy, dy)), one);
+            __m256d inv;
+            if (Fast) {
+                inv = _mm256_cvtps_pd(_mm_rsqrt_ps(_mm256_cvtpd_ps(r2)));
+                inv = _mm256_mul_pd(inv, _mm256_fnmadd_pd(_mm256_mul_pd(half, r2), _mm256_mul_pd(inv, inv), three_halves));
+            } else {
+                inv = _mm256_div_pd(one, _mm256_sqrt_pd(r2));
+            }
+            __m256d s = _mm256_mul_pd(_mm256_loadu_pd(t.mass + j), _mm256_mul_pd(inv, _mm256_mul_pd(inv, inv)));
+            sum_x = _mm256_fmadd_pd(s, dx, sum_x);
+            sum_y = _mm256_fmadd_pd(s, dy, sum_y);
+        }
+        __m128d folded_x = _mm_add_pd(_mm256_castpd256_pd128(sum_x), _mm256_extractf128_pd(sum_x, 1));
+        __m128d folded_y = _mm_add_pd(_mm256_castpd256_pd128(sum_y), _mm256_extractf128_pd(sum_y, 1));
+        double total_x = _mm_cvtsd_f64(_mm_add_sd(folded_x, _mm_unpackhi_pd(folded_x, folded_x)));
+        double total_y = _mm_cvtsd_f64(_mm_add_sd(folded_y, _mm_unpackhi_pd(folded_y, folded_y)));
+        accumulate_scalar(t, i, j, total_x, total_y);
+        t.ax[i] += total_x;
+        t.ay[i] += total_y;
+    }
+}
+
+// GCC 12's AVX-512 intrinsics pass _mm512_undefined_* through as the masked-off operand, which trips
+// -Wmaybe-uninitialized once they are inlined here.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+template <bool Fast>
+__attribute__((target("avx512f")))
+void tile_avx512(const TileArgs<double>& t) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_halves = _mm512_set1_pd(1.5);
+    for (std::size_t k = t.i0; k < t.i1; ++k) {
+        const std::size_t i = t.targets != nullptr ? t.targets[k] : k;
+        const __m512d xi = _mm512_set1_pd(t.x[i]);
+        const __m512d yi = _mm512_set1_pd(t.y[i]);
+        __m512d sum_x = _mm512_setzero_pd();
+        __m512d sum_y = _mm512_setzero_pd();
+        std::size_t j = t.j0;
+        for (; j + 8 <= t.j1; j += 8) {
+            __m512d dx = _mm512_sub_pd(_mm512_loadu_pd(t.x + j), xi);
+            __m512d dy = _mm512_sub_pd(_mm512_loadu_pd(t.y + j), yi);
+            __m512d r2 = _mm512_max_pd(_mm512_fmadd_pd(dx, dx, _mm512_mul_pd(dy, dy)), one);
+            __m512d inv;
+            if (Fast) {
+                inv = _mm512_rsqrt14_pd(r2);
+                inv = _mm512_mul_pd(inv, _mm512_fnmadd_pd(_mm512_mul_pd(half, r2), _mm512_mul_pd(inv, inv), three_halves));
+            } else {
+                inv = _mm512_div_pd(one, _mm512_sqrt_pd(r2));
+            }
+            __m512d s = _mm512_mul_pd(_mm512_loadu_pd(t.mass + j), _mm512_mul_pd(inv, _mm512_mul_pd(inv, inv)));
+            sum_x = _mm512_fmadd_pd(s, dx, sum_x);
+            sum_y = _mm512_fmadd_pd(s, dy, sum_y);
+        }
+        double total_x = _mm512_reduce_add_pd(sum_x);
+        double total_y = _mm512_reduce_add_pd(sum_y);
+        accumulate_scalar(t, i, j, total_x, total_y);
+        t.ax[i] += total_x;
+        t.ay[i] += total_y;
+    }
+}
+#pragma GCC diagnostic pop
+
+// The float kernels: twice the lanes of the double ones at each level, and the reciprocal square root estimate
+// is refined in float without the round trip through double.
+
+template <bool Fast>
+__attribute__((target("sse2")))
+void tile_sse2(const TileArgs<float>& t) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 three_halves = _mm_set1_ps(1.5f);
+    for (std::size_t k = t.i0; k < t.i1; ++k) {
+        const std::size_t i = t.targets != nullptr ? t.targets[k] : k;
+        const __m128 xi = _mm_set1_ps(t.x[i]);
+        const __m128 yi = _mm_set1_ps(t.y[i]);
+        __m128 sum_x = _mm_setzero_ps();
+        __m128 sum_y = _mm_setzero_ps();
+        std::size_t j = t.j0;
+        for (; j + 4 <= t.j1; j += 4) {
+            __m128 dx = _mm_sub_ps(_mm_loadu_ps(t.x + j), xi);
+            __m128 dy = _mm_sub_ps(_mm_loadu_ps(t.y + j), yi);
+            __m128 r2 = _mm_max_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), one);
+            __m128 inv;
+            if (Fast) {
+                inv = _mm_rsqrt_ps(r2);
+                inv = _mm_mul_ps(inv, _mm_sub_ps(three_halves, _mm_mul_ps(_mm_mul_ps(half, r2), _mm_mul_ps(inv, inv))));
+            } else {
+                inv = _mm_div_ps(one, _mm_sqrt_ps(r2));
+            }
+            __m128 s = _mm_mul_ps(_mm_loadu_ps(t.mass + j), _mm_mul_ps(inv, _mm_mul_ps(inv, inv)));
+            sum_x = _mm_add_ps(sum_x, _mm_mul_ps(s, dx));
+            sum_y = _mm_add_ps(sum_y, _mm_mul_ps(s, dy));
+        }
+        __m128 folded_x = _mm_add_ps(sum_x, _mm_movehl_ps(sum_x, sum_x));
+        __m128 folded_y = _mm_add_ps(sum_y, _mm_movehl_ps(sum_y, sum_y));
+        float total_x = _mm_cvtss_f32(_mm_add_ss(folded_x, _mm_shuffle_ps(folded_x, folded_x, 1)));
+        float total_y = _mm_cvtss_f32(_mm_add_ss(folded_y, _mm_shuffle_ps(folded_y, folded_y, 1)));
+        accumulate_scalar(t, i, j, total_x, total_y);
+        t.ax[i] += total_x;
+        t.ay[i] += total_y;
+    }
+}
+
+template <bool Fast>
+__attribute__((target("avx2,fma")))
+void tile_avx2(const TileArgs<float>& t) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three_halves = _mm256_set1_ps(1.5f);
+    for (std::size_t k = t.i0; k < t.i1; ++k) {
+        const std::size_t i = t.targets != nullptr ? t.targets[k] : k;
+        const __m256 xi = _mm256_set1_ps(t.x[i]);
+        const __m256 yi = _mm256_set1_ps(t.y[i]);
+        __m256 sum_x = _mm256_setzero_ps();
+        __m256 sum_y = _mm256_setzero_ps();
+        std::size_t j = t.j0;
+        for (; j + 8 <= t.j1; j += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(t.x + j), xi);
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(t.y + j), yi);
+            __m256 r2 = _mm256_max_ps(_mm256_fmadd_ps(dx, dx, _mm256_mul_ps(dy, dy)), one);
+            __m256 inv;
+            if (Fast) {
+                inv = _mm256_rsqrt_ps(r2);
+                inv = _mm256_mul_ps(inv, _mm256_fnmadd_ps(_mm256_mul_ps(half, r2), _mm256_mul_ps(inv, inv), three_halves));
+            } else {
+                inv = _mm256_div_ps(one, _mm256_sqrt_ps(r2));
+            }
+            __m256 s = _mm256_mul_ps(_mm256_loadu_ps(t.mass + j), _mm256_mul_ps(inv, _mm256_mul_ps(inv, inv)));
+            sum_x = _mm256_fmadd_ps(s, dx, sum_x);
+            sum_y = _mm256_fmadd_ps(s, dy, sum_y);
+        }
+        __m128 halves_x = _mm_add_ps(_mm256_castps256_ps128(sum_x), _mm256_extractf128_ps(sum_x, 1));
+        __m128 halves_y = _mm_add_ps(_mm256_castps256_ps128(sum_y), _mm256_extractf128_ps(sum_y, 1));
+        __m128 folded_x = _mm_add_ps(halves_x, _mm_movehl_ps(halves_x, halves_x));
+        __m128 folded_y = _mm_add_ps(halves_y, _mm_movehl_ps(halves_y, halves_y));
+        float total_x = _mm_cvtss_f32(_mm_add_ss(folded_x, _mm_shuffle_ps(folded_x, folded_x, 1)));
+        float total_y = _mm_cvtss_f32(_mm_add_ss(folded_y, _mm_shuffle_ps(folded_y, folded_y, 1)));
+        accumulate_scalar(t, i, j, total_x, total_y);
+        t.ax[i] += total_x;
+        t.ay[i] += total_y;
+    }
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+template <bool Fast>
+__attribute__((target("avx512f")))
+void tile_avx512(const TileArgs<float>& t) {
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 three_halves = _mm512_set1_ps(1.5f);
+    for (std::size_t k = t.i0; k < t.i1; ++k) {
+        const std::size_t i = t.targets != nullptr ? t.targets[k] : k;
+        const __m512 xi = _mm512_set1_ps(t.x[i]);
+        const __m512 yi = _mm512_set1_ps(t.y[i]);
+        __m512 sum_x = _mm512_setzero_ps();
+        __m512 sum_y = _mm512_setzero_ps();
+        std::size_t j = t.j0;
+        for (; j + 16 <= t.j1; j += 16) {
+            __m512 dx = _mm512_sub_ps(_mm512_loadu_ps(t.x + j), xi);
+            __m512 dy = _mm512_sub_ps(_mm512_loadu_ps(t.y + j), yi);
+            __m512 r2 = _mm512_max_ps(_mm512_fmadd_ps(dx, dx, _mm512_mul_ps(dy, dy)), one);
+            __m512 inv;
+            if (Fast) {
+                inv = _mm512_rsqrt14_ps(r2);
+                inv = _mm512_mul_ps(inv, _mm512_fnmadd_ps(_mm512_mul_ps(half, r2), _mm512_mul_ps(inv, inv), three_halves));
+            } else {
+                inv = _mm512_div_ps(one, _mm512_sqrt_ps(r2));
+            }
+            __m512 s = _mm512_mul_ps(_mm512_loadu_ps(t.mass + j), _mm512_mul_ps(inv, _mm512_mul_ps(inv, inv)));
+            sum_x = _mm512_fmadd_ps(s, dx, sum_x);
+            sum_y = _mm512_fmadd_ps(s, dy, sum_y);
+        }
+        float total_x = _mm512_reduce_add_ps(sum_x);
+        float total_y = _mm512_reduce_add_ps(sum_y);
+        accumulate_scalar(t, i, j, total_x, total_y);
+        t.ax[i] += total_x;
+        t.ay[i] += total_y;
+    }
+}
+#pragma GCC diagnostic pop
+
+#endif // PHYSICS_X86_SIMD
+
+// Runs the targets of t over every source tile of [0, n) on the widest kernel allowed by level.
+template <typename T>
+void accumulate_tiles(TileArgs<T> t, const std::size_t n, const SimdLevel level, const bool fast_rsqrt) {
+    // tile_sse2<true> and the like name both the float and the double overload, so they are resolved by
+    // assignment to tile rather than in a conditional expression.
+    void (*tile)(const TileArgs<T>&) = tile_scalar<T>;
+#if PHYSICS_X86_SIMD
+    switch (level) {
+        case SimdLevel::AVX512:
+            if (fast_rsqrt) tile = tile_avx512<true>;
+            else tile = tile_avx512<false>;
+            break;
+        case SimdLevel::AVX2:
+            if (fast_rsqrt) tile = tile_avx2<true>;
+            else tile = tile_avx2<false>;
+            break;
+        case SimdLevel::SSE2:
+            if (fast_rsqrt) tile = tile_sse2<true>;
+            else tile = tile_sse2<false>;
+            break;
+        default: break;
+    }
+#endif
+
+    for (std::size_t j0 = 0; j0 < n; j0 += GravityKernel::TILE_SIZE) {
+        t.j0 = j0;
+        t.j1 = std::min(j0 + GravityKernel::TILE_SIZE, n);
+        tile(t);
+    }
+}
+
+} // namespace
+
+
+SimdLevel detect_simd_level() {
+#if PHYSICS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* simd_level_name(const SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE2: return "sse2";
+        case SimdLevel::AVX2: return "avx2";
+        case SimdLevel::AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+
+const char* precision_name(const Precision precision) {
+    return precision == Precision::Float ? "float" : "double";
+}
+
+
+GravityKernel::GravityKernel(const bool fast_rsqrt, const SimdLevel level, const Precision precision)
+    : fast_rsqrt(fast_rsqrt), precision(precision) {
+    // Never run instructions the CPU does not have, whatever was asked for.
+    this->level = std::min(level, detect_simd_level());
+}
+
+SimdLevel GravityKernel::get_level() const {
+    return level;
+}
+
+bool GravityKernel::is_fast_rsqrt() const {
+    return fast_rsqrt;
+}
+
+Precision GravityKernel::get_precision() const {
+    return precision;
+}
+
+void GravityKernel::prepare(const ParticleSystem& particles) {
+    if (precision != Precision::Float) return;
+    const std::size_t n = particles.size();
+    float_x.resize(n);
+    float_y.resize(n);
+    float_mass.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        float_x[i] = static_cast<float>(particles.x[i]);
+        float_y[i] = static_cast<float>(particles.y[i]);
+        float_mass[i] = static_cast<float>(particles.mass[i]);
+    }
+}
+
+void GravityKernel::accumulate(ParticleSystem& particles, const double G, const std::size_t begin, const std::size_t end) const {
+    accumulate_targets(particles, G, nullptr, begin, end);
+}
+
+void GravityKernel::accumulate(ParticleSystem& particles, const double G, const std::vector<std::uint32_t>& targets,
+                               const std::size_t begin, const std::size_t end) const {
+    accumulate_targets(particles, G, targets.data(), begin, end);
+}
+
+void GravityKernel::accumulate_targets(ParticleSystem& particles, const double G, const std::uint32_t* targets,
+                                       const std::size_t begin, const std::size_t end) const {
+    const std::size_t n = particles.size();
+    for (std::size_t k = begin; k < end; ++k) {
+        const std::size_t i = targets != nullptr ? targets[k] : k;
+        particles.ax[i] = 0.0;
+        particles.ay[i] = 0.0;
+    }
+
+    if (precision == Precision::Float) {
+        if (float_x.size() != n) throw std::runtime_error("GravityKernel::prepare was not called for these particles");
+        TileArgs<float> t;
+        t.x = float_x.data();
+        t.y = float_y.data();
+        t.mass = float_mass.data();
+        t.targets = targets;
+        t.i0 = begin;
+        t.i1 = end;
+        t.ax = particles.ax.data();
+        t.ay = particles.ay.data();
+        accumulate_tiles(t, n, level, fast_rsqrt);
+    } else {
+        TileArgs<double> t;
+        t.x = particles.x.data();
+        t.y = particles.y.data();
+        t.mass = particles.mass.data();
+        t.targets = targets;
+        t.i0 = begin;
+        t.i1 = end;
+        t.ax = particles.ax.data();
+        t.ay = particles.ay.data();
+        accumulate_tiles(t, n, level, fast_rsqrt);
+    }
+
+    // G is common to every pair, apply it once per target instead of once per pair.
+    for (std::size_t k = begin; k < end; ++k) {
+        const std::size_t i = targets != nullptr ? targets[k] : k;
+        particles.ax[i] *= G;
+        particles.ay[i] *= G;
+    }
+}
@@ -0,0 +1,416 @@
+#include "Headless.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include "Simulation.h"
+#include "Checkpoint.h"
+#include "Trajectory.h"
+#include "SceneLoader.h"
+#include "Profiler.h"
+
+namespace {
+
+// Light bodies on circular orbits around a heavy one, with no walls and no collisions, so the only error in the
+// total energy is the integrator's. The optional tight binary needs a step about a hundred times shorter than
+// the rest of the scene.
+void build_orbit_scene(ParticleSystem& particles, const std::size_t count, const unsigned int seed, const double G,
+                       const bool with_binary) {
+    const double central_mass = 1000.0;
+    // Light enough that close passes between satellites barely perturb their orbits.
+    const double satellite_mass = 0.01;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> random_radius(50.0, 400.0);
+    std::uniform_real_distribution<double> random_angle(0.0, 2.0 * M_PI);
+    particles.clear();
+    particles.add(0.0, 0.0, 20.0, central_mass);
+    for (std::size_t i = 0; i < count; ++i) {
+        double r = random_radius(rng);
+        double angle = random_angle(rng);
+        double speed = std::sqrt(G * central_mass / r);
+        std::size_t index = particles.add(r * std::cos(angle), r * std::sin(angle), 1.0, satellite_mass);
+        particles.vx[index] = -speed * std::sin(angle);
+        particles.vy[index] = speed * std::cos(angle);
+    }
+    if (with_binary) {
+        // Two masses 2 apart circling each other, their center of mass on a circular orbit at r = 200.
+        const double mass = 5.0;
+        const double separation = 2.0;
+        const double orbit_speed = std::sqrt(G * central_mass / 200.0);
+        const double pair_speed = std::sqrt(G * mass / (2.0 * separation));
+        std::size_t a = particles.add(200.0 - separation / 2, 0.0, 1.0, mass);
+        std::size_t b = particles.add(200.0 + separation / 2, 0.0, 1.0, mass);
+        particles.vy[a] = orbit_speed - pair_speed;
+        particles.vy[b] = orbit_speed + pair_speed;
+    }
+}
+
+double total_energy(const ParticleSystem& particles, const double G) {
+    double kinetic = 0.0;
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        kinetic += 0.5 * particles.mass[i] * (particles.vx[i] * particles.vx[i] + particles.vy[i] * particles.vy[i]);
+    }
+    return kinetic + potential_energy(particles, G);
+}
+
+// Runs every integrator over the same simulated time at dt, 2 dt, ... 16 dt and prints the largest relative
+// energy error against the cost, so a scheme and a timestep can be picked for a target accuracy.
+void run_integrator_report(const GravitySettings& gravity_settings, const std::size_t count, const std::uint64_t num_steps,
+                           const double delta_time, const unsigned int seed, const bool with_binary) {
+    std::shared_ptr<GravitySolver> gravity = make_gravity_solver(gravity_settings);
+    const double duration = delta_time * static_cast<double>(num_steps);
+    ParticleSystem particles;
+
+    std::cout << "orbit scene: " << count << " bodies around a central mass" << (with_binary ? " and a tight binary" : "")
+              << ", " << duration << " s simulated, gravity: "
+              << gravity_settings.engine << (gravity_settings.engine == "simd" ? ", " + gravity_settings.precision : "") << "\n"
+              << std::left << std::setw(10) << "integrator" << std::right << std::setw(12) << "dt" << std::setw(10) << "steps"
+              << std::setw(14) << "force evals" << std::setw(14) << "wall time" << std::setw(16) << "max |dE/E|" << std::endl;
+    for (const std::string& name : integrator_names()) {
+        for (std::uint64_t factor = 1; factor <= 16; factor *= 2) {
+            // A fresh integrator per run: adaptive ones keep per-body state from step to step.
+            std::shared_ptr<Integrator> integrator = make_integrator(name);
+            const std::uint64_t steps = std::max<std::uint64_t>(1, num_steps / factor);
+            const double dt = duration / static_cast<double>(steps);
+            build_orbit_scene(particles, count, seed, gravity_settings.G, with_binary);
+            const double initial_energy = total_energy(particles, gravity_settings.G);
+            double max_error = 0.0;
+            double elapsed = 0.0;
+            double force_evaluations = 0.0;
+            for (std::uint64_t step = 0; step < steps; ++step) {
+                auto start = std::chrono::steady_clock::now();
+                integrator->step(particles, *gravity, dt);
+                elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                force_evaluations += integrator->force_evaluations();
+                // Sample the energy a few dozen times per run, it costs as much as a brute-force evaluation.
+                if ((step + 1) % std::max<std::uint64_t>(1, steps / 32) == 0 || step + 1 == steps) {
+                    double error = std::abs((total_energy(particles, gravity_settings.G) - initial_energy) / initial_energy);
+                    max_error = std::max(max_error, error);
+                }
+            }
+            std::cout << std::left << std::setw(10) << integrator->name() << std::right << std::setw(12) << dt
+                      << std::setw(10) << steps << std::setw(14) << force_evaluations
+                      << std::setw(14) << elapsed << std::setw(16) << max_error << std::endl;
+        }
+    }
+}
+
+// Decodes a recorded trajectory front to back and at random frames and prints its size and decoding speed.
+void run_trajectory_report(const std::string& path, const unsigned int seed) {
+    typedef std::chrono::steady_clock Clock;
+    TrajectoryReader reader(path);
+    const std::size_t frames = reader.frame_count();
+    std::size_t keyframes = 0;
+    for (std::size_t f = 0; f < frames; ++f) keyframes += reader.is_keyframe(f) ? 1 : 0;
+
+    TrajectoryFrame frame;
+    std::uint64_t body_frames = 0;
+    auto start = Clock::now();
+    for (std::size_t f = 0; f < frames; ++f) {
+        reader.read(f, frame);
+        body_frames += frame.size();
+    }
+    double sequential = std::chrono::duration<double>(Clock::now() - start).count();
+
+    const std::size_t seeks = frames > 0 ? 100 : 0;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<std::size_t> random_frame(0, frames > 0 ? frames - 1 : 0);
+    start = Clock::now();
+    for (std::size_t s = 0; s < seeks; ++s) reader.read(random_frame(rng), frame);
+    double seeking = std::chrono::duration<double>(Clock::now() - start).count();
+
+    // Each body and frame holds x, y, vx and vy as doubles when uncompressed.
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    const double bytes = static_cast<double>(file.tellg());
+    std::cout << std::setprecision(4)
+              << "trajectory: " << path << (reader.has_index() ? "" : " (no index, rebuilt from the frames)") << "\n"
+              << "frames: " << frames << ", keyframes: " << keyframes;
+    if (frames > 0) std::cout << ", steps " << reader.frame_step(0) << " to " << reader.frame_step(frames - 1);
+    std::cout << "\n"
+              << "size: " << bytes / 1e6 << " MB, "
+              << (body_frames > 0 ? bytes / static_cast<double>(body_frames) : 0.0) << " bytes per body and frame (32 uncompressed)\n"
+              << "sequential decode: " << (frames > 0 ? sequential / static_cast<double>(frames) * 1000.0 : 0.0) << " ms per frame\n"
+              << "random seek: " << (seeks > 0 ? seeking / static_cast<double>(seeks) * 1000.0 : 0.0) << " ms per frame" << std::endl;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--bodies N] [--steps N] [--dt SECONDS] [--seed N] [--threads N] [--collision-threads N]\n"
+              << "       [--gravity brute-force|simd|barnes-hut|particle-mesh] [--theta X] [--deterministic] [--fast-rsqrt]\n"
+              << "       [--precision double|float]\n"
+              << "       [--mesh-size N] [--mesh-assignment cic|tsc] [--no-short-range]\n"
+              << "       [--width W] [--height H] [--sleep] [--sleep-threshold SPEED] [--sleep-steps N] [--ccd]\n"
+              << "       [--obstacles maze|funnel]\n"
+              << "       [--integrator euler|leapfrog|yoshida4|rk4|block] [--integrator-report [--binary]]\n"
+              << "       [--restore FILE] [--checkpoint FILE] [--checkpoint-every N]\n"
+              << "       [--record FILE] [--record-every N] [--trajectory-report FILE]\n"
+              << "       [--scene FILE] [--write-scene FILE] [--profile] [--profile-trace FILE]" << std::endl;
+}
+
+void print_profile() {
+    std::vector<Profiler::PhaseStats> phases = Profiler::instance().stats();
+    std::cout << std::left << std::setw(20) << "phase" << std::right << std::setw(10) << "samples" << std::setw(12) << "min ms"
+              << std::setw(12) << "p50 ms" << std::setw(12) << "p99 ms" << std::setw(12) << "mean ms" << "\n"
+              << std::fixed << std::setprecision(4);
+    for (const Profiler::PhaseStats& phase : phases) {
+        std::cout << std::left << std::setw(20) << phase.name << std::right << std::setw(10) << phase.samples
+                  << std::setw(12) << phase.min_ms << std::setw(12) << phase.p50_ms << std::setw(12) << phase.p99_ms
+                  << std::setw(12) << phase.mean_ms << "\n";
+    }
+    std::cout << std::defaultfloat << std::flush;
+}
+
+} // namespace
+
+int run_headless(int argc, char** argv) {
+    std::size_t num_balls = 1000;
+    std::uint64_t num_steps = 1000;
+    double delta_time = 1.0 / 60.0;
+    unsigned int seed = 1;
+    double width = 1200;
+    double height = 900;
+    double diminishing_factor = 0.1;
+    GravitySettings gravity_settings;
+    SleepSettings sleep_settings;
+    ContinuousCollisionSettings sweep_settings;
+    std::string integrator_name = "euler";
+    bool integrator_report = false;
+    bool with_binary = false;
+    bool engine_given = false;
+    std::string restore_path;
+    std::string checkpoint_path;
+    std::uint64_t checkpoint_every = 0;
+    std::string record_path;
+    std::uint64_t record_every = 1;
+    std::string trajectory_report_path;
+    std::string scene_path;
+    std::string write_scene_path;
+    bool profile = false;
+    bool collision_threads_given = false;
+    std::size_t collision_threads = 1;
+    std::string profile_trace_path;
+    std::string obstacle_scene;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--help" || arg == "-h") {
+                print_usage(argv[0]);
+                return 0;
+            } else if (arg == "--deterministic") {
+                gravity_settings.deterministic = true;
+            } else if (arg == "--fast-rsqrt") {
+                gravity_settings.fast_rsqrt = true;
+            } else if (arg == "--integrator-report") {
+                integrator_report = true;
+            } else if (arg == "--binary") {
+                with_binary = true;
+            } else if (arg == "--no-short-range") {
+                gravity_settings.mesh_short_range = false;
+            } else if (arg == "--sleep") {
+                sleep_settings.enabled = true;
+            } else if (arg == "--ccd") {
+                sweep_settings.enabled = true;
+            } else if (arg == "--profile") {
+                profile = true;
+            } else if (!has_value) {
+                throw std::invalid_argument("Missing value for " + arg);
+            } else if (arg == "--bodies") {
+                num_balls = std::stoull(argv[++i]);
+            } else if (arg == "--steps") {
+                num_steps = std::stoull(argv[++i]);
+            } else if (arg == "--dt") {
+                delta_time = std::stod(argv[++i]);
+            } else if (arg == "--seed") {
+                seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (arg == "--threads") {
+                gravity_settings.threads = std::stoull(argv[++i]);
+            } else if (arg == "--gravity") {
+                gravity_settings.engine = argv[++i];
+                engine_given = true;
+            } else if (arg == "--integrator") {
+                integrator_name = argv[++i];
+            } else if (arg == "--theta") {
+                gravity_settings.theta = std::stod(argv[++i]);
+            } else if (arg == "--mesh-size") {
+                gravity_settings.mesh_size = std::stoull(argv[++i]);
+            } else if (arg == "--mesh-assignment") {
+                gravity_settings.mesh_assignment = argv[++i];
+            } else if (arg == "--precision") {
+                gravity_settings.precision = argv[++i];
+            } else if (arg == "--sleep-threshold") {
+                sleep_settings.velocity_threshold = std::stod(argv[++i]);
+            } else if (arg == "--sleep-steps") {
+                sleep_settings.steps = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--restore") {
+                restore_path = argv[++i];
+            } else if (arg == "--checkpoint") {
+                checkpoint_path = argv[++i];
+            } else if (arg == "--checkpoint-every") {
+                checkpoint_every = std::stoull(argv[++i]);
+            } else if (arg == "--record") {
+                record_path = argv[++i];
+            } else if (arg == "--record-every") {
+                record_every = std::max<std::uint64_t>(1, std::stoull(argv[++i]));
+            } else if (arg == "--trajectory-report") {
+                trajectory_report_path = argv[++i];
+            } else if (arg == "--scene") {
+                scene_path = argv[++i];
+            } else if (arg == "--write-scene") {
+                write_scene_path = argv[++i];
+            } else if (arg == "--collision-threads") {
+                collision_threads = std::stoull(argv[++i]);
+                collision_threads_given = true;
+            } else if (arg == "--obstacles") {
+                obstacle_scene = argv[++i];
+            } else if (arg == "--profile-trace") {
+                profile_trace_path = argv[++i];
+            } else if (arg == "--width") {
+                width = std::stod(argv[++i]);
+            } else if (arg == "--height") {
+                height = std::stod(argv[++i]);
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+
+        if (!trajectory_report_path.empty()) {
+            run_trajectory_report(trajectory_report_path, seed);
+            return 0;
+        }
+        if (integrator_report) {
+            // The Barnes-Hut approximation changes as the tree is rebuilt, which would blur the integrator error.
+            if (!engine_given) gravity_settings.engine = "brute-force";
+            run_integrator_report(gravity_settings, num_balls, num_steps, delta_time, seed, with_binary);
+            return 0;
+        }
+
+        std::shared_ptr<Rectangle> boundaries = std::make_shared<Rectangle>(
+            std::make_shared<Point>(-width / 2 + 1, height / 2 - 1),
+            std::make_shared<Point>(width / 2 - 1, -height / 2 + 1)
+        );
+        Simulation simulation(boundaries, make_gravity_solver(gravity_settings), diminishing_factor);
+        simulation.set_integrator(make_integrator(integrator_name));
+        simulation.set_sleep_settings(sleep_settings);
+        simulation.set_continuous_collision_settings(sweep_settings);
+        simulation.set_collision_threads(collision_threads_given ? collision_threads : gravity_settings.threads);
+        double restore_time = 0.0;
+        double scene_time = 0.0;
+        if (!scene_path.empty()) {
+            // Parsed on one thread per hardware thread, or as many as --threads asks for.
+            ThreadPool pool(gravity_settings.threads);
+            auto scene_start = std::chrono::steady_clock::now();
+            load_scene(scene_path, simulation, &pool);
+            scene_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - scene_start).count();
+        } else if (restore_path.empty()) {
+            simulation.add_random_balls(num_balls, seed);
+        } else {
+            // The checkpoint's boundaries, G and damping replace the ones from the command line.
+            auto restore_start = std::chrono::steady_clock::now();
+            load_checkpoint(restore_path, simulation);
+            restore_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - restore_start).count();
+        }
+        if (!obstacle_scene.empty()) simulation.add_obstacle_scene(obstacle_scene, seed);
+        const std::uint64_t first_step = simulation.get_step_count();
+        if (!write_scene_path.empty()) save_scene(simulation, write_scene_path);
+
+        // Periodic checkpoints are saved in the background; one the writer is still busy with is skipped.
+        CheckpointWriter checkpoints;
+        std::uint64_t checkpoints_skipped = 0;
+        // Frames are encoded and written on the recorder's thread; the loop only copies the state.
+        std::unique_ptr<TrajectoryRecorder> recorder;
+        if (!record_path.empty()) {
+            recorder.reset(new TrajectoryRecorder(record_path));
+            recorder->record(simulation.get_particles(), first_step, delta_time * static_cast<double>(first_step));
+        }
+        std::uint64_t awake_body_steps = 0;
+        // Only the steps are profiled, not the setup.
+        Profiler::instance().set_thread_name("main");
+        Profiler::instance().clear();
+        auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t step = 0; step < num_steps; ++step) {
+            simulation.step(delta_time);
+            awake_body_steps += simulation.get_sleep_stats().awake;
+            const std::uint64_t current_step = simulation.get_step_count();
+            if (recorder != nullptr && (step + 1) % record_every == 0) {
+                recorder->record(simulation.get_particles(), current_step, delta_time * static_cast<double>(current_step));
+            }
+            if (!checkpoint_path.empty() && checkpoint_every > 0 && (step + 1) % checkpoint_every == 0 && step + 1 < num_steps) {
+                if (!checkpoints.save(simulation, checkpoint_path)) ++checkpoints_skipped;
+            }
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (recorder != nullptr) recorder->close();
+        if (!checkpoint_path.empty()) {
+            // The final state always makes it to disk.
+            checkpoints.wait();
+            checkpoints.save(simulation, checkpoint_path);
+            checkpoints.wait();
+            if (!checkpoints.get_last_error().empty()) {
+                throw std::runtime_error(checkpoints.get_last_error());
+            }
+        }
+
+        const CollisionStats& collisions = simulation.get_collision_stats();
+        const SleepStats& sleep = simulation.get_sleep_stats();
+        std::cout << std::setprecision(6)
+                  << "bodies: " << simulation.get_particles().size() << "\n"
+                  << "gravity: " << gravity_settings.engine << (gravity_settings.engine == "simd" ? ", " + gravity_settings.precision : "") << "\n"
+                  << "integrator: " << simulation.get_integrator()->name() << "\n"
+                  << "steps: " << simulation.get_step_count() - first_step << "\n"
+                  << "simulated time: " << delta_time * static_cast<double>(num_steps) << " s\n"
+                  << "wall time: " << elapsed << " s\n"
+                  << "steps/sec: " << (elapsed > 0.0 ? static_cast<double>(num_steps) / elapsed : 0.0) << "\n"
+                  << "kinetic energy: " << simulation.kinetic_energy() << "\n"
+                  << "momentum: " << simulation.momentum()->to_string() << "\n"
+                  << "center of mass: " << simulation.center_of_mass()->to_string() << "\n"
+                  << "last step contacts: " << collisions.contacts << " of " << collisions.candidate_pairs << " candidate pairs\n"
+                  << "last step bodies: " << sleep.awake << " awake, " << sleep.asleep << " asleep\n"
+                  << "mean awake bodies: " << (num_steps > 0 ? static_cast<double>(awake_body_steps) / static_cast<double>(num_steps) : 0.0)
+                  << std::endl;
+        if (sweep_settings.enabled) {
+            const ContinuousCollisionStats& swept = simulation.get_continuous_collision_stats();
+            std::cout << "last step swept: " << swept.fast << " fast bodies, " << swept.ball_impacts << " ball and "
+                      << swept.wall_impacts << " wall impacts in " << swept.passes << " passes" << std::endl;
+        }
+        if (!simulation.get_obstacles().empty()) {
+            const ObstacleStats& obstacles = simulation.get_obstacle_stats();
+            std::cout << "obstacles: " << simulation.get_obstacles().get_segments().size() << " segments in "
+                      << simulation.get_obstacles().get_node_count() << " BVH nodes, last step " << obstacles.contacts
+                      << " contacts of " << obstacles.segment_tests << " segment tests" << std::endl;
+        }
+        if (simulation.get_contact_colors() > 0) {
+            std::cout << "last step contact colors: " << simulation.get_contact_colors() << std::endl;
+        }
+        if (!scene_path.empty()) {
+            std::cout << "scene: " << scene_path << " loaded in " << scene_time * 1000.0 << " ms" << std::endl;
+        }
+        if (!restore_path.empty()) {
+            std::cout << "restored from: " << restore_path << " at step " << first_step << " in " << restore_time * 1000.0 << " ms\n";
+        }
+        if (recorder != nullptr) {
+            std::cout << "trajectory frames: " << recorder->get_frames_written() << ", " << recorder->get_bytes_written() / 1e6
+                      << " MB, " << recorder->get_stalls() << " steps waited on the writer" << std::endl;
+        }
+        if (!checkpoint_path.empty()) {
+            std::cout << "checkpoints written: " << checkpoints.get_saved_count() << " (" << checkpoints_skipped
+                      << " skipped while the writer was busy), last at step " << simulation.get_step_count() << std::endl;
+        }
+        if ((profile || !profile_trace_path.empty()) && !Profiler::enabled()) {
+            std::cout << "profile: no scopes were compiled in, configure with -DPHYSICS_PROFILE=ON" << std::endl;
+        } else {
+            // The rings keep the last Profiler::RING_CAPACITY scopes of each thread, so long runs report their end.
+            if (profile) print_profile();
+            if (!profile_trace_path.empty()) {
+                Profiler::instance().write_chrome_trace(profile_trace_path);
+                std::cout << "profile trace: " << profile_trace_path << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        print_usage(argv[0]);
+        return 1;
+    }
+    return 0;
+}
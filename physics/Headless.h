@@ -0,0 +1,10 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Runs the simulation without a window, as fast as possible, and prints the throughput and the final state.
+// The options are listed by print_usage in Headless.cpp, which --help prints.
+// Returns the process exit code.
+int run_headless(int argc, char** argv);
+
+
+#endif // HEADLESS_H
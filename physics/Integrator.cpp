@@ -0,0 +1,148 @@
+#include "Integrator.h"
+#include "BlockTimestep.h"
+
+namespace {
+
+// x += v h for every awake particle.
+void drift(ParticleSystem& particles, const double h) {
+    const std::size_t n = particles.size();
+    double* x = particles.x.data();
+    double* y = particles.y.data();
+    const double* vx = particles.vx.data();
+    const double* vy = particles.vy.data();
+    const char* asleep = particles.asleep.data();
+    for (std::size_t i = 0; i < n; ++i) {
+        if (asleep[i]) continue;
+        x[i] += vx[i] * h;
+        y[i] += vy[i] * h;
+    }
+}
+
+// v += a h for every awake particle.
+void kick(ParticleSystem& particles, const double h) {
+    const std::size_t n = particles.size();
+    double* vx = particles.vx.data();
+    double* vy = particles.vy.data();
+    const double* ax = particles.ax.data();
+    const double* ay = particles.ay.data();
+    const char* asleep = particles.asleep.data();
+    for (std::size_t i = 0; i < n; ++i) {
+        if (asleep[i]) continue;
+        vx[i] += ax[i] * h;
+        vy[i] += ay[i] * h;
+    }
+}
+
+} // namespace
+
+
+const char* SemiImplicitEuler::name() {
+    return "euler";
+}
+
+void SemiImplicitEuler::step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) {
+    gravity.compute(particles);
+    particles.integrate(delta_time);
+}
+
+
+const char* Leapfrog::name() {
+    return "leapfrog";
+}
+
+void Leapfrog::step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) {
+    drift(particles, 0.5 * delta_time);
+    gravity.compute(particles);
+    kick(particles, delta_time);
+    drift(particles, 0.5 * delta_time);
+}
+
+
+const char* Yoshida4::name() {
+    return "yoshida4";
+}
+
+void Yoshida4::step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) {
+    // w1 = 1 / (2 - 2^(1/3)), w0 = 1 - 2 w1: a leapfrog forward, a longer one backward, a leapfrog forward.
+    const double cube_root_two = std::cbrt(2.0);
+    const double w1 = 1.0 / (2.0 - cube_root_two);
+    const double w0 = -cube_root_two * w1;
+    const double c1 = 0.5 * w1;
+    const double c2 = 0.5 * (w0 + w1);
+
+    drift(particles, c1 * delta_time);
+    gravity.compute(particles);
+    kick(particles, w1 * delta_time);
+    drift(particles, c2 * delta_time);
+    gravity.compute(particles);
+    kick(particles, w0 * delta_time);
+    drift(particles, c2 * delta_time);
+    gravity.compute(particles);
+    kick(particles, w1 * delta_time);
+    drift(particles, c1 * delta_time);
+}
+
+
+const char* RungeKutta4::name() {
+    return "rk4";
+}
+
+void RungeKutta4::step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) {
+    const std::size_t n = particles.size();
+    x0.assign(particles.x.begin(), particles.x.end());
+    y0.assign(particles.y.begin(), particles.y.end());
+    vx0.assign(particles.vx.begin(), particles.vx.end());
+    vy0.assign(particles.vy.begin(), particles.vy.end());
+    sum_x.assign(n, 0.0);
+    sum_y.assign(n, 0.0);
+    sum_vx.assign(n, 0.0);
+    sum_vy.assign(n, 0.0);
+    const char* asleep = particles.asleep.data();
+
+    // Stage k evaluates the derivative at the current (x, v), adds it to the sums with its weight, then moves
+    // (x, v) to x0 + h_next * v_k, v0 + h_next * a_k for the next stage.
+    const double weights[4] = {1.0, 2.0, 2.0, 1.0};
+    const double next_offsets[4] = {0.5 * delta_time, 0.5 * delta_time, delta_time, 0.0};
+    for (int stage = 0; stage < 4; ++stage) {
+        gravity.compute(particles);
+        const double w = weights[stage];
+        const double h = next_offsets[stage];
+        for (std::size_t i = 0; i < n; ++i) {
+            if (asleep[i]) continue;
+            const double vx = particles.vx[i];
+            const double vy = particles.vy[i];
+            sum_x[i] += w * vx;
+            sum_y[i] += w * vy;
+            sum_vx[i] += w * particles.ax[i];
+            sum_vy[i] += w * particles.ay[i];
+            particles.x[i] = x0[i] + h * vx;
+            particles.y[i] = y0[i] + h * vy;
+            particles.vx[i] = vx0[i] + h * particles.ax[i];
+            particles.vy[i] = vy0[i] + h * particles.ay[i];
+        }
+    }
+
+    const double sixth = delta_time / 6.0;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (asleep[i]) continue;
+        particles.x[i] = x0[i] + sixth * sum_x[i];
+        particles.y[i] = y0[i] + sixth * sum_y[i];
+        particles.vx[i] = vx0[i] + sixth * sum_vx[i];
+        particles.vy[i] = vy0[i] + sixth * sum_vy[i];
+    }
+}
+
+
+const std::vector<std::string>& integrator_names() {
+    static const std::vector<std::string> names = {"euler", "leapfrog", "yoshida4", "rk4", "block"};
+    return names;
+}
+
+std::shared_ptr<Integrator> make_integrator(const std::string& name) {
+    if (name == "euler") return std::make_shared<PolicyIntegrator<SemiImplicitEuler>>();
+    if (name == "leapfrog" || name == "verlet") return std::make_shared<PolicyIntegrator<Leapfrog>>();
+    if (name == "yoshida4") return std::make_shared<PolicyIntegrator<Yoshida4>>();
+    if (name == "rk4") return std::make_shared<PolicyIntegrator<RungeKutta4>>();
+    if (name == "block") return std::make_shared<BlockTimestepIntegrator>();
+    throw std::invalid_argument("Unknown integrator: " + name);
+}
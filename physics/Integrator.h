@@ -0,0 +1,78 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+
+#include "ParticleSystem.h"
+#include "Gravity.h"
+
+// Advances positions and velocities by one step, evaluating the gravity as many times as the scheme needs.
+// Sleeping particles are left where they are. Boundaries and collisions are applied afterwards by the
+// simulation, outside the integrator.
+class Integrator {
+    public:
+        virtual ~Integrator() = default;
+        virtual const char* name() const = 0;
+        // Gravity evaluations of the whole system per step, the dominant cost of every scheme. Adaptive schemes
+        // report the equivalent for their last step: the evaluated bodies divided by the number of bodies.
+        virtual double force_evaluations() const = 0;
+        virtual void step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) = 0;
+};
+
+// The integration schemes, used as compile-time policies of PolicyIntegrator.
+
+// First order, symplectic: v += a dt, then x += v dt. The scheme of Circle::update_physics.
+struct SemiImplicitEuler {
+    static constexpr int FORCE_EVALUATIONS = 1;
+    static const char* name();
+    void step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time);
+};
+
+// Second order, symplectic drift-kick-drift leapfrog (position Verlet). One evaluation per step, like Euler.
+struct Leapfrog {
+    static constexpr int FORCE_EVALUATIONS = 1;
+    static const char* name();
+    void step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time);
+};
+
+// Fourth order, symplectic: Yoshida's composition of three leapfrog steps.
+struct Yoshida4 {
+    static constexpr int FORCE_EVALUATIONS = 3;
+    static const char* name();
+    void step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time);
+};
+
+// Classic fourth order Runge-Kutta. Accurate per step, but not symplectic, so its energy error drifts.
+class RungeKutta4 {
+    private:
+        // State at the start of the step and the weighted sums of the four stages.
+        std::vector<double> x0, y0, vx0, vy0;
+        std::vector<double> sum_x, sum_y, sum_vx, sum_vy;
+
+    public:
+        static constexpr int FORCE_EVALUATIONS = 4;
+        static const char* name();
+        void step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time);
+};
+
+// Binds one scheme at compile time: the only dynamic dispatch is the virtual step() once per simulation
+// step, the loops inside the scheme have no per-particle branch on the integrator.
+template <typename Policy>
+class PolicyIntegrator : public Integrator {
+    private:
+        Policy policy;
+
+    public:
+        const char* name() const override { return Policy::name(); }
+        double force_evaluations() const override { return Policy::FORCE_EVALUATIONS; }
+        void step(ParticleSystem& particles, GravitySolver& gravity, const double delta_time) override {
+            policy.step(particles, gravity, delta_time);
+        }
+};
+
+// Names accepted by make_integrator: the fixed-step schemes in increasing order of cost per step, then the
+// adaptive block timesteps.
+const std::vector<std::string>& integrator_names();
+// "euler", "leapfrog" (or "verlet"), "yoshida4", "rk4" or "block" (BlockTimestepIntegrator). Throws std::invalid_argument for an unknown name.
+std::shared_ptr<Integrator> make_integrator(const std::string& name);
+
+
+#endif // INTEGRATOR_H
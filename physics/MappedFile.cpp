@@ -0,0 +1,89 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path) {
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        throw std::runtime_error("Cannot open " + path);
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        close();
+        throw std::runtime_error("Cannot read the size of " + path);
+    }
+    length = static_cast<std::size_t>(file_size.QuadPart);
+    // An empty file cannot be mapped; it maps to an empty range instead.
+    if (length == 0) return;
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping != nullptr) bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (bytes == nullptr) {
+        close();
+        throw std::runtime_error("Cannot map " + path);
+    }
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) UnmapViewOfFile(bytes);
+    if (mapping != nullptr) CloseHandle(mapping);
+    if (file != nullptr) CloseHandle(file);
+    bytes = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path) {
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0) {
+        close();
+        throw std::runtime_error("Cannot read the size of " + path);
+    }
+    length = static_cast<std::size_t>(status.st_size);
+    // An empty file cannot be mapped; it maps to an empty range instead.
+    if (length == 0) return;
+    void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (address == MAP_FAILED) {
+        close();
+        throw std::runtime_error("Cannot map " + path);
+    }
+    bytes = static_cast<const char*>(address);
+    // The readers stream through the file front to back.
+    ::madvise(address, length, MADV_SEQUENTIAL);
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) ::munmap(const_cast<char*>(bytes), length);
+    if (descriptor >= 0) ::close(descriptor);
+    bytes = nullptr;
+    descriptor = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+const char* MappedFile::data() const {
+    return bytes;
+}
+
+std::size_t MappedFile::size() const {
+    return length;
+}
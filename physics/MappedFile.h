@@ -0,0 +1,33 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// A whole file mapped read-only into memory. Pages are read in by the kernel on first touch, so opening a large
+// file costs no copy and no parsing. Throws std::runtime_error if the file cannot be opened or mapped.
+class MappedFile {
+    private:
+        const char* bytes = nullptr;
+        std::size_t length = 0;
+#ifdef _WIN32
+        void* file = nullptr;
+        void* mapping = nullptr;
+#else
+        int descriptor = -1;
+#endif
+
+        void close();
+
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        const char* data() const;
+        std::size_t size() const;
+};
+
+
+#endif // MAPPED_FILE_H
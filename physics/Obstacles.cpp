@@ -0,0 +1,172 @@
+#include "Obstacles.h"
+#include <algorithm>
+#include <limits>
+
+constexpr std::uint32_t StaticObstacles::LEAF_SIZE;
+constexpr std::size_t StaticObstacles::MAX_DEPTH;
+
+void StaticObstacles::add(const Segment& segment) {
+    segments.push_back(segment);
+    built = false;
+}
+
+void StaticObstacles::add(const std::shared_ptr<Line> line) {
+    add({line->get_start()->to_vec2(), line->get_end()->to_vec2()});
+}
+
+void StaticObstacles::add(const std::shared_ptr<Triangle> triangle) {
+    const Vec2 a = triangle->get_p1()->to_vec2();
+    const Vec2 b = triangle->get_p2()->to_vec2();
+    const Vec2 c = triangle->get_p3()->to_vec2();
+    add({a, b});
+    add({b, c});
+    add({c, a});
+}
+
+void StaticObstacles::add(const std::shared_ptr<Rectangle> rectangle) {
+    const Vec2 corners[4] = {rectangle->get_upper_left()->to_vec2(), rectangle->get_upper_right()->to_vec2(),
+                             rectangle->get_lower_right()->to_vec2(), rectangle->get_lower_left()->to_vec2()};
+    for (int k = 0; k < 4; ++k) {
+        add({corners[k], corners[(k + 1) % 4]});
+    }
+}
+
+void StaticObstacles::clear() {
+    segments.clear();
+    nodes.clear();
+    built = true;
+}
+
+bool StaticObstacles::empty() const {
+    return segments.empty();
+}
+
+const std::vector<Segment>& StaticObstacles::get_segments() const {
+    return segments;
+}
+
+std::size_t StaticObstacles::get_node_count() const {
+    return nodes.size();
+}
+
+void StaticObstacles::build() {
+    nodes.clear();
+    if (!segments.empty()) {
+        nodes.reserve(2 * (segments.size() / LEAF_SIZE + 1));
+        build_node(0, static_cast<std::uint32_t>(segments.size()));
+    }
+    built = true;
+}
+
+void StaticObstacles::build_node(const std::uint32_t first, const std::uint32_t count) {
+    const std::size_t index = nodes.size();
+    Node node = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max(),
+                 std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest(), first, count, 0};
+    double center_min_x = std::numeric_limits<double>::max();
+    double center_min_y = std::numeric_limits<double>::max();
+    double center_max_x = std::numeric_limits<double>::lowest();
+    double center_max_y = std::numeric_limits<double>::lowest();
+    for (std::uint32_t k = first; k < first + count; ++k) {
+        const Segment& segment = segments[k];
+        node.min_x = std::min({node.min_x, segment.start.x, segment.end.x});
+        node.min_y = std::min({node.min_y, segment.start.y, segment.end.y});
+        node.max_x = std::max({node.max_x, segment.start.x, segment.end.x});
+        node.max_y = std::max({node.max_y, segment.start.y, segment.end.y});
+        const Vec2 center = segment.start.mid_point_to(segment.end);
+        center_min_x = std::min(center_min_x, center.x);
+        center_min_y = std::min(center_min_y, center.y);
+        center_max_x = std::max(center_max_x, center.x);
+        center_max_y = std::max(center_max_y, center.y);
+    }
+    nodes.push_back(node);
+    if (count <= LEAF_SIZE) return;
+
+    // Median split along the longer side of the segment centers, so the tree stays balanced whatever the layout.
+    nodes[index].count = 0;
+    const bool along_x = center_max_x - center_min_x >= center_max_y - center_min_y;
+    const std::uint32_t half = count / 2;
+    std::nth_element(segments.begin() + first, segments.begin() + first + half, segments.begin() + first + count,
+                     [along_x](const Segment& p, const Segment& q) {
+                         return along_x ? p.start.x + p.end.x < q.start.x + q.end.x : p.start.y + p.end.y < q.start.y + q.end.y;
+                     });
+    build_node(first, half);
+    nodes[index].child = static_cast<std::uint32_t>(nodes.size());
+    build_node(first + half, count - half);
+}
+
+std::size_t StaticObstacles::collide(ParticleSystem& particles, const std::size_t i, const double diminishing_factor, const double slop,
+                                     std::size_t& contacts, bool& resting) const {
+    const double r = particles.radius[i];
+    const double reach = r + slop;
+    Vec2 p(particles.x[i], particles.y[i]);
+    Vec2 v(particles.vx[i], particles.vy[i]);
+    const double min_x = p.x - reach;
+    const double min_y = p.y - reach;
+    const double max_x = p.x + reach;
+    const double max_y = p.y + reach;
+    std::size_t tests = 0;
+
+    std::uint32_t stack[MAX_DEPTH];
+    std::size_t depth = 0;
+    std::uint32_t current = 0;
+    while (true) {
+        const Node& node = nodes[current];
+        if (node.max_x >= min_x && node.min_x <= max_x && node.max_y >= min_y && node.min_y <= max_y) {
+            if (node.count == 0) {
+                stack[depth++] = node.child;
+                current = current + 1;
+                continue;
+            }
+            for (std::uint32_t k = node.first; k < node.first + node.count; ++k) {
+                ++tests;
+                const Vec2 a = segments[k].start;
+                const Vec2 d = segments[k].end - a;
+                const double length_squared = d.length_squared();
+                const double t = length_squared > 0.0 ? std::min(1.0, std::max(0.0, (p - a).dot(d) / length_squared)) : 0.0;
+                const Vec2 delta = p - (a + d * t);
+                const double distance_squared = delta.length_squared();
+                if (distance_squared >= reach * reach) continue;
+                resting = true;
+                if (distance_squared >= r * r) continue;
+
+                // Out along the normal from the closest point, or for a center right on the segment, back to
+                // the side the ball came from.
+                const double distance = std::sqrt(distance_squared);
+                Vec2 normal;
+                if (distance > 0.0) {
+                    normal = delta / distance;
+                } else {
+                    normal = length_squared > 0.0 ? d.perpendicular().normalized() : Vec2(0.0, 1.0);
+                    if (normal.dot(v) > 0.0) normal = -normal;
+                }
+                p += normal * (r - distance);
+                const double normal_speed = v.dot(normal);
+                if (normal_speed < 0.0) v -= normal * ((1.0 + diminishing_factor) * normal_speed);
+                ++contacts;
+            }
+        }
+        if (depth == 0) break;
+        current = stack[--depth];
+    }
+
+    particles.x[i] = p.x;
+    particles.y[i] = p.y;
+    particles.vx[i] = v.x;
+    particles.vy[i] = v.y;
+    return tests;
+}
+
+ObstacleStats StaticObstacles::resolve(ParticleSystem& particles, const double diminishing_factor, SleepSystem* sleep) {
+    ObstacleStats stats;
+    if (!built) build();
+    if (nodes.empty()) return stats;
+    const bool sleeping = sleep != nullptr && sleep->get_settings().enabled;
+    const double slop = sleeping ? sleep->get_settings().contact_slop : 0.0;
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        if (particles.asleep[i]) continue;
+        bool resting = false;
+        stats.segment_tests += collide(particles, i, diminishing_factor, slop, stats.contacts, resting);
+        if (resting && sleeping) sleep->support(i);
+    }
+    return stats;
+}
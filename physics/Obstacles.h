@@ -0,0 +1,66 @@
+#ifndef OBSTACLES_H
+#define OBSTACLES_H
+
+#include <cstdint>
+#include "ParticleSystem.h"
+#include "Sleep.h"
+#include "../shapes/Triangle.h"
+#include "../shapes/SegmentIntersection.h"
+
+// Per-frame counters of the obstacle pass.
+struct ObstacleStats {
+    std::size_t segment_tests = 0;       // ball-segment pairs that reached the narrowphase
+    std::size_t contacts = 0;
+};
+
+// Static obstacles the balls bounce off besides the boundaries: Line segments and the edges of Triangles and
+// (possibly rotated) Rectangles. The shapes are copied into segments when added, so moving a shape afterwards
+// does not move its obstacle; clear and add it again instead. The segments are indexed once in a bounding
+// volume hierarchy, rebuilt on the first pass after an add, and each ball only tests the segments of the
+// leaves its bounding box overlaps. A touching ball is pushed out along the normal from the closest point of the
+// segment, and the normal part of its velocity is reflected and damped as at a wall. Only the overlap at the end
+// of the step is resolved, so a ball moving farther than its radius in a step can pass through a thin obstacle.
+class StaticObstacles {
+    private:
+        // Segments per leaf; the tree is a few levels shallower than one segment per leaf and the leaves are
+        // scanned linearly.
+        static constexpr std::uint32_t LEAF_SIZE = 4;
+        // Deeper than any tree a median split builds from 2^32 segments.
+        static constexpr std::size_t MAX_DEPTH = 64;
+
+        // Inner nodes have count == 0, their first child right after them and the second at child.
+        struct Node {
+            double min_x, min_y, max_x, max_y;
+            std::uint32_t first;                 // first segment of a leaf
+            std::uint32_t count;
+            std::uint32_t child;
+        };
+
+        std::vector<Segment> segments;           // in leaf order once built
+        std::vector<Node> nodes;
+        bool built = true;
+
+        void build_node(const std::uint32_t first, const std::uint32_t count);
+        // Pushes ball i out of the segments it overlaps. Returns the number of segments tested.
+        std::size_t collide(ParticleSystem& particles, const std::size_t i, const double diminishing_factor, const double slop,
+                            std::size_t& contacts, bool& resting) const;
+
+    public:
+        void add(const Segment& segment);
+        void add(const std::shared_ptr<Line> line);
+        void add(const std::shared_ptr<Triangle> triangle);
+        void add(const std::shared_ptr<Rectangle> rectangle);
+        void clear();
+        bool empty() const;
+        const std::vector<Segment>& get_segments() const;
+        std::size_t get_node_count() const;
+
+        // Builds the hierarchy now instead of on the next pass.
+        void build();
+        // Resolves the overlaps of every awake ball with the obstacles. With a sleep system, balls resting on an
+        // obstacle count as supported, as on a wall.
+        ObstacleStats resolve(ParticleSystem& particles, const double diminishing_factor, SleepSystem* sleep = nullptr);
+};
+
+
+#endif // OBSTACLES_H
@@ -0,0 +1,248 @@
+#include "ParticleMesh.h"
+#include <algorithm>
+#include "Profiler.h"
+
+namespace {
+
+// Short-range share of the force at distance r for the split scale r_s.
+double split_function(const double r, const double r_s) {
+    const double u = r / (2.0 * r_s);
+    return std::erfc(u) + (r / (r_s * std::sqrt(M_PI))) * std::exp(-u * u);
+}
+
+const std::size_t SPLIT_TABLE_SIZE = 4096;
+
+// Mesh nodes and weights of one particle along one axis: up to three nodes starting at first.
+struct AxisWeights {
+    long first;
+    int count;
+    double w[3];
+};
+
+inline AxisWeights axis_weights(const MassAssignment assignment, const double u) {
+    AxisWeights a;
+    if (assignment == MassAssignment::CIC) {
+        double cell = std::floor(u);
+        double f = u - cell;
+        a.first = static_cast<long>(cell);
+        a.count = 2;
+        a.w[0] = 1.0 - f;
+        a.w[1] = f;
+    } else {
+        double node = std::floor(u + 0.5);
+        double d = u - node;
+        a.first = static_cast<long>(node) - 1;
+        a.count = 3;
+        a.w[0] = 0.5 * (0.5 - d) * (0.5 - d);
+        a.w[1] = 0.75 - d * d;
+        a.w[2] = 0.5 * (0.5 + d) * (0.5 + d);
+    }
+    return a;
+}
+
+} // namespace
+
+
+ParticleMeshGravity::ParticleMeshGravity(const double G, const std::size_t mesh_size, const MassAssignment assignment,
+                                         const bool short_range, std::shared_ptr<ThreadPool> pool)
+    : GravitySolver(G), mesh_size(mesh_size), assignment(assignment), short_range(short_range), pool(pool), fft(2 * std::max<std::size_t>(mesh_size, 1)) {
+    if (mesh_size < 16 || (mesh_size & (mesh_size - 1)) != 0) {
+        throw std::invalid_argument("Mesh size must be a power of two of at least 16");
+    }
+}
+
+std::size_t ParticleMeshGravity::get_mesh_size() const {
+    return mesh_size;
+}
+
+MassAssignment ParticleMeshGravity::get_assignment() const {
+    return assignment;
+}
+
+bool ParticleMeshGravity::has_short_range() const {
+    return short_range;
+}
+
+void ParticleMeshGravity::build_kernel(const double cell_size) {
+    const std::size_t padded = 2 * mesh_size;
+    const long reach = static_cast<long>(mesh_size) - 1;
+    const double r_s = SPLIT_SCALE * cell_size;
+
+    // Acceleration at node p from a unit mass at node q is kernel(p - q) = K(q - p) = -K(p - q), K(r) = r / |r|^3.
+    kernel.assign(padded * padded, FFT::Complex(0.0, 0.0));
+    for (long dj = -reach; dj <= reach; ++dj) {
+        for (long di = -reach; di <= reach; ++di) {
+            if (di == 0 && dj == 0) continue;
+            const double dx = static_cast<double>(di) * cell_size;
+            const double dy = static_cast<double>(dj) * cell_size;
+            const double r = std::sqrt(dx * dx + dy * dy);
+            const double clamped = std::max(r, 1.0);
+            double factor = 1.0 / (clamped * clamped * clamped);
+            if (short_range) factor *= 1.0 - split_function(r, r_s);
+            const std::size_t row = static_cast<std::size_t>((dj + static_cast<long>(padded)) % static_cast<long>(padded));
+            const std::size_t column = static_cast<std::size_t>((di + static_cast<long>(padded)) % static_cast<long>(padded));
+            kernel[row * padded + column] = FFT::Complex(-factor * dx, -factor * dy);
+        }
+    }
+    fft.transform_2d(kernel, false, pool.get());
+
+    if (short_range) {
+        const double cutoff = SHORT_RANGE_CUTOFF * cell_size;
+        split_table.resize(SPLIT_TABLE_SIZE + 1);
+        for (std::size_t k = 0; k <= SPLIT_TABLE_SIZE; ++k) {
+            double r2 = cutoff * cutoff * static_cast<double>(k) / static_cast<double>(SPLIT_TABLE_SIZE);
+            split_table[k] = split_function(std::sqrt(r2), r_s);
+        }
+    }
+    kernel_cell_size = cell_size;
+}
+
+void ParticleMeshGravity::compute(ParticleSystem& particles) {
+    PROFILE_SCOPE("gravity");
+    const std::size_t n = particles.size();
+    if (n == 0) return;
+
+    double min_x = particles.x[0], max_x = particles.x[0];
+    double min_y = particles.y[0], max_y = particles.y[0];
+    for (std::size_t i = 1; i < n; ++i) {
+        min_x = std::min(min_x, particles.x[i]);
+        max_x = std::max(max_x, particles.x[i]);
+        min_y = std::min(min_y, particles.y[i]);
+        max_y = std::max(max_y, particles.y[i]);
+    }
+
+    // Two nodes of margin on every side keep the TSC stencil of the outermost particles on the mesh. The cell size
+    // is rounded up to a power of 2^(1/8), so a slowly growing scene reuses the transformed kernel for many steps.
+    const double extent = std::max(std::max(max_x - min_x, max_y - min_y), 1.0);
+    const double fitted = extent / static_cast<double>(mesh_size - 5);
+    const double cell_size = std::exp2(std::ceil(8.0 * std::log2(fitted)) / 8.0);
+    if (cell_size != kernel_cell_size) build_kernel(cell_size);
+
+    const std::size_t padded = 2 * mesh_size;
+    const double origin_x = min_x - 2.0 * cell_size;
+    const double origin_y = min_y - 2.0 * cell_size;
+
+    field.assign(padded * padded, FFT::Complex(0.0, 0.0));
+    for (std::size_t i = 0; i < n; ++i) {
+        AxisWeights wx = axis_weights(assignment, (particles.x[i] - origin_x) / cell_size);
+        AxisWeights wy = axis_weights(assignment, (particles.y[i] - origin_y) / cell_size);
+        for (int b = 0; b < wy.count; ++b) {
+            FFT::Complex* row = field.data() + static_cast<std::size_t>(wy.first + b) * padded;
+            for (int a = 0; a < wx.count; ++a) {
+                row[wx.first + a] += particles.mass[i] * wy.w[b] * wx.w[a];
+            }
+        }
+    }
+
+    // The mesh accelerations: x in the real part, y in the imaginary part of one complex convolution.
+    fft.transform_2d(field, false, pool.get());
+    for (std::size_t k = 0; k < field.size(); ++k) field[k] *= kernel[k];
+    fft.transform_2d(field, true, pool.get());
+
+    const double scale = G / static_cast<double>(padded * padded);
+    auto interpolate = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            AxisWeights wx = axis_weights(assignment, (particles.x[i] - origin_x) / cell_size);
+            AxisWeights wy = axis_weights(assignment, (particles.y[i] - origin_y) / cell_size);
+            double ax = 0.0;
+            double ay = 0.0;
+            for (int b = 0; b < wy.count; ++b) {
+                const FFT::Complex* row = field.data() + static_cast<std::size_t>(wy.first + b) * padded;
+                for (int a = 0; a < wx.count; ++a) {
+                    const double w = wy.w[b] * wx.w[a];
+                    ax += w * row[wx.first + a].real();
+                    ay += w * row[wx.first + a].imag();
+                }
+            }
+            particles.ax[i] = scale * ax;
+            particles.ay[i] = scale * ay;
+        }
+    };
+    if (pool == nullptr || pool->size() == 1) {
+        interpolate(0, n, 0);
+    } else {
+        pool->parallel_for(n, std::max<std::size_t>(256, n / (pool->size() * 8)), interpolate);
+    }
+
+    if (short_range) add_short_range(particles, cell_size, min_x, min_y, max_x, max_y);
+}
+
+void ParticleMeshGravity::add_short_range(ParticleSystem& particles, const double cell_size, const double min_x,
+                                          const double min_y, const double max_x, const double max_y) {
+    const std::size_t n = particles.size();
+    const double cutoff = SHORT_RANGE_CUTOFF * cell_size;
+    const double cutoff_squared = cutoff * cutoff;
+    const double table_scale = static_cast<double>(SPLIT_TABLE_SIZE) / cutoff_squared;
+    const std::size_t columns = static_cast<std::size_t>((max_x - min_x) / cutoff) + 1;
+    const std::size_t rows = static_cast<std::size_t>((max_y - min_y) / cutoff) + 1;
+
+    // Counting sort of the bodies into cutoff-sized cells, with their coordinates and masses copied in cell
+    // order: the three neighbor cells of a row are then one contiguous run of memory.
+    auto cell_of = [&](const std::size_t i) {
+        std::size_t column = std::min(columns - 1, static_cast<std::size_t>((particles.x[i] - min_x) / cutoff));
+        std::size_t row = std::min(rows - 1, static_cast<std::size_t>((particles.y[i] - min_y) / cutoff));
+        return row * columns + column;
+    };
+    cell_start.assign(columns * rows + 1, 0);
+    for (std::size_t i = 0; i < n; ++i) ++cell_start[cell_of(i) + 1];
+    for (std::size_t c = 0; c < columns * rows; ++c) cell_start[c + 1] += cell_start[c];
+    cell_bodies.resize(n);
+    sorted_x.resize(n);
+    sorted_y.resize(n);
+    sorted_mass.resize(n);
+    {
+        std::vector<std::uint32_t> fill(cell_start.begin(), cell_start.end() - 1);
+        for (std::size_t i = 0; i < n; ++i) {
+            std::uint32_t k = fill[cell_of(i)]++;
+            cell_bodies[k] = static_cast<std::uint32_t>(i);
+            sorted_x[k] = particles.x[i];
+            sorted_y[k] = particles.y[i];
+            sorted_mass[k] = particles.mass[i];
+        }
+    }
+
+    // One task per cell row; every body of a cell is a target against the 3 x 3 neighboring cells.
+    auto accumulate = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t row = begin; row < end; ++row) {
+            const std::size_t first_row = row > 0 ? row - 1 : 0;
+            const std::size_t last_row = std::min(rows - 1, row + 1);
+            for (std::size_t column = 0; column < columns; ++column) {
+                const std::size_t first_column = column > 0 ? column - 1 : 0;
+                const std::size_t last_column = std::min(columns - 1, column + 1);
+                const std::size_t cell = row * columns + column;
+                for (std::uint32_t t = cell_start[cell]; t < cell_start[cell + 1]; ++t) {
+                    const double xi = sorted_x[t];
+                    const double yi = sorted_y[t];
+                    double ax = 0.0;
+                    double ay = 0.0;
+                    for (std::size_t r = first_row; r <= last_row; ++r) {
+                        const std::uint32_t run_end = cell_start[r * columns + last_column + 1];
+                        for (std::uint32_t k = cell_start[r * columns + first_column]; k < run_end; ++k) {
+                            const double dx = sorted_x[k] - xi;
+                            const double dy = sorted_y[k] - yi;
+                            const double r2 = dx * dx + dy * dy;
+                            if (r2 >= cutoff_squared || k == t) continue;
+                            // Linear interpolation of S in r^2 between the table samples.
+                            const double u = r2 * table_scale;
+                            const std::size_t index = static_cast<std::size_t>(u);
+                            const double f = u - static_cast<double>(index);
+                            const double split = split_table[index] + f * (split_table[index + 1] - split_table[index]);
+                            const double clamped = std::max(std::sqrt(r2), 1.0);
+                            const double s = sorted_mass[k] * split / (clamped * clamped * clamped);
+                            ax += s * dx;
+                            ay += s * dy;
+                        }
+                    }
+                    const std::uint32_t i = cell_bodies[t];
+                    particles.ax[i] += G * ax;
+                    particles.ay[i] += G * ay;
+                }
+            }
+        }
+    };
+    if (pool == nullptr || pool->size() == 1) {
+        accumulate(0, rows, 0);
+    } else {
+        pool->parallel_for(rows, std::max<std::size_t>(1, rows / (pool->size() * 8)), accumulate);
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef PARTICLE_MESH_H
+#define PARTICLE_MESH_H
+
+#include "Gravity.h"
+#include "FFT.h"
+
+// How particle masses are spread over the mesh nodes, and the field read back from them.
+enum class MassAssignment {
+    CIC,    // cloud-in-cell: the 2 x 2 nearest nodes, bilinear weights
+    TSC     // triangular-shaped cloud: the 3 x 3 nearest nodes, smoother and less noisy
+};
+
+// Particle-mesh gravity in O(n + M^2 log M) for an M x M mesh.
+//
+// The masses are deposited on a square mesh around the bounding box of the particles. The mesh is convolved
+// with the force kernel of compute_gravity, G r / max(|r|, 1)^3, through an FFT, and the mesh accelerations
+// are interpolated back with the same weights. The law is the softened 1/r^2 of the rest of the engines, not the
+// 2D Poisson kernel. The mesh is zero-padded to 2M x 2M, so the convolution is not periodic and there are no
+// image forces.
+//
+// On its own the mesh resolves nothing below a few cells. With the short-range correction the kernel is split
+// as in TreePM codes. The mesh carries the smooth long-range part, 1 - S(r) with
+// S(r) = erfc(r / 2 r_s) + r / (r_s sqrt(pi)) exp(-r^2 / 4 r_s^2), and r_s = 1.25 cells. The short-range part,
+// S(r) times the exact law, is summed directly over the neighbors closer than 4.5 r_s. The two parts add up to
+// compute_gravity's force to within the mesh's interpolation error.
+class ParticleMeshGravity : public GravitySolver {
+    public:
+        // r_s, and the reach of the short-range sum, in cells.
+        static constexpr double SPLIT_SCALE = 1.25;
+        static constexpr double SHORT_RANGE_CUTOFF = 4.5 * SPLIT_SCALE;
+
+    private:
+        std::size_t mesh_size;
+        MassAssignment assignment;
+        bool short_range;
+        std::shared_ptr<ThreadPool> pool;
+        FFT fft;
+
+        // The transformed kernel only depends on the cell size, which is quantized so it rarely changes.
+        double kernel_cell_size = 0.0;
+        std::vector<FFT::Complex> kernel;
+        std::vector<FFT::Complex> field;
+
+        // S(r) sampled uniformly in r^2 up to the cutoff, for the short-range pass.
+        std::vector<double> split_table;
+        // Cell lists of the short-range pass.
+        std::vector<std::uint32_t> cell_start;
+        std::vector<std::uint32_t> cell_bodies;
+        std::vector<double> sorted_x;
+        std::vector<double> sorted_y;
+        std::vector<double> sorted_mass;
+
+        void build_kernel(const double cell_size);
+        void add_short_range(ParticleSystem& particles, const double cell_size, const double min_x, const double min_y,
+                             const double max_x, const double max_y);
+
+    public:
+        // mesh_size is the number of nodes per side, a power of two of at least 16.
+        explicit ParticleMeshGravity(const double G, const std::size_t mesh_size = 256,
+                                     const MassAssignment assignment = MassAssignment::CIC, const bool short_range = true,
+                                     std::shared_ptr<ThreadPool> pool = nullptr);
+        std::size_t get_mesh_size() const;
+        MassAssignment get_assignment() const;
+        bool has_short_range() const;
+        void compute(ParticleSystem& particles) override;
+};
+
+
+#endif // PARTICLE_MESH_H
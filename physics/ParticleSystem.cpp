@@ -0,0 +1,221 @@
+#include "ParticleSystem.h"
+#include "Profiler.h"
+
+CircleView::CircleView(ParticleSystem* system, std::size_t index) : system(system), index(index) {}
+
+std::size_t CircleView::getIndex() const {
+    return index;
+}
+
+double CircleView::getCenterX() const {
+    return system->x[index];
+}
+
+double CircleView::getCenterY() const {
+    return system->y[index];
+}
+
+std::shared_ptr<Point> CircleView::getCenter() const {
+    return make_pooled<Point>(system->x[index], system->y[index]);
+}
+
+double CircleView::getRadius() const {
+    return system->radius[index];
+}
+
+std::shared_ptr<Point> CircleView::getVelocity() const {
+    return make_pooled<Point>(system->vx[index], system->vy[index]);
+}
+
+std::shared_ptr<Point> CircleView::getAcceleration() const {
+    return make_pooled<Point>(system->ax[index], system->ay[index]);
+}
+
+double CircleView::getMass() const {
+    return system->mass[index];
+}
+
+bool CircleView::isAsleep() const {
+    return system->asleep[index] != 0;
+}
+
+CircleView CircleView::setCenterX(double x) {
+    system->x[index] = x;
+    return *this;
+}
+
+CircleView CircleView::setCenterY(double y) {
+    system->y[index] = y;
+    return *this;
+}
+
+CircleView CircleView::setRadius(double radius) {
+    system->radius[index] = radius;
+    return *this;
+}
+
+CircleView CircleView::setVelocity(const double x, const double y) {
+    system->vx[index] = x;
+    system->vy[index] = y;
+    return *this;
+}
+
+CircleView CircleView::setAcceleration(const double x, const double y) {
+    system->ax[index] = x;
+    system->ay[index] = y;
+    return *this;
+}
+
+CircleView CircleView::setMass(double mass) {
+    system->mass[index] = mass;
+    return *this;
+}
+
+void CircleView::update_physics(const double delta_time) {
+    system->vx[index] += system->ax[index] * delta_time;
+    system->vy[index] += system->ay[index] * delta_time;
+    system->x[index] += system->vx[index] * delta_time;
+    system->y[index] += system->vy[index] * delta_time;
+}
+
+std::shared_ptr<Circle> CircleView::to_circle() const {
+    std::shared_ptr<Circle> circle = make_pooled<Circle>(this->getCenter(), this->getRadius());
+    circle->setVelocity(system->vx[index], system->vy[index])
+          ->setAcceleration(system->ax[index], system->ay[index])
+          ->setMass(system->mass[index]);
+    return circle;
+}
+
+#ifndef PHYSICS_HEADLESS
+std::shared_ptr<sf::CircleShape> CircleView::to_circle_shape(const sf::Color& color) const {
+    double r = system->radius[index];
+    std::shared_ptr<sf::CircleShape> circle = std::make_shared<sf::CircleShape>(r);
+    circle->setPosition(sf::Vector2f(static_cast<float>(system->x[index] - r), static_cast<float>(system->y[index] - r)));
+    circle->setFillColor(color);
+    return circle;
+}
+#endif
+
+std::string CircleView::to_string() const {
+    return "Circle[(" + std::to_string(system->x[index]) + ", " + std::to_string(system->y[index]) + "), " + std::to_string(system->radius[index]) + "]";
+}
+
+
+std::size_t ParticleSystem::size() const {
+    return x.size();
+}
+
+bool ParticleSystem::empty() const {
+    return x.empty();
+}
+
+void ParticleSystem::reserve(const std::size_t capacity) {
+    x.reserve(capacity);
+    y.reserve(capacity);
+    vx.reserve(capacity);
+    vy.reserve(capacity);
+    ax.reserve(capacity);
+    ay.reserve(capacity);
+    mass.reserve(capacity);
+    radius.reserve(capacity);
+    asleep.reserve(capacity);
+}
+
+void ParticleSystem::clear() {
+    x.clear();
+    y.clear();
+    vx.clear();
+    vy.clear();
+    ax.clear();
+    ay.clear();
+    mass.clear();
+    radius.clear();
+    asleep.clear();
+}
+
+std::size_t ParticleSystem::add(const double x, const double y, const double radius, const double mass) {
+    this->x.push_back(x);
+    this->y.push_back(y);
+    this->vx.push_back(0.0);
+    this->vy.push_back(0.0);
+    this->ax.push_back(0.0);
+    this->ay.push_back(0.0);
+    this->mass.push_back(mass);
+    this->radius.push_back(radius);
+    this->asleep.push_back(0);
+    return this->x.size() - 1;
+}
+
+std::size_t ParticleSystem::add(const std::shared_ptr<Circle> circle) {
+    std::size_t index = this->add(circle->getCenter()->get_x(), circle->getCenter()->get_y(), circle->getRadius(), circle->getMass());
+    this->vx[index] = circle->getVelocity()->get_x();
+    this->vy[index] = circle->getVelocity()->get_y();
+    this->ax[index] = circle->getAcceleration()->get_x();
+    this->ay[index] = circle->getAcceleration()->get_y();
+    return index;
+}
+
+CircleView ParticleSystem::operator[](const std::size_t index) {
+    return CircleView(this, index);
+}
+
+double ParticleSystem::max_radius() const {
+    double result = 0.0;
+    for (double r : radius) {
+        if (r > result) result = r;
+    }
+    return result;
+}
+
+void ParticleSystem::integrate(const double delta_time) {
+    PROFILE_SCOPE("update_physics");
+    const std::size_t n = this->size();
+    double* px = x.data();
+    double* py = y.data();
+    double* pvx = vx.data();
+    double* pvy = vy.data();
+    const double* pax = ax.data();
+    const double* pay = ay.data();
+    const char* sleeping = asleep.data();
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (sleeping[i]) continue;
+        pvx[i] += pax[i] * delta_time;
+        pvy[i] += pay[i] * delta_time;
+        px[i] += pvx[i] * delta_time;
+        py[i] += pvy[i] * delta_time;
+    }
+}
+
+void ParticleSystem::apply_boundaries(const std::shared_ptr<Rectangle> boundaries, const double diminishing_factor) {
+    // The boundaries are constant for the whole pass, so read them once instead of once per ball.
+    const double left = boundaries->get_left_boundry();
+    const double right = boundaries->get_right_boundry();
+    const double top = boundaries->get_top_boundry();
+    const double bottom = boundaries->get_bottom_boundry();
+    const std::size_t n = this->size();
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (asleep[i]) continue;
+        const double px = x[i];
+        const double py = y[i];
+        const double r = radius[i];
+
+        if (px - r < left) {
+            x[i] = left + r;
+            vx[i] = -diminishing_factor * vx[i];
+        }
+        if (px + r > right) {
+            x[i] = right - r;
+            vx[i] = -diminishing_factor * vx[i];
+        }
+        if (py + r > top) {
+            y[i] = top - r;
+            vy[i] = -diminishing_factor * vy[i];
+        }
+        if (py - r < bottom) {
+            y[i] = bottom + r;
+            vy[i] = -diminishing_factor * vy[i];
+        }
+    }
+}
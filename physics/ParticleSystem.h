@@ -0,0 +1,73 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <vector>
+#include "../shapes/Circle.h"
+#include "../shapes/Rectangle.h"
+
+class ParticleSystem;
+
+// A lightweight handle onto one particle of a ParticleSystem. It mirrors the parts of the
+// Circle API used by the simulation loop, but reads and writes straight into the contiguous arrays.
+class CircleView {
+    private:
+        ParticleSystem* system;
+        std::size_t index;
+
+    public:
+        CircleView(ParticleSystem* system, std::size_t index);
+        std::size_t getIndex() const;
+        double getCenterX() const;
+        double getCenterY() const;
+        std::shared_ptr<Point> getCenter() const;
+        double getRadius() const;
+        std::shared_ptr<Point> getVelocity() const;
+        std::shared_ptr<Point> getAcceleration() const;
+        double getMass() const;
+        bool isAsleep() const;
+        CircleView setCenterX(double x);
+        CircleView setCenterY(double y);
+        CircleView setRadius(double radius);
+        CircleView setVelocity(const double x, const double y);
+        CircleView setAcceleration(const double x, const double y);
+        CircleView setMass(double mass);
+        void update_physics(const double delta_time);
+        std::shared_ptr<Circle> to_circle() const;
+#ifndef PHYSICS_HEADLESS
+        std::shared_ptr<sf::CircleShape> to_circle_shape(const sf::Color& color) const;
+#endif
+        std::string to_string() const;
+};
+
+// Structure-of-arrays store for every ball in the simulation. Each physical quantity lives in its
+// own contiguous array so the gravity, integration, boundary and collision passes stream through memory.
+class ParticleSystem {
+    public:
+        std::vector<double> x;
+        std::vector<double> y;
+        std::vector<double> vx;
+        std::vector<double> vy;
+        std::vector<double> ax;
+        std::vector<double> ay;
+        std::vector<double> mass;
+        std::vector<double> radius;
+        // Non-zero for balls put to sleep by the SleepSystem; they are skipped by integrate and apply_boundaries.
+        std::vector<char> asleep;
+
+        std::size_t size() const;
+        bool empty() const;
+        void reserve(const std::size_t capacity);
+        void clear();
+        std::size_t add(const double x, const double y, const double radius, const double mass = 1.0);
+        std::size_t add(const std::shared_ptr<Circle> circle);
+        CircleView operator[](const std::size_t index);
+        double max_radius() const;
+
+        // Semi-implicit Euler step, identical to Circle::update_physics.
+        void integrate(const double delta_time);
+        // Clamps every ball inside the boundaries, reflecting and damping the normal velocity on contact.
+        void apply_boundaries(const std::shared_ptr<Rectangle> boundaries, const double diminishing_factor);
+};
+
+
+#endif // PARTICLE_SYSTEM_H
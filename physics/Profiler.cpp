@@ -0,0 +1,165 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+
+namespace {
+
+// Quotes and backslashes are the only characters a phase or thread name could need escaped.
+std::string json_string(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// Nearest-rank percentile of sorted values.
+double percentile(const std::vector<double>& sorted, const double p) {
+    std::size_t rank = static_cast<std::size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<std::size_t>(rank, 1)) - 1];
+}
+
+} // namespace
+
+
+constexpr std::size_t Profiler::RING_CAPACITY;
+
+Profiler& Profiler::instance() {
+    static Profiler profiler;
+    return profiler;
+}
+
+std::uint64_t Profiler::now() {
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool Profiler::enabled() {
+#ifdef PHYSICS_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+Profiler::ThreadBuffer& Profiler::current_buffer() {
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        std::shared_ptr<ThreadBuffer> created = std::make_shared<ThreadBuffer>();
+        created->events.reset(new Event[RING_CAPACITY]);
+        std::lock_guard<std::mutex> lock(mutex);
+        created->id = buffers.size();
+        created->name = "thread " + std::to_string(created->id);
+        buffers.push_back(created);
+        buffer = created.get();
+    }
+    return *buffer;
+}
+
+void Profiler::record(const char* name, const std::uint64_t start, const std::uint64_t end) {
+    ThreadBuffer& buffer = current_buffer();
+    const std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    Event& event = buffer.events[index % RING_CAPACITY];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void Profiler::set_thread_name(const std::string& name) {
+    ThreadBuffer& buffer = current_buffer();
+    std::lock_guard<std::mutex> lock(mutex);
+    buffer.name = name;
+}
+
+std::vector<Profiler::Sample> Profiler::collect() const {
+    std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        snapshot = buffers;
+    }
+    const std::uint64_t since = cleared_at.load();
+    std::vector<Sample> samples;
+    for (const std::shared_ptr<ThreadBuffer>& buffer : snapshot) {
+        const std::uint64_t written = buffer->written.load(std::memory_order_acquire);
+        const std::uint64_t first = written > RING_CAPACITY ? written - RING_CAPACITY : 0;
+        const std::size_t begin = samples.size();
+        for (std::uint64_t i = first; i < written; ++i) {
+            const Event& event = buffer->events[i % RING_CAPACITY];
+            samples.push_back({event.name.load(std::memory_order_relaxed), event.start.load(std::memory_order_relaxed),
+                               event.end.load(std::memory_order_relaxed), buffer->id});
+        }
+        // The writer kept going while we copied: drop the slots it may have overwritten, including the one it
+        // may be writing right now.
+        const std::uint64_t after = buffer->written.load(std::memory_order_acquire) + 1;
+        const std::uint64_t valid = after > RING_CAPACITY ? after - RING_CAPACITY : 0;
+        if (valid > first) {
+            const std::size_t stale = static_cast<std::size_t>(std::min(valid, written) - first);
+            samples.erase(samples.begin() + static_cast<std::ptrdiff_t>(begin),
+                          samples.begin() + static_cast<std::ptrdiff_t>(begin + stale));
+        }
+    }
+    samples.erase(std::remove_if(samples.begin(), samples.end(),
+                                 [since](const Sample& sample) { return sample.name == nullptr || sample.start < since; }),
+                  samples.end());
+    return samples;
+}
+
+std::vector<Profiler::PhaseStats> Profiler::stats() const {
+    std::map<std::string, std::vector<double>> durations;
+    for (const Sample& sample : collect()) {
+        durations[sample.name].push_back(static_cast<double>(sample.end - sample.start) * 1e-6);
+    }
+    std::vector<PhaseStats> result;
+    for (auto& phase : durations) {
+        std::vector<double>& values = phase.second;
+        std::sort(values.begin(), values.end());
+        double total = 0.0;
+        for (double value : values) total += value;
+        result.push_back({phase.first, values.size(), values.front(), percentile(values, 0.5), percentile(values, 0.99),
+                          total / static_cast<double>(values.size())});
+    }
+    return result;
+}
+
+void Profiler::write_chrome_trace(const std::string& path) const {
+    std::vector<Sample> samples = collect();
+    std::uint64_t origin = samples.empty() ? 0 : samples.front().start;
+    for (const Sample& sample : samples) origin = std::min(origin, sample.start);
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    out.precision(3);
+    out << std::fixed << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const std::shared_ptr<ThreadBuffer>& buffer : buffers) {
+            out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << buffer->id
+                << ", \"args\": {\"name\": " << json_string(buffer->name) << "}}";
+            first = false;
+        }
+    }
+    // Complete events ("X") in microseconds from the first scope.
+    for (const Sample& sample : samples) {
+        out << (first ? "" : ",\n") << "{\"name\": " << json_string(sample.name) << ", \"ph\": \"X\", \"pid\": 1, \"tid\": "
+            << sample.thread << ", \"ts\": " << static_cast<double>(sample.start - origin) * 1e-3
+            << ", \"dur\": " << static_cast<double>(sample.end - sample.start) * 1e-3 << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+void Profiler::clear() {
+    cleared_at.store(now());
+}
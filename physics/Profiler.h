@@ -0,0 +1,106 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped timing of the phases of a step or frame. PROFILE_SCOPE("name") times the rest of the enclosing block on
+// the calling thread. Without PHYSICS_PROFILE defined (the CMake option of the same name) it expands to nothing,
+// so instrumented code costs nothing in a normal build. Names must be string literals or otherwise outlive the
+// profiler.
+#ifdef PHYSICS_PROFILE
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#endif
+
+// Collects the timed scopes of every thread. Each thread writes to its own ring buffer of the last
+// RING_CAPACITY scopes, without locks; the reports read whatever the rings hold, so they always describe the
+// most recent stretch of the run.
+class Profiler {
+    public:
+        static constexpr std::size_t RING_CAPACITY = 1 << 14;
+
+        struct PhaseStats {
+            std::string name;
+            std::size_t samples;
+            double min_ms;
+            double p50_ms;
+            double p99_ms;
+            double mean_ms;
+        };
+
+    private:
+        // Written by one thread, read by any. The fields are atomics so a report may read a slot while it is
+        // being overwritten; such slots are detected with the write count and dropped.
+        struct Event {
+            std::atomic<const char*> name{nullptr};
+            std::atomic<std::uint64_t> start{0};
+            std::atomic<std::uint64_t> end{0};
+        };
+        struct ThreadBuffer {
+            std::size_t id;
+            std::string name;
+            std::atomic<std::uint64_t> written{0};
+            std::unique_ptr<Event[]> events;
+        };
+        struct Sample {
+            const char* name;
+            std::uint64_t start;
+            std::uint64_t end;
+            std::size_t thread;
+        };
+
+        // Buffers are kept after their thread exits, so its scopes still show up in the reports.
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        mutable std::mutex mutex;
+        // Scopes that started before this are ignored; the rings themselves belong to their writers.
+        std::atomic<std::uint64_t> cleared_at{0};
+
+        Profiler() = default;
+        ThreadBuffer& current_buffer();
+        std::vector<Sample> collect() const;
+
+    public:
+        static Profiler& instance();
+        // Nanoseconds on the steady clock.
+        static std::uint64_t now();
+        // Whether PROFILE_SCOPE was compiled in.
+        static bool enabled();
+
+        void record(const char* name, const std::uint64_t start, const std::uint64_t end);
+        // Names the calling thread in the trace.
+        void set_thread_name(const std::string& name);
+        // Minimum, median, 99th percentile and mean of every phase over the scopes still in the rings,
+        // sorted by name.
+        std::vector<PhaseStats> stats() const;
+        // Writes the scopes still in the rings as Chrome trace-event JSON, viewable in chrome://tracing or
+        // Perfetto. Throws std::runtime_error if the file cannot be written.
+        void write_chrome_trace(const std::string& path) const;
+        // Forgets every scope recorded so far.
+        void clear();
+};
+
+// Records the time between its construction and destruction under name.
+class ProfileScope {
+    private:
+        const char* name;
+        std::uint64_t start;
+
+    public:
+        explicit ProfileScope(const char* name) : name(name), start(Profiler::now()) {}
+        ~ProfileScope() {
+            Profiler::instance().record(name, start, Profiler::now());
+        }
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+
+#endif // PROFILER_H
@@ -0,0 +1,322 @@
+#include "SceneLoader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include "Checkpoint.h"
+#include "MappedFile.h"
+
+namespace {
+
+const std::size_t NO_LINE = static_cast<std::size_t>(-1);
+
+// Every power of ten that is exactly representable as a double.
+const double EXACT_POWERS_OF_TEN[23] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline bool is_space(const char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool is_digit(const char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline void skip_spaces(const char*& p, const char* end) {
+    while (p != end && is_space(*p)) ++p;
+}
+
+// Parses one number ending at a space, a comment or the end of the line. Plain decimals with at most 19
+// significant digits, a mantissa below 2^53 and a power of ten up to 22 are computed as one correctly rounded
+// multiplication or division (Clinger's fast path); everything else (long mantissas, huge exponents, inf, nan)
+// goes through strtod. Returns false for anything that is not a number.
+bool parse_double(const char*& p, const char* end, double& out) {
+    const char* start = p;
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        negative = *p == '-';
+        ++p;
+    }
+    std::uint64_t mantissa = 0;
+    int significant = 0;
+    int exponent = 0;
+    bool any_digit = false;
+    bool truncated = false;
+    for (; p != end && is_digit(*p); ++p) {
+        any_digit = true;
+        if (significant < 19) {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+            if (mantissa != 0) ++significant;
+        } else {
+            ++exponent;
+            truncated = true;
+        }
+    }
+    if (p != end && *p == '.') {
+        for (++p; p != end && is_digit(*p); ++p) {
+            any_digit = true;
+            if (significant < 19) {
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+                if (mantissa != 0) ++significant;
+                --exponent;
+            } else {
+                truncated = true;
+            }
+        }
+    }
+    bool fast = any_digit && !truncated;
+    if (any_digit && p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negative_exponent = false;
+        if (p != end && (*p == '-' || *p == '+')) {
+            negative_exponent = *p == '-';
+            ++p;
+        }
+        if (p == end || !is_digit(*p)) return false;
+        int written = 0;
+        for (; p != end && is_digit(*p); ++p) {
+            if (written < 100000) written = written * 10 + (*p - '0');
+        }
+        exponent += negative_exponent ? -written : written;
+    }
+    const bool delimited = p == end || is_space(*p) || *p == '#';
+    if (fast && delimited && mantissa < (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / EXACT_POWERS_OF_TEN[-exponent] : value * EXACT_POWERS_OF_TEN[exponent];
+        out = negative ? -value : value;
+        return true;
+    }
+
+    // The mapped buffer is not NUL-terminated: strtod gets a copy of the token.
+    const char* token_end = start;
+    while (token_end != end && !is_space(*token_end) && *token_end != '#') ++token_end;
+    char token[64];
+    const std::size_t length = static_cast<std::size_t>(token_end - start);
+    if (length == 0 || length >= sizeof(token)) return false;
+    std::memcpy(token, start, length);
+    token[length] = '\0';
+    char* parsed_end = nullptr;
+    out = std::strtod(token, &parsed_end);
+    if (parsed_end != token + length) return false;
+    p = token_end;
+    return true;
+}
+
+struct ChunkResult {
+    std::vector<double> bodies[6];   // x, y, vx, vy, mass, radius
+    std::size_t lines = 0;
+    bool has_boundary = false;
+    double boundary[4];
+    bool has_G = false;
+    double G = 0.0;
+    bool has_damping = false;
+    double damping = 0.0;
+    std::size_t error_line = NO_LINE;   // within the chunk
+    std::string error;
+};
+
+// Reads count numbers and then expects the end of the line.
+bool parse_numbers(const char*& p, const char* end, double* values, const int count) {
+    for (int k = 0; k < count; ++k) {
+        skip_spaces(p, end);
+        if (p == end || !parse_double(p, end, values[k])) return false;
+    }
+    skip_spaces(p, end);
+    return p == end || *p == '#';
+}
+
+// Scenes hold finite numbers only: an infinite or nan coordinate or constant has no meaningful simulation.
+bool all_finite(const double* values, const int count) {
+    for (int k = 0; k < count; ++k) {
+        if (!std::isfinite(values[k])) return false;
+    }
+    return true;
+}
+
+void parse_chunk(const char* begin, const char* end, ChunkResult& result) {
+    // Counting the lines first is a fraction of the parse and sizes the arrays exactly: no reallocation.
+    std::size_t line_count = 1;
+    for (const char* p = begin; (p = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)))) != nullptr; ++p) {
+        ++line_count;
+    }
+    for (std::vector<double>& values : result.bodies) values.reserve(line_count);
+
+    const char* line = begin;
+    while (line < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(line, '\n', static_cast<std::size_t>(end - line)));
+        if (line_end == nullptr) line_end = end;
+        const char* p = line;
+        line = line_end + 1;
+        ++result.lines;
+
+        skip_spaces(p, line_end);
+        if (p == line_end || *p == '#') continue;
+        if (is_digit(*p) || *p == '-' || *p == '+' || *p == '.') {
+            double values[6];
+            if (!parse_numbers(p, line_end, values, 6)) {
+                result.error = "expected X Y VX VY MASS RADIUS";
+                result.error_line = result.lines - 1;
+                return;
+            }
+            if (!all_finite(values, 6)) {
+                result.error = "body values must be finite";
+                result.error_line = result.lines - 1;
+                return;
+            }
+            if (!(values[4] > 0.0) || !(values[5] > 0.0)) {
+                result.error = "body mass and radius must be positive";
+                result.error_line = result.lines - 1;
+                return;
+            }
+            for (int k = 0; k < 6; ++k) result.bodies[k].push_back(values[k]);
+            continue;
+        }
+
+        const char* word = p;
+        while (p != line_end && !is_space(*p) && *p != '#') ++p;
+        const std::string directive(word, p);
+        bool ok;
+        if (directive == "boundary") {
+            ok = parse_numbers(p, line_end, result.boundary, 4);
+            result.has_boundary = ok;
+        } else if (directive == "G") {
+            ok = parse_numbers(p, line_end, &result.G, 1);
+            result.has_G = ok;
+        } else if (directive == "damping") {
+            ok = parse_numbers(p, line_end, &result.damping, 1);
+            result.has_damping = ok;
+        } else {
+            result.error = "unknown directive '" + directive + "'";
+            result.error_line = result.lines - 1;
+            return;
+        }
+        if (!ok) {
+            result.error = "malformed '" + directive + "' directive";
+            result.error_line = result.lines - 1;
+            return;
+        }
+        const bool finite = directive == "boundary" ? all_finite(result.boundary, 4)
+                          : directive == "G" ? all_finite(&result.G, 1) : all_finite(&result.damping, 1);
+        if (!finite) {
+            result.error = "'" + directive + "' values must be finite";
+            result.error_line = result.lines - 1;
+            return;
+        }
+    }
+}
+
+} // namespace
+
+
+void load_scene(const std::string& path, Simulation& simulation, ThreadPool* pool) {
+    MappedFile file(path);
+    if (is_checkpoint(file.data(), file.size())) {
+        load_checkpoint(path, simulation);
+        return;
+    }
+
+    // Chunk boundaries are moved forward to the next line start, so every line belongs to exactly one chunk.
+    const char* data = file.data();
+    const std::size_t size = file.size();
+    const std::size_t threads = pool != nullptr ? pool->size() : 1;
+    const std::size_t minimum_chunk = 1 << 20;
+    const std::size_t chunk_count = threads == 1 ? 1 : std::max<std::size_t>(1, std::min(threads * 4, size / minimum_chunk));
+    std::vector<std::size_t> starts(chunk_count + 1, size);
+    starts[0] = 0;
+    for (std::size_t c = 1; c < chunk_count; ++c) {
+        std::size_t start = std::max(starts[c - 1], size / chunk_count * c);
+        const void* newline = start < size ? std::memchr(data + start, '\n', size - start) : nullptr;
+        starts[c] = newline != nullptr ? static_cast<std::size_t>(static_cast<const char*>(newline) - data) + 1 : size;
+    }
+
+    std::vector<ChunkResult> chunks(chunk_count);
+    auto parse = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t c = begin; c < end; ++c) parse_chunk(data + starts[c], data + starts[c + 1], chunks[c]);
+    };
+    if (pool == nullptr || pool->size() == 1) {
+        parse(0, chunk_count, 0);
+    } else {
+        pool->parallel_for(chunk_count, 1, parse);
+    }
+
+    std::vector<std::size_t> offsets(chunk_count + 1, 0);
+    std::size_t line = 1;
+    for (std::size_t c = 0; c < chunk_count; ++c) {
+        if (chunks[c].error_line != NO_LINE) {
+            throw std::runtime_error(path + ":" + std::to_string(line + chunks[c].error_line) + ": " + chunks[c].error);
+        }
+        line += chunks[c].lines;
+        offsets[c + 1] = offsets[c] + chunks[c].bodies[0].size();
+    }
+
+    ParticleSystem& particles = simulation.get_particles();
+    const std::size_t n = offsets[chunk_count];
+    std::vector<double>* arrays[6] = {&particles.x, &particles.y, &particles.vx, &particles.vy, &particles.mass, &particles.radius};
+    particles.ax.assign(n, 0.0);
+    particles.ay.assign(n, 0.0);
+    particles.asleep.assign(n, 0);
+    auto gather = [&](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t c = begin; c < end; ++c) {
+            for (int k = 0; k < 6; ++k) {
+                std::copy(chunks[c].bodies[k].begin(), chunks[c].bodies[k].end(), arrays[k]->begin() + static_cast<std::ptrdiff_t>(offsets[c]));
+            }
+        }
+    };
+    if (chunk_count == 1) {
+        // A single chunk already holds the final arrays.
+        for (int k = 0; k < 6; ++k) arrays[k]->swap(chunks[0].bodies[k]);
+    } else {
+        for (std::vector<double>* array : arrays) array->resize(n);
+        if (pool == nullptr || pool->size() == 1) {
+            gather(0, chunk_count, 0);
+        } else {
+            pool->parallel_for(chunk_count, 1, gather);
+        }
+    }
+
+    for (const ChunkResult& chunk : chunks) {
+        if (chunk.has_boundary) {
+            simulation.set_boundaries(std::make_shared<Rectangle>(std::make_shared<Point>(chunk.boundary[0], chunk.boundary[1]),
+                                                                  std::make_shared<Point>(chunk.boundary[2], chunk.boundary[3])));
+        }
+        if (chunk.has_G && simulation.get_gravity() != nullptr) simulation.get_gravity()->setG(chunk.G);
+        if (chunk.has_damping) simulation.set_diminishing_factor(chunk.damping);
+    }
+}
+
+void save_scene(const Simulation& simulation, const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    std::shared_ptr<Rectangle> boundaries = simulation.get_boundaries();
+    out.precision(17);
+    out << "# X Y VX VY MASS RADIUS\n"
+        << "boundary " << boundaries->get_left_boundry() << " " << boundaries->get_top_boundry() << " "
+        << boundaries->get_right_boundry() << " " << boundaries->get_bottom_boundry() << "\n";
+    if (simulation.get_gravity() != nullptr) out << "G " << simulation.get_gravity()->getG() << "\n";
+    out << "damping " << simulation.get_diminishing_factor() << "\n";
+
+    // Formatted into one buffer and written in large blocks; an ostream insertion per number is several times slower.
+    const ParticleSystem& particles = simulation.get_particles();
+    std::string buffer;
+    buffer.reserve(1 << 20);
+    char line[256];
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        int length = std::snprintf(line, sizeof(line), "%.17g %.17g %.17g %.17g %.17g %.17g\n", particles.x[i], particles.y[i],
+                                   particles.vx[i], particles.vy[i], particles.mass[i], particles.radius[i]);
+        buffer.append(line, static_cast<std::size_t>(length));
+        if (buffer.size() > (1 << 20) - sizeof(line)) {
+            out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            buffer.clear();
+        }
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef SCENE_LOADER_H
+#define SCENE_LOADER_H
+
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+// Scene files describe the initial bodies, the boundaries and the global constants of a simulation.
+//
+// Text scenes hold one entry per line; '#' starts a comment and blank lines are ignored:
+//   boundary LEFT TOP RIGHT BOTTOM       the axis-aligned boundary rectangle
+//   G VALUE                              gravitational constant
+//   damping VALUE                        the diminishing factor of boundary bounces
+//   X Y VX VY MASS RADIUS                one body
+// Directives may appear anywhere; the last one of each kind wins. Bodies keep their order in the file.
+// Every number must be finite, and the mass and radius of a body positive.
+//
+// A checkpoint file (see Checkpoint.h) is accepted as the binary form of a scene and is recognized by its header.
+
+// Replaces the bodies of the simulation with the scene's and applies whichever directives the scene has; the
+// rest of the simulation is left as it was. The text is parsed in parallel chunks of a memory-mapped buffer
+// when a pool is given. Throws std::runtime_error naming the file and line of the first malformed or
+// out-of-range entry.
+void load_scene(const std::string& path, Simulation& simulation, ThreadPool* pool = nullptr);
+// Writes the current state as a text scene, numbers printed so they read back exactly. Velocities are kept,
+// accelerations, sleep state and the step count are not.
+void save_scene(const Simulation& simulation, const std::string& path);
+
+
+#endif // SCENE_LOADER_H
@@ -0,0 +1,283 @@
+#include "Simulation.h"
+#include <random>
+#include "BarnesHut.h"
+#include "ParticleMesh.h"
+#include "Profiler.h"
+
+std::shared_ptr<GravitySolver> make_gravity_solver(const GravitySettings& settings) {
+    Precision precision;
+    if (settings.precision == "double") {
+        precision = Precision::Double;
+    } else if (settings.precision == "float") {
+        precision = Precision::Float;
+    } else {
+        throw std::invalid_argument("Unknown precision: " + settings.precision);
+    }
+    // Only the SIMD kernel has a float path; any other engine would quietly run in double.
+    if (precision != Precision::Double && settings.engine != "simd") {
+        throw std::invalid_argument("Precision " + settings.precision + " needs the simd gravity engine, not " + settings.engine);
+    }
+    std::shared_ptr<ThreadPool> pool = std::make_shared<ThreadPool>(settings.threads);
+    if (settings.engine == "barnes-hut") {
+        return std::make_shared<BarnesHutGravity>(settings.G, settings.theta, pool);
+    }
+    if (settings.engine == "brute-force" || settings.engine == "simd") {
+        std::shared_ptr<BruteForceGravity> brute_force = std::make_shared<BruteForceGravity>(settings.G, pool, settings.deterministic);
+        if (settings.engine == "simd") {
+            brute_force->set_kernel(std::make_shared<GravityKernel>(settings.fast_rsqrt, detect_simd_level(), precision));
+        }
+        return brute_force;
+    }
+    if (settings.engine == "particle-mesh") {
+        MassAssignment assignment;
+        if (settings.mesh_assignment == "cic") {
+            assignment = MassAssignment::CIC;
+        } else if (settings.mesh_assignment == "tsc") {
+            assignment = MassAssignment::TSC;
+        } else {
+            throw std::invalid_argument("Unknown mass assignment: " + settings.mesh_assignment);
+        }
+        return std::make_shared<ParticleMeshGravity>(settings.G, settings.mesh_size, assignment, settings.mesh_short_range, pool);
+    }
+    throw std::invalid_argument("Unknown gravity engine: " + settings.engine);
+}
+
+
+Simulation::Simulation(std::shared_ptr<Rectangle> boundaries, std::shared_ptr<GravitySolver> gravity, const double diminishing_factor)
+    : boundaries(boundaries), gravity(gravity), integrator(make_integrator("euler")), diminishing_factor(diminishing_factor) {}
+
+ParticleSystem& Simulation::get_particles() {
+    return particles;
+}
+
+const ParticleSystem& Simulation::get_particles() const {
+    return particles;
+}
+
+std::shared_ptr<Rectangle> Simulation::get_boundaries() const {
+    return boundaries;
+}
+
+void Simulation::set_boundaries(std::shared_ptr<Rectangle> boundaries) {
+    this->boundaries = boundaries;
+}
+
+std::shared_ptr<GravitySolver> Simulation::get_gravity() const {
+    return gravity;
+}
+
+void Simulation::set_gravity(std::shared_ptr<GravitySolver> gravity) {
+    this->gravity = gravity;
+}
+
+std::shared_ptr<Integrator> Simulation::get_integrator() const {
+    return integrator;
+}
+
+void Simulation::set_integrator(std::shared_ptr<Integrator> integrator) {
+    this->integrator = integrator;
+}
+
+double Simulation::get_diminishing_factor() const {
+    return diminishing_factor;
+}
+
+void Simulation::set_diminishing_factor(const double diminishing_factor) {
+    this->diminishing_factor = diminishing_factor;
+}
+
+std::uint64_t Simulation::get_step_count() const {
+    return step_count;
+}
+
+void Simulation::set_step_count(const std::uint64_t step_count) {
+    this->step_count = step_count;
+}
+
+const CollisionStats& Simulation::get_collision_stats() const {
+    return collision_stats;
+}
+
+void Simulation::set_collision_threads(const std::size_t threads) {
+    contacts = ContactSolver(threads == 1 ? nullptr : std::make_shared<ThreadPool>(threads));
+}
+
+std::size_t Simulation::get_contact_colors() const {
+    return contacts.get_color_count();
+}
+
+const SleepSettings& Simulation::get_sleep_settings() const {
+    return sleep.get_settings();
+}
+
+void Simulation::set_sleep_settings(const SleepSettings& settings) {
+    sleep.set_settings(settings);
+}
+
+const SleepStats& Simulation::get_sleep_stats() const {
+    return sleep.get_stats();
+}
+
+const ContinuousCollisionSettings& Simulation::get_continuous_collision_settings() const {
+    return sweep.get_settings();
+}
+
+void Simulation::set_continuous_collision_settings(const ContinuousCollisionSettings& settings) {
+    sweep.set_settings(settings);
+}
+
+const ContinuousCollisionStats& Simulation::get_continuous_collision_stats() const {
+    return sweep.get_stats();
+}
+
+StaticObstacles& Simulation::get_obstacles() {
+    return obstacles;
+}
+
+const StaticObstacles& Simulation::get_obstacles() const {
+    return obstacles;
+}
+
+const ObstacleStats& Simulation::get_obstacle_stats() const {
+    return obstacle_stats;
+}
+
+void Simulation::add_random_balls(const std::size_t count, const unsigned int seed) {
+    std::mt19937 rng(seed);
+    const int left = static_cast<int>(std::ceil(boundaries->get_left_boundry()));
+    const int right = static_cast<int>(std::floor(boundaries->get_right_boundry()));
+    const int bottom = static_cast<int>(std::ceil(boundaries->get_bottom_boundry()));
+    const int top = static_cast<int>(std::floor(boundaries->get_top_boundry()));
+    std::uniform_int_distribution<int> random_x(left, std::max(left, right - 1));
+    std::uniform_int_distribution<int> random_y(bottom, std::max(bottom, top - 1));
+    std::uniform_int_distribution<int> random_radius(5, 9);
+
+    particles.reserve(particles.size() + count);
+    for (std::size_t i = 0; i < count; ++i) {
+        int x = random_x(rng);
+        int y = random_y(rng);
+        int radius = random_radius(rng);
+        particles.add(x, y, radius, 1.0);
+    }
+}
+
+void Simulation::add_obstacle_scene(const std::string& name, const unsigned int seed) {
+    const double left = boundaries->get_left_boundry();
+    const double right = boundaries->get_right_boundry();
+    const double top = boundaries->get_top_boundry();
+    const double bottom = boundaries->get_bottom_boundry();
+    std::mt19937 rng(seed);
+    if (name == "maze") {
+        const double cell = 60.0;
+        std::bernoulli_distribution wall(0.5);
+        for (double x = left + cell; x < right; x += cell) {
+            for (double y = bottom + cell; y < top; y += cell) {
+                if (wall(rng)) obstacles.add(std::make_shared<Line>(std::make_shared<Point>(x, y - cell), std::make_shared<Point>(x, y)));
+                if (wall(rng)) obstacles.add(std::make_shared<Line>(std::make_shared<Point>(x - cell, y), std::make_shared<Point>(x, y)));
+            }
+        }
+    } else if (name == "funnel") {
+        const double center = (left + right) / 2.0;
+        const double height = top - bottom;
+        const double plate_top = top - 0.1 * height;
+        const double plate_bottom = top - 0.4 * height;
+        const double thickness = 10.0;
+        for (const double side : {left, right}) {
+            // A plate from the side down to a gap of 80 around the middle, as a rotated rectangle.
+            const Vec2 from(side, plate_top);
+            const Vec2 to(center + (side < center ? -40.0 : 40.0), plate_bottom);
+            const Vec2 normal = (to - from).perpendicular().normalized() * (thickness / 2.0);
+            obstacles.add(std::make_shared<Rectangle>(std::make_shared<Point>(from + normal), std::make_shared<Point>(to + normal),
+                                                      std::make_shared<Point>(to - normal), std::make_shared<Point>(from - normal)));
+        }
+        const double spacing = 50.0;
+        int row = 0;
+        for (double y = plate_bottom - spacing; y > bottom + spacing; y -= spacing, ++row) {
+            for (double x = left + spacing / 2.0 * (1 + row % 2); x < right - spacing / 2.0; x += spacing) {
+                obstacles.add(std::make_shared<Triangle>(std::make_shared<Point>(x - 8.0, y - 6.0), std::make_shared<Point>(x + 8.0, y - 6.0),
+                                                         std::make_shared<Point>(x, y + 8.0)));
+            }
+        }
+    } else {
+        throw std::invalid_argument("Unknown obstacle scene " + name);
+    }
+}
+
+void Simulation::step(const double delta_time) {
+    PROFILE_SCOPE("step");
+    const bool swept = sweep.get_settings().enabled;
+    if (swept) sweep.begin_step(particles);
+    // Advance every ball under the gravitational pull of all the others.
+    {
+        PROFILE_SCOPE("integrate");
+        integrator->step(particles, *gravity, delta_time);
+    }
+
+    // Move fast balls back to their first impact along the step, so they cannot pass through each other
+    if (swept) {
+        PROFILE_SCOPE("continuous_collision");
+        sweep.resolve(particles, boundaries, diminishing_factor, delta_time, sleep.get_settings().enabled ? &sleep : nullptr);
+    }
+
+    // Handle boundary collisions
+    {
+        PROFILE_SCOPE("boundaries");
+        particles.apply_boundaries(boundaries, diminishing_factor);
+    }
+
+    // Handle collisions with the static obstacles
+    if (!obstacles.empty()) {
+        PROFILE_SCOPE("obstacles");
+        obstacle_stats = obstacles.resolve(particles, diminishing_factor, &sleep);
+    }
+
+    // Handle collisions between balls, skipping pairs that are both asleep
+    {
+        PROFILE_SCOPE("collisions");
+        if (sleep.get_settings().enabled) {
+            collision_stats = contacts.resolve(particles, grid, sleep);
+        } else {
+            collision_stats = contacts.resolve(particles, grid);
+        }
+    }
+    {
+        PROFILE_SCOPE("sleep");
+        sleep.end_step(particles, boundaries, grid.get_pairs());
+    }
+    ++step_count;
+}
+
+double Simulation::kinetic_energy() const {
+    double energy = 0.0;
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        energy += 0.5 * particles.mass[i] * (particles.vx[i] * particles.vx[i] + particles.vy[i] * particles.vy[i]);
+    }
+    return energy;
+}
+
+double Simulation::potential_energy() const {
+    return gravity ? ::potential_energy(particles, gravity->getG()) : 0.0;
+}
+
+std::shared_ptr<Point> Simulation::momentum() const {
+    double px = 0.0;
+    double py = 0.0;
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        px += particles.mass[i] * particles.vx[i];
+        py += particles.mass[i] * particles.vy[i];
+    }
+    return make_pooled<Point>(px, py);
+}
+
+std::shared_ptr<Point> Simulation::center_of_mass() const {
+    double total = 0.0;
+    double mx = 0.0;
+    double my = 0.0;
+    for (std::size_t i = 0; i < particles.size(); ++i) {
+        total += particles.mass[i];
+        mx += particles.mass[i] * particles.x[i];
+        my += particles.mass[i] * particles.y[i];
+    }
+    if (total == 0.0) return make_pooled<Point>();
+    return make_pooled<Point>(mx / total, my / total);
+}
@@ -0,0 +1,102 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include "ParticleSystem.h"
+#include "Gravity.h"
+#include "Integrator.h"
+#include "SpatialGrid.h"
+#include "Collision.h"
+#include "Sleep.h"
+#include "ContinuousCollision.h"
+#include "Obstacles.h"
+
+// How to build the gravity engine of a simulation.
+struct GravitySettings {
+    std::string engine = "barnes-hut";   // "brute-force", "simd", "barnes-hut" or "particle-mesh"
+    double G = 5000;
+    double theta = 0.5;                  // Barnes-Hut opening angle
+    std::size_t threads = 0;             // 0 means one per hardware thread
+    bool deterministic = false;          // bit-identical to the single-threaded pass
+    bool fast_rsqrt = false;             // reciprocal square root estimate in the SIMD kernel
+    std::string precision = "double";    // scalar type of the SIMD kernel, "double" or "float" (simd engine only)
+    std::size_t mesh_size = 256;         // particle-mesh nodes per side, a power of two
+    std::string mesh_assignment = "cic"; // particle-mesh mass assignment, "cic" or "tsc"
+    bool mesh_short_range = true;        // direct short-range correction of the particle-mesh force
+};
+
+// Builds the engine described by the settings. Throws std::invalid_argument for an unknown engine, precision or
+// mass assignment name. The precision is chosen per simulation, but only the simd engine has a float path:
+// brute-force, barnes-hut and particle-mesh compute in double, and asking them for float throws as well.
+std::shared_ptr<GravitySolver> make_gravity_solver(const GravitySettings& settings);
+
+// The physics pipeline shared by the windowed and the headless executables: gravity and integration
+// (interleaved as the integrator requires), the swept impacts of fast balls when enabled, boundary clamping,
+// the static obstacles, ball-ball collisions and the sleep update, in that order, once per step.
+class Simulation {
+    private:
+        ParticleSystem particles;
+        std::shared_ptr<Rectangle> boundaries;
+        std::shared_ptr<GravitySolver> gravity;
+        std::shared_ptr<Integrator> integrator;
+        double diminishing_factor;
+        SpatialGrid grid;
+        ContactSolver contacts;
+        CollisionStats collision_stats;
+        SleepSystem sleep;
+        ContinuousCollision sweep;
+        StaticObstacles obstacles;
+        ObstacleStats obstacle_stats;
+        std::uint64_t step_count = 0;
+
+    public:
+        Simulation(std::shared_ptr<Rectangle> boundaries, std::shared_ptr<GravitySolver> gravity, const double diminishing_factor);
+        ParticleSystem& get_particles();
+        const ParticleSystem& get_particles() const;
+        std::shared_ptr<Rectangle> get_boundaries() const;
+        void set_boundaries(std::shared_ptr<Rectangle> boundaries);
+        std::shared_ptr<GravitySolver> get_gravity() const;
+        void set_gravity(std::shared_ptr<GravitySolver> gravity);
+        std::shared_ptr<Integrator> get_integrator() const;
+        // Semi-implicit Euler unless set otherwise, see make_integrator.
+        void set_integrator(std::shared_ptr<Integrator> integrator);
+        double get_diminishing_factor() const;
+        void set_diminishing_factor(const double diminishing_factor);
+        std::uint64_t get_step_count() const;
+        // Used when resuming from a checkpoint.
+        void set_step_count(const std::uint64_t step_count);
+        const CollisionStats& get_collision_stats() const;
+        // Resolves the ball-ball contacts on this many threads (0 means one per hardware thread) with the
+        // contact coloring of ContactSolver. A new simulation resolves them serially.
+        void set_collision_threads(const std::size_t threads);
+        std::size_t get_contact_colors() const;
+        const SleepSettings& get_sleep_settings() const;
+        void set_sleep_settings(const SleepSettings& settings);
+        const SleepStats& get_sleep_stats() const;
+        // Off for a new simulation; see ContinuousCollision.
+        const ContinuousCollisionSettings& get_continuous_collision_settings() const;
+        void set_continuous_collision_settings(const ContinuousCollisionSettings& settings);
+        const ContinuousCollisionStats& get_continuous_collision_stats() const;
+        // Lines, triangles and rectangles the balls bounce off; none for a new simulation.
+        StaticObstacles& get_obstacles();
+        const StaticObstacles& get_obstacles() const;
+        const ObstacleStats& get_obstacle_stats() const;
+
+        // Adds resting balls with integer positions spread uniformly inside the boundaries,
+        // radius in [5, 9] and unit mass. The same seed always gives the same scene.
+        void add_random_balls(const std::size_t count, const unsigned int seed);
+        // Fills the boundaries with static obstacles: "maze" puts a wall on the right and the top side of every
+        // 60-unit cell, each left out at random; "funnel" puts two tilted plates over the middle and rows of
+        // triangular pegs below them. Throws std::invalid_argument for another name.
+        void add_obstacle_scene(const std::string& name, const unsigned int seed);
+        void step(const double delta_time);
+
+        double kinetic_energy() const;
+        // Gravitational potential energy, O(n^2). Zero without a gravity engine.
+        double potential_energy() const;
+        std::shared_ptr<Point> momentum() const;
+        std::shared_ptr<Point> center_of_mass() const;
+};
+
+
+#endif // SIMULATION_H
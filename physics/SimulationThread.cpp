@@ -0,0 +1,93 @@
+#include "SimulationThread.h"
+#include <chrono>
+#include "Profiler.h"
+
+SimulationThread::SimulationThread(Simulation& simulation, SnapshotBuffer& snapshots, const double fixed_delta_time, const bool real_time)
+    : simulation(simulation), snapshots(snapshots), fixed_delta_time(fixed_delta_time), real_time(real_time) {}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+double SimulationThread::get_fixed_delta_time() const {
+    return fixed_delta_time;
+}
+
+bool SimulationThread::is_running() const {
+    return running.load();
+}
+
+void SimulationThread::start() {
+    if (running.exchange(true)) return;
+    worker = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    running.store(false);
+    if (worker.joinable()) worker.join();
+}
+
+void SimulationThread::set_checkpoint_writer(CheckpointWriter* writer, const std::string& path) {
+    checkpoints = writer;
+    checkpoint_path = path;
+}
+
+void SimulationThread::set_trajectory_recorder(TrajectoryRecorder* recorder) {
+    this->recorder = recorder;
+}
+
+void SimulationThread::request_checkpoint() {
+    checkpoint_requested.store(true);
+}
+
+void SimulationThread::run() {
+    typedef std::chrono::steady_clock Clock;
+    // Never try to catch up more than this many steps at once after a stall (e.g. a debugger break).
+    const int max_catch_up_steps = 8;
+    Clock::time_point last = Clock::now();
+    double lag = 0.0;
+    Profiler::instance().set_thread_name("physics");
+
+    snapshots.begin_write().capture(simulation.get_particles(), simulation.get_step_count(),
+                                    fixed_delta_time * static_cast<double>(simulation.get_step_count()));
+    snapshots.publish();
+
+    while (running.load()) {
+        int steps = 1;
+        if (real_time) {
+            Clock::time_point now = Clock::now();
+            lag += std::chrono::duration<double>(now - last).count();
+            last = now;
+            steps = static_cast<int>(lag / fixed_delta_time);
+            if (steps == 0) {
+                std::this_thread::sleep_for(std::chrono::duration<double>(fixed_delta_time - lag));
+                continue;
+            }
+            if (steps > max_catch_up_steps) {
+                steps = max_catch_up_steps;
+                lag = 0.0;
+            } else {
+                lag -= steps * fixed_delta_time;
+            }
+        }
+
+        for (int i = 0; i < steps; ++i) {
+            simulation.step(fixed_delta_time);
+            if (recorder != nullptr) {
+                recorder->record(simulation.get_particles(), simulation.get_step_count(),
+                                 fixed_delta_time * static_cast<double>(simulation.get_step_count()));
+            }
+        }
+        // Only the newest state is of any use to the renderer.
+        {
+            PROFILE_SCOPE("publish_snapshot");
+            snapshots.begin_write().capture(simulation.get_particles(), simulation.get_step_count(),
+                                            fixed_delta_time * static_cast<double>(simulation.get_step_count()));
+            snapshots.publish();
+        }
+        // A request made while the writer is still busy is kept for the next batch.
+        if (checkpoints != nullptr && checkpoint_requested.load() && checkpoints->save(simulation, checkpoint_path)) {
+            checkpoint_requested.store(false);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef SIMULATION_THREAD_H
+#define SIMULATION_THREAD_H
+
+#include <atomic>
+#include <thread>
+#include "Simulation.h"
+#include "SnapshotBuffer.h"
+#include "Checkpoint.h"
+#include "Trajectory.h"
+
+// Steps a Simulation on its own thread with a fixed timestep and publishes every completed state into a
+// SnapshotBuffer. The render loop never touches the simulation while the thread runs, so a slow frame can
+// neither stall the physics nor feed it an oversized step.
+class SimulationThread {
+    private:
+        Simulation& simulation;
+        SnapshotBuffer& snapshots;
+        double fixed_delta_time;
+        bool real_time;
+        std::atomic<bool> running{false};
+        CheckpointWriter* checkpoints = nullptr;
+        std::string checkpoint_path;
+        std::atomic<bool> checkpoint_requested{false};
+        TrajectoryRecorder* recorder = nullptr;
+        std::thread worker;
+
+        void run();
+
+    public:
+        // With real_time the simulated clock is paced to the wall clock; otherwise the thread steps as fast as it can.
+        SimulationThread(Simulation& simulation, SnapshotBuffer& snapshots, const double fixed_delta_time, const bool real_time = true);
+        ~SimulationThread();
+        SimulationThread(const SimulationThread&) = delete;
+        SimulationThread& operator=(const SimulationThread&) = delete;
+
+        double get_fixed_delta_time() const;
+        bool is_running() const;
+        void start();
+        // Blocks until the current step is finished and the thread has exited.
+        void stop();
+        // Where request_checkpoint() saves to. Set it before start().
+        void set_checkpoint_writer(CheckpointWriter* writer, const std::string& path);
+        // Every step is recorded into the recorder, if any. Set it before start().
+        void set_trajectory_recorder(TrajectoryRecorder* recorder);
+        // Captures the state after the current batch of steps and hands it to the writer. Safe from any thread.
+        void request_checkpoint();
+};
+
+
+#endif // SIMULATION_THREAD_H
@@ -0,0 +1,149 @@
+#include "Sleep.h"
+#include <algorithm>
+#include <limits>
+
+SleepSystem::SleepSystem(const SleepSettings& settings) : settings(settings) {}
+
+const SleepSettings& SleepSystem::get_settings() const {
+    return settings;
+}
+
+void SleepSystem::set_settings(const SleepSettings& settings) {
+    this->settings = settings;
+}
+
+const SleepStats& SleepSystem::get_stats() const {
+    return stats;
+}
+
+std::uint32_t SleepSystem::find(std::uint32_t i) {
+    while (parent[i] != i) {
+        // Path halving keeps the trees flat without recursion.
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+void SleepSystem::unite(const std::uint32_t a, const std::uint32_t b) {
+    std::uint32_t root_a = find(a);
+    std::uint32_t root_b = find(b);
+    if (root_a == root_b) return;
+    // The smaller index becomes the root so island ids do not depend on the contact order.
+    if (root_a < root_b) parent[root_b] = root_a;
+    else parent[root_a] = root_b;
+}
+
+void SleepSystem::wake(ParticleSystem& particles, const std::size_t i) {
+    if (i >= still_steps.size()) still_steps.resize(particles.size(), 0);
+    if (particles.asleep[i]) {
+        particles.asleep[i] = 0;
+        if (i < island.size()) islands_to_wake.push_back(island[i]);
+    }
+    still_steps[i] = 0;
+}
+
+void SleepSystem::support(const std::size_t i) {
+    resting.push_back(static_cast<std::uint32_t>(i));
+}
+
+void SleepSystem::wake_all(ParticleSystem& particles) {
+    std::fill(particles.asleep.begin(), particles.asleep.end(), 0);
+    still_steps.assign(particles.size(), 0);
+    islands_to_wake.clear();
+}
+
+void SleepSystem::end_step(ParticleSystem& particles, const std::shared_ptr<Rectangle> boundaries, const std::vector<CandidatePair>& pairs) {
+    const std::size_t n = particles.size();
+    still_steps.resize(n, 0);
+    island.resize(n, 0);
+    stats = SleepStats();
+
+    if (!settings.enabled) {
+        resting.clear();
+        if (std::find(particles.asleep.begin(), particles.asleep.end(), 1) != particles.asleep.end()) {
+            wake_all(particles);
+        }
+        stats.awake = n;
+        return;
+    }
+
+    // Wake every ball of the islands that were disturbed during the step.
+    if (!islands_to_wake.empty()) {
+        std::sort(islands_to_wake.begin(), islands_to_wake.end());
+        islands_to_wake.erase(std::unique(islands_to_wake.begin(), islands_to_wake.end()), islands_to_wake.end());
+        for (std::size_t i = 0; i < n; ++i) {
+            if (particles.asleep[i] && std::binary_search(islands_to_wake.begin(), islands_to_wake.end(), island[i])) {
+                particles.asleep[i] = 0;
+                still_steps[i] = 0;
+            }
+        }
+        stats.islands_woken = islands_to_wake.size();
+        islands_to_wake.clear();
+    }
+
+    // Islands are the connected components of the awake balls resting on each other.
+    parent.resize(n);
+    for (std::size_t i = 0; i < n; ++i) parent[i] = static_cast<std::uint32_t>(i);
+    supported.assign(n, 0);
+    for (std::uint32_t i : resting) {
+        if (i < n) supported[i] = 1;
+    }
+    resting.clear();
+    for (const CandidatePair& pair : pairs) {
+        if (particles.asleep[pair.a] || particles.asleep[pair.b]) continue;
+        const double dx = particles.x[pair.b] - particles.x[pair.a];
+        const double dy = particles.y[pair.b] - particles.y[pair.a];
+        const double reach = particles.radius[pair.a] + particles.radius[pair.b] + settings.contact_slop;
+        if (dx * dx + dy * dy < reach * reach) {
+            supported[pair.a] = 1;
+            supported[pair.b] = 1;
+            unite(pair.a, pair.b);
+        }
+    }
+
+    const double left = boundaries->get_left_boundry() + settings.contact_slop;
+    const double right = boundaries->get_right_boundry() - settings.contact_slop;
+    const double top = boundaries->get_top_boundry() - settings.contact_slop;
+    const double bottom = boundaries->get_bottom_boundry() + settings.contact_slop;
+    const double threshold_squared = settings.velocity_threshold * settings.velocity_threshold;
+    for (std::size_t i = 0; i < n; ++i) {
+        if (particles.asleep[i]) continue;
+        const double r = particles.radius[i];
+        if (particles.x[i] - r <= left || particles.x[i] + r >= right || particles.y[i] + r >= top || particles.y[i] - r <= bottom) {
+            supported[i] = 1;
+        }
+        const double speed_squared = particles.vx[i] * particles.vx[i] + particles.vy[i] * particles.vy[i];
+        if (supported[i] && speed_squared < threshold_squared) {
+            if (still_steps[i] < std::numeric_limits<std::uint32_t>::max()) ++still_steps[i];
+        } else {
+            still_steps[i] = 0;
+        }
+    }
+
+    island_still.assign(n, std::numeric_limits<std::uint32_t>::max());
+    for (std::size_t i = 0; i < n; ++i) {
+        if (particles.asleep[i]) continue;
+        std::uint32_t root = find(static_cast<std::uint32_t>(i));
+        island_still[root] = std::min(island_still[root], still_steps[i]);
+    }
+
+    // An island sleeps only as a whole, when its least settled ball has been still long enough.
+    for (std::size_t i = 0; i < n; ++i) {
+        if (particles.asleep[i]) {
+            ++stats.asleep;
+            continue;
+        }
+        std::uint32_t root = find(static_cast<std::uint32_t>(i));
+        if (island_still[root] >= settings.steps) {
+            particles.asleep[i] = 1;
+            particles.vx[i] = 0.0;
+            particles.vy[i] = 0.0;
+            island[i] = root;
+            if (root == i) ++stats.islands_put_to_sleep;
+            ++stats.asleep;
+        } else {
+            ++stats.awake;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef SLEEP_H
+#define SLEEP_H
+
+#include <cstdint>
+#include "ParticleSystem.h"
+#include "SpatialGrid.h"
+
+// When and whether settled balls are put to sleep.
+struct SleepSettings {
+    bool enabled = false;
+    double velocity_threshold = 2.0;     // speed below which a ball counts as still
+    std::uint32_t steps = 60;            // consecutive still steps before its island may sleep
+    double contact_slop = 0.5;           // gap below which a ball counts as resting on another ball or a wall
+};
+
+// Per-frame counters of the sleep system.
+struct SleepStats {
+    std::size_t awake = 0;
+    std::size_t asleep = 0;
+    std::size_t islands_put_to_sleep = 0;
+    std::size_t islands_woken = 0;
+};
+
+// Puts whole islands of touching balls to sleep once every ball in them has been slower than the threshold
+// for the configured number of steps. Islands are the connected components of the balls closer than the contact
+// slop. Only supported balls count as still, those resting on another ball, a wall or an obstacle (see support),
+// so a ball at the top of its orbit is never frozen in mid-air. Sleeping balls are skipped by the integration,
+// the boundary and obstacle passes and the collision narrowphase, but they still attract the others.
+// A ball that touches an awake ball wakes up at once, and the rest of its island follows at the end of the step.
+class SleepSystem {
+    private:
+        SleepSettings settings;
+        SleepStats stats;
+        std::vector<std::uint32_t> still_steps;
+        std::vector<std::uint32_t> island;          // id of the island a sleeping ball went to sleep with
+        std::vector<std::uint32_t> parent;          // union-find forest over this step's resting pairs
+        std::vector<std::uint32_t> island_still;    // fewest still steps of any ball, per union-find root
+        std::vector<char> supported;                // rests on a ball or a wall this step
+        std::vector<std::uint32_t> resting;         // balls reported by support() for this step
+        std::vector<std::uint32_t> islands_to_wake;
+
+        std::uint32_t find(std::uint32_t i);
+        void unite(const std::uint32_t a, const std::uint32_t b);
+
+    public:
+        explicit SleepSystem(const SleepSettings& settings = SleepSettings());
+        const SleepSettings& get_settings() const;
+        // Disabling the system wakes every ball at the end of the next step.
+        void set_settings(const SleepSettings& settings);
+        const SleepStats& get_stats() const;
+
+        // Wakes ball i now and the rest of its island at the end of the step.
+        void wake(ParticleSystem& particles, const std::size_t i);
+        void wake_all(ParticleSystem& particles);
+        // Ball i rests on something other than a ball or the boundaries this step, such as a static obstacle.
+        void support(const std::size_t i);
+        // Wakes the disturbed islands, updates the still counters and puts settled islands to sleep.
+        // pairs are the broadphase candidates of the step, a superset of the pairs within the contact slop
+        // as long as the slop is small next to the grid cell.
+        void end_step(ParticleSystem& particles, const std::shared_ptr<Rectangle> boundaries, const std::vector<CandidatePair>& pairs);
+};
+
+
+#endif // SLEEP_H
@@ -0,0 +1,43 @@
+#include "SnapshotBuffer.h"
+#include <algorithm>
+
+void Snapshot::capture(const ParticleSystem& particles, const std::uint64_t step, const double time) {
+    x.assign(particles.x.begin(), particles.x.end());
+    y.assign(particles.y.begin(), particles.y.end());
+    radius.assign(particles.radius.begin(), particles.radius.end());
+    asleep = static_cast<std::size_t>(std::count(particles.asleep.begin(), particles.asleep.end(), 1));
+    this->step = step;
+    this->time = time;
+}
+
+std::size_t Snapshot::size() const {
+    return x.size();
+}
+
+
+Snapshot& SnapshotBuffer::begin_write() {
+    return slots[write_index];
+}
+
+void SnapshotBuffer::publish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::swap(write_index, ready_index);
+    fresh = true;
+}
+
+bool SnapshotBuffer::acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!fresh) return false;
+    std::swap(previous_index, latest_index);
+    std::swap(latest_index, ready_index);
+    fresh = false;
+    return true;
+}
+
+const Snapshot& SnapshotBuffer::latest() const {
+    return slots[latest_index];
+}
+
+const Snapshot& SnapshotBuffer::previous() const {
+    return slots[previous_index];
+}
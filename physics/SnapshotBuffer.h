@@ -0,0 +1,47 @@
+#ifndef SNAPSHOT_BUFFER_H
+#define SNAPSHOT_BUFFER_H
+
+#include <cstdint>
+#include <mutex>
+#include "ParticleSystem.h"
+
+// The part of the simulation state the renderer needs, copied out after a completed step.
+struct Snapshot {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> radius;
+    std::uint64_t step = 0;
+    double time = 0.0;   // simulated seconds
+    std::size_t asleep = 0;
+
+    void capture(const ParticleSystem& particles, const std::uint64_t step, const double time);
+    std::size_t size() const;
+};
+
+// Hands completed states from the physics thread to the render thread without either one waiting on the other.
+// It is a triple buffer (writer slot, ready slot, reader slot) plus one more slot that keeps the reader's previous
+// state for interpolation. Only slot indices are swapped under the lock, never the state itself, and every slot
+// keeps its storage, so steady-state publishing does not allocate.
+class SnapshotBuffer {
+    private:
+        Snapshot slots[4];
+        int write_index = 0;
+        int ready_index = 1;
+        int latest_index = 2;
+        int previous_index = 3;
+        bool fresh = false;
+        std::mutex mutex;
+
+    public:
+        // The writer's private slot. Fill it, then publish().
+        Snapshot& begin_write();
+        void publish();
+        // Called by the reader: moves the newest published state to latest() and the former latest() to
+        // previous(). Returns false, and changes nothing, if nothing was published since the last call.
+        bool acquire();
+        const Snapshot& latest() const;
+        const Snapshot& previous() const;
+};
+
+
+#endif // SNAPSHOT_BUFFER_H
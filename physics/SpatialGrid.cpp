@@ -0,0 +1,138 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+void SpatialGrid::emit_pairs(const std::size_t cell, const std::size_t other) {
+    for (std::uint32_t a = cell_start[cell]; a < cell_start[cell + 1]; ++a) {
+        for (std::uint32_t b = cell_start[other]; b < cell_start[other + 1]; ++b) {
+            std::uint32_t i = cell_entries[a];
+            std::uint32_t j = cell_entries[b];
+            pairs.push_back(i < j ? CandidatePair{i, j} : CandidatePair{j, i});
+        }
+    }
+}
+
+void SpatialGrid::build(const ParticleSystem& particles) {
+    pairs.clear();
+    bin(particles);
+
+    // Visit every cell against itself and half of its neighbors, so each pair of cells is seen once.
+    for (std::size_t cy = 0; cy < rows; ++cy) {
+        for (std::size_t cx = 0; cx < columns; ++cx) {
+            std::size_t cell = cy * columns + cx;
+            if (cell_start[cell] == cell_start[cell + 1]) continue;
+
+            for (std::uint32_t a = cell_start[cell]; a < cell_start[cell + 1]; ++a) {
+                for (std::uint32_t b = a + 1; b < cell_start[cell + 1]; ++b) {
+                    std::uint32_t i = cell_entries[a];
+                    std::uint32_t j = cell_entries[b];
+                    pairs.push_back(i < j ? CandidatePair{i, j} : CandidatePair{j, i});
+                }
+            }
+            if (cx + 1 < columns) emit_pairs(cell, cell + 1);
+            if (cy + 1 < rows) {
+                if (cx > 0) emit_pairs(cell, cell + columns - 1);
+                emit_pairs(cell, cell + columns);
+                if (cx + 1 < columns) emit_pairs(cell, cell + columns + 1);
+            }
+        }
+    }
+}
+
+void SpatialGrid::bin(const ParticleSystem& particles) {
+    const std::size_t n = particles.size();
+    columns = rows = 0;
+
+    // Particles at an infinite or nan position are left out of every cell, so they collide with nothing and do
+    // not blow the extent up.
+    double min_x = std::numeric_limits<double>::max(), max_x = std::numeric_limits<double>::lowest();
+    double min_y = std::numeric_limits<double>::max(), max_y = std::numeric_limits<double>::lowest();
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!std::isfinite(particles.x[i]) || !std::isfinite(particles.y[i])) continue;
+        min_x = std::min(min_x, particles.x[i]);
+        max_x = std::max(max_x, particles.x[i]);
+        min_y = std::min(min_y, particles.y[i]);
+        max_y = std::max(max_y, particles.y[i]);
+    }
+    if (min_x > max_x) return;
+
+    cell_size = 2.0 * particles.max_radius();
+    if (!(cell_size > 0.0) || !std::isfinite(cell_size)) cell_size = 1.0;
+    const double max_cells = MAX_CELLS_PER_PARTICLE * static_cast<double>(n) + 16.0;
+    // The extents are measured in cells as x / cell_size - min_x / cell_size, which stays finite where
+    // max_x - min_x would overflow, so the doubling always ends; the cap only guards that reasoning.
+    for (std::size_t doublings = 0;; ++doublings) {
+        if (doublings == MAX_DOUBLINGS) throw std::runtime_error("SpatialGrid: no cell size fits the particle extent");
+        double c = std::floor(max_x / cell_size - min_x / cell_size) + 1.0;
+        double r = std::floor(max_y / cell_size - min_y / cell_size) + 1.0;
+        if (c * r <= max_cells) {
+            columns = static_cast<std::size_t>(c);
+            rows = static_cast<std::size_t>(r);
+            break;
+        }
+        cell_size *= 2.0;
+    }
+    origin_x = min_x;
+    origin_y = min_y;
+
+    // Counting sort of the particles by cell.
+    const std::size_t cells = columns * rows;
+    cell_start.assign(cells + 1, 0);
+    particle_cell.resize(n);
+    cell_entries.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!std::isfinite(particles.x[i]) || !std::isfinite(particles.y[i])) {
+            particle_cell[i] = NO_CELL;
+            continue;
+        }
+        std::size_t cx = std::min(columns - 1, static_cast<std::size_t>(particles.x[i] / cell_size - origin_x / cell_size));
+        std::size_t cy = std::min(rows - 1, static_cast<std::size_t>(particles.y[i] / cell_size - origin_y / cell_size));
+        std::size_t cell = cy * columns + cx;
+        particle_cell[i] = static_cast<std::uint32_t>(cell);
+        ++cell_start[cell + 1];
+    }
+    for (std::size_t c = 0; c < cells; ++c) {
+        cell_start[c + 1] += cell_start[c];
+    }
+    cell_fill.assign(cell_start.begin(), cell_start.end() - 1);
+    for (std::size_t i = 0; i < n; ++i) {
+        if (particle_cell[i] == NO_CELL) continue;
+        cell_entries[cell_fill[particle_cell[i]]++] = static_cast<std::uint32_t>(i);
+    }
+}
+
+void SpatialGrid::query(const double min_x, const double min_y, const double max_x, const double max_y,
+                        std::vector<std::uint32_t>& found) const {
+    if (columns == 0 || max_x < min_x || max_y < min_y) return;
+    // Measured and clamped like the binning, which puts the particles past the last cell into it.
+    auto cell_of = [this](const double coordinate, const double origin, const std::size_t count) {
+        const double cells = coordinate / cell_size - origin / cell_size;
+        return !(cells > 0.0) ? std::size_t(0) : std::min(count - 1, static_cast<std::size_t>(std::min(cells, 1e18)));
+    };
+    const std::size_t first_x = cell_of(min_x, origin_x, columns);
+    const std::size_t last_x = cell_of(max_x, origin_x, columns);
+    const std::size_t first_y = cell_of(min_y, origin_y, rows);
+    const std::size_t last_y = cell_of(max_y, origin_y, rows);
+    for (std::size_t cy = first_y; cy <= last_y; ++cy) {
+        const std::size_t row = cy * columns;
+        found.insert(found.end(), cell_entries.begin() + cell_start[row + first_x], cell_entries.begin() + cell_start[row + last_x + 1]);
+    }
+}
+
+const std::vector<CandidatePair>& SpatialGrid::get_pairs() const {
+    return pairs;
+}
+
+double SpatialGrid::get_cell_size() const {
+    return cell_size;
+}
+
+std::size_t SpatialGrid::get_columns() const {
+    return columns;
+}
+
+std::size_t SpatialGrid::get_rows() const {
+    return rows;
+}
@@ -0,0 +1,54 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cstdint>
+#include "ParticleSystem.h"
+
+struct CandidatePair {
+    std::uint32_t a;
+    std::uint32_t b;
+};
+
+// Uniform-grid broadphase for ball-ball collisions. Cells are at least one maximum diameter wide, so two
+// overlapping balls always sit in the same or in adjacent cells. Particles are bucketed with a counting
+// sort and every buffer is kept between frames, so rebuilding does not allocate once the scene is warm.
+// Particles at a non-finite position are not binned.
+class SpatialGrid {
+    private:
+        // Sparse scenes would otherwise produce huge, mostly empty grids.
+        static constexpr double MAX_CELLS_PER_PARTICLE = 4.0;
+        // Enough to take the smallest positive cell size past the largest double.
+        static constexpr std::size_t MAX_DOUBLINGS = 2200;
+        static constexpr std::uint32_t NO_CELL = 0xffffffffu;
+
+        double cell_size = 1.0;
+        double origin_x = 0.0;
+        double origin_y = 0.0;
+        std::size_t columns = 0;
+        std::size_t rows = 0;
+        std::vector<std::uint32_t> cell_start;     // prefix sums, size columns * rows + 1
+        std::vector<std::uint32_t> cell_fill;
+        std::vector<std::uint32_t> cell_entries;   // particle indices grouped by cell
+        std::vector<std::uint32_t> particle_cell;
+        std::vector<CandidatePair> pairs;
+
+        void emit_pairs(const std::size_t cell, const std::size_t other);
+
+    public:
+        // Bins the particles and collects the candidate pairs from the same and neighboring cells.
+        void build(const ParticleSystem& particles);
+        // Bins the particles without collecting any pairs, for queries. Throws std::runtime_error if no cell size
+        // fits the extent, which finite positions never cause.
+        void bin(const ParticleSystem& particles);
+        // Appends the particles binned into the cells that the box overlaps: every particle whose center is in
+        // the box, and some around it.
+        void query(const double min_x, const double min_y, const double max_x, const double max_y,
+                   std::vector<std::uint32_t>& found) const;
+        const std::vector<CandidatePair>& get_pairs() const;
+        double get_cell_size() const;
+        std::size_t get_columns() const;
+        std::size_t get_rows() const;
+};
+
+
+#endif // SPATIAL_GRID_H
@@ -0,0 +1,77 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (std::size_t i = 1; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::run_chunks(const std::size_t worker) {
+    while (true) {
+        std::size_t begin = next.fetch_add(chunk);
+        if (begin >= count) return;
+        (*task)(begin, std::min(begin + chunk, count), worker);
+    }
+}
+
+void ThreadPool::worker_loop(const std::size_t worker) {
+    std::size_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+        }
+
+        run_chunks(worker);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0) work_done.notify_one();
+    }
+}
+
+void ThreadPool::parallel_for(const std::size_t count, const std::size_t chunk_size, const Task& task) {
+    if (count == 0) return;
+    const std::size_t chunk = std::max<std::size_t>(1, chunk_size);
+    if (workers.empty() || count <= chunk) {
+        task(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->count = count;
+        this->chunk = chunk;
+        this->next.store(0);
+        this->busy = workers.size();
+        ++generation;
+    }
+    work_ready.notify_all();
+
+    run_chunks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [&] { return busy == 0; });
+    this->task = nullptr;
+}
@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A persistent pool of worker threads for the data-parallel simulation passes. The threads are started once
+// and sleep between jobs, so a pass costs a wake-up instead of a thread creation. The calling thread takes
+// part in every job as worker 0.
+class ThreadPool {
+    public:
+        // task(begin, end, worker) processes the index range [begin, end); worker is in [0, size()).
+        typedef std::function<void(std::size_t, std::size_t, std::size_t)> Task;
+
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable work_ready;
+        std::condition_variable work_done;
+        const Task* task = nullptr;
+        std::size_t count = 0;
+        std::size_t chunk = 1;
+        std::atomic<std::size_t> next{0};
+        std::size_t generation = 0;
+        std::size_t busy = 0;
+        bool stopping = false;
+
+        void worker_loop(const std::size_t worker);
+        void run_chunks(const std::size_t worker);
+
+    public:
+        // threads is the total number of threads including the caller; 0 means one per hardware thread.
+        explicit ThreadPool(std::size_t threads = 0);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        std::size_t size() const;
+        // Splits [0, count) into chunks of at most chunk_size indices and hands them out to the threads
+        // dynamically. Blocks until every chunk is done. Jobs must not be submitted from inside a task.
+        void parallel_for(const std::size_t count, const std::size_t chunk_size, const Task& task);
+};
+
+
+#endif // THREAD_POOL_H
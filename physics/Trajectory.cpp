@@ -0,0 +1,520 @@
+#include "Trajectory.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "Profiler.h"
+
+namespace {
+
+const char MAGIC[8] = {'P', 'H', 'Y', 'S', 'T', 'R', 'A', 'J'};
+const char INDEX_MAGIC[8] = {'T', 'R', 'A', 'J', 'I', 'N', 'D', 'X'};
+const std::uint32_t VERSION = 1;
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+const std::uint32_t KEYFRAME = 1;
+const std::size_t NO_FRAME = static_cast<std::size_t>(-1);
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    double position_quantum;
+    double velocity_quantum;
+    std::uint32_t keyframe_interval;
+    std::uint32_t reserved;
+    char padding[24];
+};
+static_assert(sizeof(FileHeader) == 64, "the trajectory header is 64 bytes");
+
+struct FrameHeader {
+    std::uint64_t step;
+    double time;
+    std::uint64_t payload_size;
+    std::uint32_t body_count;
+    std::uint32_t flags;
+};
+static_assert(sizeof(FrameHeader) == 32, "the frame header is 32 bytes");
+
+struct Trailer {
+    std::uint64_t index_offset;
+    std::uint64_t frame_count;
+    char magic[8];
+};
+static_assert(sizeof(Trailer) == 24, "the trajectory trailer is 24 bytes");
+static_assert(sizeof(TrajectoryIndexEntry) == 32, "an index entry is 32 bytes");
+
+// Far inside the int64 range, so a delta of two clamped values cannot overflow either.
+const double QUANTIZED_LIMIT = 4.0e18;
+
+inline std::int64_t quantize(const double value, const double inverse_quantum) {
+    double scaled = value * inverse_quantum;
+    // NaN fails both comparisons and ends up at the lower limit.
+    if (!(scaled >= -QUANTIZED_LIMIT)) scaled = -QUANTIZED_LIMIT;
+    if (scaled > QUANTIZED_LIMIT) scaled = QUANTIZED_LIMIT;
+    return std::llround(scaled);
+}
+
+// Maps small magnitudes of either sign to small unsigned values: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+inline std::uint64_t zigzag(const std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+inline std::int64_t unzigzag(const std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+// LEB128: 7 bits per byte, the high bit set on every byte but the last. At most 10 bytes.
+inline unsigned char* put_varint(unsigned char* out, std::uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<unsigned char>(value);
+    return out;
+}
+
+inline std::uint64_t get_varint(const unsigned char*& in, const unsigned char* end) {
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (in == end) {
+            throw std::runtime_error("Trajectory frame is corrupt");
+        }
+        const unsigned char byte = *in++;
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return value;
+    }
+    throw std::runtime_error("Trajectory frame is corrupt");
+}
+
+} // namespace
+
+
+std::size_t TrajectoryFrame::size() const {
+    return x.size();
+}
+
+
+TrajectoryRecorder::TrajectoryRecorder(const std::string& path, const TrajectorySettings& settings)
+    : settings(settings), out(path, std::ios::binary | std::ios::trunc) {
+    if (!out) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    if (settings.keyframe_interval == 0 || !(settings.position_quantum > 0.0) || !(settings.velocity_quantum > 0.0)) {
+        throw std::invalid_argument("Trajectory quanta and keyframe interval must be positive");
+    }
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.position_quantum = settings.position_quantum;
+    header.velocity_quantum = settings.velocity_quantum;
+    header.keyframe_interval = settings.keyframe_interval;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    bytes_written = sizeof(header);
+
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, settings.buffered_frames); ++i) {
+        free_frames.emplace_back(new TrajectoryFrame());
+    }
+    worker = std::thread(&TrajectoryRecorder::run, this);
+}
+
+TrajectoryRecorder::~TrajectoryRecorder() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // Nothing sensible to do with a write error during destruction.
+    }
+}
+
+void TrajectoryRecorder::record(const ParticleSystem& particles, const std::uint64_t step, const double time) {
+    std::unique_ptr<TrajectoryFrame> frame;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (closing) {
+            throw std::logic_error("Trajectory recorder is closed");
+        }
+        if (free_frames.empty()) {
+            stalls.fetch_add(1);
+            changed.wait(lock, [this]() { return !free_frames.empty(); });
+        }
+        frame = std::move(free_frames.back());
+        free_frames.pop_back();
+    }
+    // The frame belongs to this thread until it is queued.
+    frame->step = step;
+    frame->time = time;
+    frame->x.assign(particles.x.begin(), particles.x.end());
+    frame->y.assign(particles.y.begin(), particles.y.end());
+    frame->vx.assign(particles.vx.begin(), particles.vx.end());
+    frame->vy.assign(particles.vy.begin(), particles.vy.end());
+    frame->radius.assign(particles.radius.begin(), particles.radius.end());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(frame));
+    }
+    changed.notify_all();
+}
+
+void TrajectoryRecorder::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closing) return;
+        closing = true;
+    }
+    changed.notify_all();
+    worker.join();
+
+    if (error.empty()) {
+        Trailer trailer;
+        trailer.index_offset = bytes_written;
+        trailer.frame_count = index.size();
+        std::memcpy(trailer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+        out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(TrajectoryIndexEntry)));
+        out.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+        bytes_written += index.size() * sizeof(TrajectoryIndexEntry) + sizeof(trailer);
+        out.flush();
+        if (!out) error = "Cannot write the trajectory index";
+    }
+    out.close();
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+}
+
+const TrajectorySettings& TrajectoryRecorder::get_settings() const {
+    return settings;
+}
+
+std::uint64_t TrajectoryRecorder::get_frames_written() const {
+    return frames_written.load();
+}
+
+std::uint64_t TrajectoryRecorder::get_stalls() const {
+    return stalls.load();
+}
+
+std::uint64_t TrajectoryRecorder::get_bytes_written() const {
+    return bytes_written;
+}
+
+void TrajectoryRecorder::run() {
+    Profiler::instance().set_thread_name("trajectory writer");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this]() { return !queued.empty() || closing; });
+        if (queued.empty()) return;
+        std::unique_ptr<TrajectoryFrame> frame = std::move(queued.front());
+        queued.pop_front();
+        const bool failed = !error.empty();
+        lock.unlock();
+        // After a failed write the frames are only recycled, so record() never blocks forever.
+        std::string frame_error;
+        if (!failed) {
+            try {
+                PROFILE_SCOPE("trajectory_write");
+                write_frame(*frame);
+            } catch (const std::exception& e) {
+                frame_error = e.what();
+            }
+        }
+        lock.lock();
+        if (!frame_error.empty()) error = frame_error;
+        free_frames.push_back(std::move(frame));
+        changed.notify_all();
+    }
+}
+
+void TrajectoryRecorder::write_frame(const TrajectoryFrame& frame) {
+    const std::size_t n = frame.size();
+    bool keyframe = index.empty() || since_keyframe + 1 >= settings.keyframe_interval || previous[0].size() != n;
+    if (!keyframe && n > 0) keyframe = std::memcmp(keyframe_radius.data(), frame.radius.data(), n * sizeof(double)) != 0;
+
+    // Worst case: 10 bytes per value, 5 channels.
+    payload.resize(n * 5 * 10);
+    unsigned char* cursor = payload.data();
+    const double inverse_position = 1.0 / settings.position_quantum;
+    const double inverse_velocity = 1.0 / settings.velocity_quantum;
+    if (keyframe) {
+        keyframe_radius.assign(frame.radius.begin(), frame.radius.end());
+        for (std::size_t i = 0; i < n; ++i) cursor = put_varint(cursor, zigzag(quantize(frame.radius[i], inverse_position)));
+        for (int c = 0; c < 4; ++c) previous[c].assign(n, 0);
+        since_keyframe = 0;
+    } else {
+        ++since_keyframe;
+    }
+    const std::vector<double>* channels[4] = {&frame.x, &frame.y, &frame.vx, &frame.vy};
+    for (int c = 0; c < 4; ++c) {
+        const double* values = channels[c]->data();
+        std::int64_t* last = previous[c].data();
+        const double inverse = c < 2 ? inverse_position : inverse_velocity;
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::int64_t q = quantize(values[i], inverse);
+            cursor = put_varint(cursor, zigzag(q - last[i]));
+            last[i] = q;
+        }
+    }
+
+    FrameHeader header;
+    header.step = frame.step;
+    header.time = frame.time;
+    header.payload_size = static_cast<std::uint64_t>(cursor - payload.data());
+    header.body_count = static_cast<std::uint32_t>(n);
+    header.flags = keyframe ? KEYFRAME : 0;
+    const std::uint64_t frame_number = index.size();
+    const std::uint64_t keyframe_number = keyframe ? frame_number : index.back().keyframe;
+    index.push_back({bytes_written, frame.step, frame.time, keyframe_number});
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(header.payload_size));
+    if (!out) {
+        throw std::runtime_error("Cannot write the trajectory frame at step " + std::to_string(frame.step));
+    }
+    bytes_written += sizeof(header) + header.payload_size;
+    frames_written.fetch_add(1);
+}
+
+
+TrajectoryReader::TrajectoryReader(const std::string& path) : file(path) {
+    if (file.size() < sizeof(FileHeader) || std::memcmp(file.data(), MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error(path + " is not a trajectory");
+    }
+    FileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error(path + " was written on a machine with another byte order");
+    }
+    if (header.version != VERSION) {
+        throw std::runtime_error(path + " is a version " + std::to_string(header.version) + " trajectory, expected version "
+                                 + std::to_string(VERSION));
+    }
+    settings.position_quantum = header.position_quantum;
+    settings.velocity_quantum = header.velocity_quantum;
+    settings.keyframe_interval = header.keyframe_interval;
+
+    // Use the index if the recorder got to write it and it agrees with the frames.
+    if (file.size() >= sizeof(FileHeader) + sizeof(Trailer)) {
+        Trailer trailer;
+        std::memcpy(&trailer, file.data() + file.size() - sizeof(Trailer), sizeof(trailer));
+        // Bounded before it is multiplied, so a corrupt count cannot wrap the size check around.
+        const std::uint64_t index_end = file.size() - sizeof(Trailer);
+        if (std::memcmp(trailer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0
+            && trailer.frame_count <= (index_end - sizeof(FileHeader)) / sizeof(TrajectoryIndexEntry)
+            && trailer.index_offset == index_end - trailer.frame_count * sizeof(TrajectoryIndexEntry)) {
+            index.resize(trailer.frame_count);
+            std::memcpy(index.data(), file.data() + trailer.index_offset, index.size() * sizeof(TrajectoryIndexEntry));
+            complete = index_is_valid(trailer.index_offset);
+        }
+    }
+    if (!complete) rebuild_index();
+}
+
+bool TrajectoryReader::index_is_valid(const std::uint64_t frames_end) const {
+    std::uint64_t next_offset = sizeof(FileHeader);
+    for (std::size_t k = 0; k < index.size(); ++k) {
+        const TrajectoryIndexEntry& entry = index[k];
+        if (entry.offset < next_offset || entry.offset > frames_end - sizeof(FrameHeader)) return false;
+        if (k > 0 && entry.step <= index[k - 1].step) return false;
+        FrameHeader header;
+        std::memcpy(&header, file.data() + entry.offset, sizeof(header));
+        if (header.payload_size > frames_end - entry.offset - sizeof(FrameHeader)) return false;
+        if (header.step != entry.step) return false;
+        // A keyframe is decoded from itself, a delta frame from the keyframe of the frame before it, so by
+        // induction every entry points back at an earlier frame that carries the KEYFRAME flag.
+        if (header.flags == KEYFRAME) {
+            if (entry.keyframe != k) return false;
+        } else if (header.flags != 0 || k == 0 || entry.keyframe != index[k - 1].keyframe) {
+            return false;
+        }
+        next_offset = entry.offset + sizeof(FrameHeader) + header.payload_size;
+    }
+    return true;
+}
+
+void TrajectoryReader::rebuild_index() {
+    index.clear();
+    std::uint64_t offset = sizeof(FileHeader);
+    std::uint64_t keyframe = 0;
+    std::uint32_t body_count = 0;
+    // Stop at the first frame that does not fit or does not follow from the frames before it: that is where the
+    // recording was cut off, possibly in the middle of the index, whose bytes must not pass for a frame.
+    while (offset + sizeof(FrameHeader) <= file.size()) {
+        FrameHeader header;
+        std::memcpy(&header, file.data() + offset, sizeof(header));
+        if (header.payload_size > file.size() - offset - sizeof(FrameHeader)) break;
+        if (header.flags != 0 && header.flags != KEYFRAME) break;
+        if (!index.empty() && header.step <= index.back().step) break;
+        // Every value is a varint of 1 to 10 bytes: the radius and four channels per body in a keyframe, the
+        // four channels in a delta frame.
+        const std::uint64_t values = static_cast<std::uint64_t>(header.body_count) * (header.flags == KEYFRAME ? 5 : 4);
+        if (header.payload_size < values || header.payload_size > 10 * values) break;
+        if (header.flags == KEYFRAME) {
+            keyframe = index.size();
+            body_count = header.body_count;
+        } else if (index.empty() || header.body_count != body_count) {
+            break;
+        }
+        index.push_back({offset, header.step, header.time, keyframe});
+        offset += sizeof(FrameHeader) + header.payload_size;
+    }
+}
+
+const TrajectorySettings& TrajectoryReader::get_settings() const {
+    return settings;
+}
+
+std::size_t TrajectoryReader::frame_count() const {
+    return index.size();
+}
+
+bool TrajectoryReader::has_index() const {
+    return complete;
+}
+
+std::uint64_t TrajectoryReader::frame_step(const std::size_t frame) const {
+    return index.at(frame).step;
+}
+
+double TrajectoryReader::frame_time(const std::size_t frame) const {
+    return index.at(frame).time;
+}
+
+bool TrajectoryReader::is_keyframe(const std::size_t frame) const {
+    return index.at(frame).keyframe == frame;
+}
+
+std::size_t TrajectoryReader::find_frame(const std::uint64_t step) const {
+    auto after = std::upper_bound(index.begin(), index.end(), step,
+                                  [](const std::uint64_t s, const TrajectoryIndexEntry& entry) { return s < entry.step; });
+    return after == index.begin() ? 0 : static_cast<std::size_t>(after - index.begin()) - 1;
+}
+
+void TrajectoryReader::decode(const std::size_t frame) {
+    if (frame >= index.size()) {
+        throw std::out_of_range("Trajectory frame " + std::to_string(frame) + " of " + std::to_string(index.size()));
+    }
+    if (frame == decoded) return;
+    std::size_t first = static_cast<std::size_t>(index[frame].keyframe);
+    // Stepping forward within the same keyframe run only needs the deltas after the frame already decoded.
+    if (decoded != NO_FRAME && decoded < frame && index[decoded].keyframe == index[frame].keyframe) first = decoded + 1;
+
+    for (std::size_t f = first; f <= frame; ++f) {
+        // Cleared until the frame is fully applied, so a corrupt frame never leaves a half-decoded state behind.
+        decoded = NO_FRAME;
+        FrameHeader header;
+        const std::uint64_t offset = index[f].offset;
+        if (offset + sizeof(FrameHeader) > file.size()) {
+            throw std::runtime_error("Trajectory frame is corrupt");
+        }
+        std::memcpy(&header, file.data() + offset, sizeof(header));
+        if (header.payload_size > file.size() - offset - sizeof(FrameHeader)) {
+            throw std::runtime_error("Trajectory frame is corrupt");
+        }
+        const unsigned char* cursor = reinterpret_cast<const unsigned char*>(file.data() + offset + sizeof(FrameHeader));
+        const unsigned char* end = cursor + header.payload_size;
+        const std::size_t n = header.body_count;
+        if (header.flags & KEYFRAME) {
+            radius.resize(n);
+            for (std::size_t i = 0; i < n; ++i) radius[i] = static_cast<double>(unzigzag(get_varint(cursor, end))) * settings.position_quantum;
+            for (int c = 0; c < 4; ++c) state[c].assign(n, 0);
+        } else if (state[0].size() != n) {
+            throw std::runtime_error("Trajectory frame is corrupt");
+        }
+        for (int c = 0; c < 4; ++c) {
+            std::int64_t* values = state[c].data();
+            for (std::size_t i = 0; i < n; ++i) values[i] += unzigzag(get_varint(cursor, end));
+        }
+        decoded = f;
+    }
+}
+
+void TrajectoryReader::read(const std::size_t frame, TrajectoryFrame& out) {
+    decode(frame);
+    const std::size_t n = state[0].size();
+    std::vector<double>* channels[4] = {&out.x, &out.y, &out.vx, &out.vy};
+    for (int c = 0; c < 4; ++c) {
+        const double quantum = c < 2 ? settings.position_quantum : settings.velocity_quantum;
+        channels[c]->resize(n);
+        for (std::size_t i = 0; i < n; ++i) (*channels[c])[i] = static_cast<double>(state[c][i]) * quantum;
+    }
+    out.radius.assign(radius.begin(), radius.end());
+    out.step = index[frame].step;
+    out.time = index[frame].time;
+}
+
+void TrajectoryReader::read(const std::size_t frame, Snapshot& out) {
+    decode(frame);
+    const std::size_t n = state[0].size();
+    out.x.resize(n);
+    out.y.resize(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out.x[i] = static_cast<double>(state[0][i]) * settings.position_quantum;
+        out.y[i] = static_cast<double>(state[1][i]) * settings.position_quantum;
+    }
+    out.radius.assign(radius.begin(), radius.end());
+    out.step = index[frame].step;
+    out.time = index[frame].time;
+    out.asleep = 0;
+}
+
+
+TrajectoryPlayer::TrajectoryPlayer(TrajectoryReader& reader, SnapshotBuffer& snapshots, const double speed, const bool loop)
+    : reader(reader), snapshots(snapshots), speed(speed), loop(loop), seek_target(NO_FRAME) {}
+
+TrajectoryPlayer::~TrajectoryPlayer() {
+    stop();
+}
+
+bool TrajectoryPlayer::is_running() const {
+    return running.load();
+}
+
+void TrajectoryPlayer::start() {
+    if (running.exchange(true)) return;
+    worker = std::thread(&TrajectoryPlayer::run, this);
+}
+
+void TrajectoryPlayer::stop() {
+    running.store(false);
+    if (worker.joinable()) worker.join();
+}
+
+void TrajectoryPlayer::seek(const std::uint64_t step) {
+    seek_target.store(reader.find_frame(step));
+}
+
+void TrajectoryPlayer::run() {
+    typedef std::chrono::steady_clock Clock;
+    // Sleep in short slices so stop() and seek() take effect promptly.
+    const std::chrono::milliseconds slice(10);
+    if (reader.frame_count() == 0) return;
+
+    std::size_t frame = 0;
+    Clock::time_point base_clock = Clock::now();
+    double base_time = reader.frame_time(0);
+    while (running.load()) {
+        const std::size_t target = seek_target.exchange(NO_FRAME);
+        if (target != NO_FRAME) frame = target;
+        if (frame >= reader.frame_count()) {
+            if (!loop) {
+                std::this_thread::sleep_for(slice);
+                continue;
+            }
+            frame = 0;
+        }
+        if (target != NO_FRAME || frame == 0) {
+            base_clock = Clock::now();
+            base_time = reader.frame_time(frame);
+        }
+
+        const double due = (reader.frame_time(frame) - base_time) / speed;
+        const double now = std::chrono::duration<double>(Clock::now() - base_clock).count();
+        if (now < due) {
+            std::this_thread::sleep_for(std::min<std::chrono::duration<double>>(std::chrono::duration<double>(due - now), slice));
+            continue;
+        }
+        reader.read(frame, snapshots.begin_write());
+        snapshots.publish();
+        ++frame;
+    }
+}
@@ -0,0 +1,167 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include "MappedFile.h"
+#include "Simulation.h"
+#include "SnapshotBuffer.h"
+
+struct TrajectorySettings {
+    double position_quantum = 1e-3;        // positions are stored as multiples of this
+    double velocity_quantum = 1e-3;        // velocities are stored as multiples of this
+    std::uint32_t keyframe_interval = 64;  // frames between two keyframes
+    std::size_t buffered_frames = 4;       // frames queued for the writer thread before record() waits
+};
+
+// One recorded state of every body.
+struct TrajectoryFrame {
+    std::uint64_t step = 0;
+    double time = 0.0;   // simulated seconds
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> vx;
+    std::vector<double> vy;
+    std::vector<double> radius;
+
+    std::size_t size() const;
+};
+
+// Where a frame starts in the file, and the keyframe it is decoded from.
+struct TrajectoryIndexEntry {
+    std::uint64_t offset;
+    std::uint64_t step;
+    double time;
+    std::uint64_t keyframe;
+};
+
+// Streams frames of a running simulation to a file on a background thread.
+//
+// Positions and velocities are quantized to integers. Each frame stores the difference to the previous frame,
+// zigzag-mapped and written as variable-length integers, so a body that moved little costs a byte or two per
+// value. Every keyframe_interval frames, and whenever the body count or a radius changes, a keyframe stores the
+// absolute values (and the radii) instead. close() appends an index of every frame.
+//
+// File layout (version 1, native byte order): a 64 byte header, the frames, each a 32 byte frame header and its
+// payload, then the index and a 24 byte trailer. A file cut short by a crash has no index; the reader rebuilds
+// it from the frame headers.
+class TrajectoryRecorder {
+    private:
+        TrajectorySettings settings;
+        std::ofstream out;
+
+        // Frames flow from free to queued (filled by record()) and back (written by the worker).
+        std::vector<std::unique_ptr<TrajectoryFrame>> free_frames;
+        std::deque<std::unique_ptr<TrajectoryFrame>> queued;
+        bool closing = false;
+        std::string error;
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::thread worker;
+
+        // Owned by the worker thread.
+        std::vector<std::int64_t> previous[4];
+        std::vector<double> keyframe_radius;
+        std::vector<unsigned char> payload;
+        std::uint32_t since_keyframe = 0;
+        std::vector<TrajectoryIndexEntry> index;
+        std::uint64_t bytes_written = 0;
+        std::atomic<std::uint64_t> frames_written{0};
+        std::atomic<std::uint64_t> stalls{0};
+
+        void run();
+        void write_frame(const TrajectoryFrame& frame);
+
+    public:
+        // Throws std::runtime_error if the file cannot be created.
+        explicit TrajectoryRecorder(const std::string& path, const TrajectorySettings& settings = TrajectorySettings());
+        ~TrajectoryRecorder();
+        TrajectoryRecorder(const TrajectoryRecorder&) = delete;
+        TrajectoryRecorder& operator=(const TrajectoryRecorder&) = delete;
+
+        // Copies the state and queues it. Waits only if the writer has fallen buffered_frames behind.
+        void record(const ParticleSystem& particles, const std::uint64_t step, const double time);
+        // Writes the queued frames and the index. Throws std::runtime_error if any write failed.
+        void close();
+
+        const TrajectorySettings& get_settings() const;
+        std::uint64_t get_frames_written() const;
+        // Number of record() calls that had to wait for the writer.
+        std::uint64_t get_stalls() const;
+        // Bytes of the file so far; only meaningful after close().
+        std::uint64_t get_bytes_written() const;
+};
+
+// Random access to a recorded trajectory. The file is memory-mapped; reading frame k decodes its keyframe and
+// the deltas after it, at most keyframe_interval frames, and reading the frame after the last one read decodes
+// a single delta. Throws std::runtime_error for a file that is not a trajectory or is corrupt.
+class TrajectoryReader {
+    private:
+        MappedFile file;
+        TrajectorySettings settings;
+        std::vector<TrajectoryIndexEntry> index;
+        bool complete = false;
+
+        // The quantized state of the last decoded frame.
+        std::vector<std::int64_t> state[4];
+        std::vector<double> radius;
+        std::size_t decoded = static_cast<std::size_t>(-1);
+
+        void rebuild_index();
+        // Whether the index read from the trailer describes the frames before frames_end: offsets and steps
+        // increase, every frame fits, and every entry is decoded from a keyframe at or before it.
+        bool index_is_valid(const std::uint64_t frames_end) const;
+        void decode(const std::size_t frame);
+
+    public:
+        explicit TrajectoryReader(const std::string& path);
+        const TrajectorySettings& get_settings() const;
+        std::size_t frame_count() const;
+        // False if the file was not closed properly and the index was rebuilt from the frames.
+        bool has_index() const;
+        std::uint64_t frame_step(const std::size_t frame) const;
+        double frame_time(const std::size_t frame) const;
+        bool is_keyframe(const std::size_t frame) const;
+        // The last frame recorded at or before step, or 0 if step is before the first frame.
+        std::size_t find_frame(const std::uint64_t step) const;
+        void read(const std::size_t frame, TrajectoryFrame& out);
+        // Positions and radii only, for the renderer.
+        void read(const std::size_t frame, Snapshot& out);
+};
+
+// Plays a trajectory into a SnapshotBuffer on its own thread at the recorded pace, in place of a
+// SimulationThread, so the render loop draws a recording exactly as it draws a live simulation. Nothing else
+// may use the reader while the player runs.
+class TrajectoryPlayer {
+    private:
+        TrajectoryReader& reader;
+        SnapshotBuffer& snapshots;
+        double speed;
+        bool loop;
+        std::atomic<bool> running{false};
+        std::atomic<std::size_t> seek_target;
+        std::thread worker;
+
+        void run();
+
+    public:
+        // speed scales the playback rate; with loop the recording restarts after the last frame.
+        TrajectoryPlayer(TrajectoryReader& reader, SnapshotBuffer& snapshots, const double speed = 1.0, const bool loop = true);
+        ~TrajectoryPlayer();
+        TrajectoryPlayer(const TrajectoryPlayer&) = delete;
+        TrajectoryPlayer& operator=(const TrajectoryPlayer&) = delete;
+
+        bool is_running() const;
+        void start();
+        void stop();
+        // Continues playback from the last frame at or before step. Safe from any thread.
+        void seek(const std::uint64_t step);
+};
+
+
+#endif // TRAJECTORY_H
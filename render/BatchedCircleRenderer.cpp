@@ -0,0 +1,108 @@
+#include "BatchedCircleRenderer.h"
+#include <algorithm>
+#include <cmath>
+
+BatchedCircleRenderer::BatchedCircleRenderer(const Mode mode, const unsigned int segments, const sf::Color& color)
+    : mode(mode), segments(std::max(3u, segments)), color(color) {
+    if (mode == Mode::TexturedQuad) {
+        vertices.setPrimitiveType(sf::Quads);
+        build_texture();
+    } else {
+        vertices.setPrimitiveType(sf::Triangles);
+        unit_x.resize(this->segments + 1);
+        unit_y.resize(this->segments + 1);
+        for (unsigned int s = 0; s <= this->segments; ++s) {
+            double angle = 2.0 * M_PI * s / this->segments;
+            unit_x[s] = static_cast<float>(std::cos(angle));
+            unit_y[s] = static_cast<float>(std::sin(angle));
+        }
+    }
+}
+
+void BatchedCircleRenderer::build_texture() {
+    // White disc with a one-texel anti-aliased rim; the vertex color tints it.
+    sf::Image image;
+    image.create(TEXTURE_SIZE, TEXTURE_SIZE, sf::Color::Transparent);
+    const double center = 0.5 * TEXTURE_SIZE;
+    for (unsigned int py = 0; py < TEXTURE_SIZE; ++py) {
+        for (unsigned int px = 0; px < TEXTURE_SIZE; ++px) {
+            double dx = px + 0.5 - center;
+            double dy = py + 0.5 - center;
+            double coverage = center - std::sqrt(dx * dx + dy * dy);
+            coverage = std::min(1.0, std::max(0.0, coverage));
+            image.setPixel(px, py, sf::Color(255, 255, 255, static_cast<unsigned char>(255 * coverage)));
+        }
+    }
+    texture.loadFromImage(image);
+    texture.setSmooth(true);
+}
+
+BatchedCircleRenderer::Mode BatchedCircleRenderer::get_mode() const {
+    return mode;
+}
+
+unsigned int BatchedCircleRenderer::get_segments() const {
+    return segments;
+}
+
+std::size_t BatchedCircleRenderer::get_vertex_count() const {
+    return vertices.getVertexCount();
+}
+
+void BatchedCircleRenderer::write_ball(const std::size_t index, const float x, const float y, const float radius) {
+    if (mode == Mode::TexturedQuad) {
+        const float size = static_cast<float>(TEXTURE_SIZE);
+        sf::Vertex* quad = &vertices[index * 4];
+        quad[0].position = sf::Vector2f(x - radius, y - radius);
+        quad[1].position = sf::Vector2f(x + radius, y - radius);
+        quad[2].position = sf::Vector2f(x + radius, y + radius);
+        quad[3].position = sf::Vector2f(x - radius, y + radius);
+        quad[0].texCoords = sf::Vector2f(0.0f, 0.0f);
+        quad[1].texCoords = sf::Vector2f(size, 0.0f);
+        quad[2].texCoords = sf::Vector2f(size, size);
+        quad[3].texCoords = sf::Vector2f(0.0f, size);
+        for (int v = 0; v < 4; ++v) quad[v].color = color;
+        return;
+    }
+
+    sf::Vertex* fan = &vertices[index * 3 * segments];
+    const sf::Vector2f center(x, y);
+    for (unsigned int s = 0; s < segments; ++s) {
+        fan[3 * s].position = center;
+        fan[3 * s + 1].position = sf::Vector2f(x + radius * unit_x[s], y + radius * unit_y[s]);
+        fan[3 * s + 2].position = sf::Vector2f(x + radius * unit_x[s + 1], y + radius * unit_y[s + 1]);
+        fan[3 * s].color = color;
+        fan[3 * s + 1].color = color;
+        fan[3 * s + 2].color = color;
+    }
+}
+
+void BatchedCircleRenderer::update(const double* x, const double* y, const double* radius, const std::size_t count) {
+    const std::size_t per_ball = mode == Mode::TexturedQuad ? 4 : 3 * segments;
+    vertices.resize(count * per_ball);
+    for (std::size_t i = 0; i < count; ++i) {
+        write_ball(i, static_cast<float>(x[i]), static_cast<float>(y[i]), static_cast<float>(radius[i]));
+    }
+}
+
+void BatchedCircleRenderer::update(const Snapshot& latest, const Snapshot& previous, const double alpha) {
+    if (alpha >= 1.0 || previous.size() != latest.size()) {
+        update(latest.x.data(), latest.y.data(), latest.radius.data(), latest.size());
+        return;
+    }
+    const std::size_t per_ball = mode == Mode::TexturedQuad ? 4 : 3 * segments;
+    vertices.resize(latest.size() * per_ball);
+    for (std::size_t i = 0; i < latest.size(); ++i) {
+        double x = previous.x[i] + alpha * (latest.x[i] - previous.x[i]);
+        double y = previous.y[i] + alpha * (latest.y[i] - previous.y[i]);
+        write_ball(i, static_cast<float>(x), static_cast<float>(y), static_cast<float>(latest.radius[i]));
+    }
+}
+
+void BatchedCircleRenderer::draw(sf::RenderTarget& target) const {
+    if (mode == Mode::TexturedQuad) {
+        target.draw(vertices, sf::RenderStates(&texture));
+    } else {
+        target.draw(vertices);
+    }
+}
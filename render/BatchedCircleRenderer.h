@@ -0,0 +1,43 @@
+#ifndef BATCHED_CIRCLE_RENDERER_H
+#define BATCHED_CIRCLE_RENDERER_H
+
+#include <SFML/Graphics.hpp>
+#include "../physics/SnapshotBuffer.h"
+
+// Draws every ball with a single draw call. The geometry of all balls is written straight from the particle
+// positions into one persistent vertex array, which keeps its storage from frame to frame.
+//  - TexturedQuad: one quad per ball with an anti-aliased circle texture (4 vertices per ball).
+//  - TriangleFan: a polygon of `segments` triangles per ball, written as a triangle list so all balls fit
+//    in one primitive (3 * segments vertices per ball). No texture is involved.
+class BatchedCircleRenderer {
+    public:
+        enum class Mode { TexturedQuad, TriangleFan };
+
+    private:
+        static constexpr unsigned int TEXTURE_SIZE = 64;
+
+        Mode mode;
+        unsigned int segments;
+        sf::Color color;
+        sf::VertexArray vertices;
+        sf::Texture texture;
+        std::vector<float> unit_x;   // unit circle, segments + 1 points
+        std::vector<float> unit_y;
+
+        void build_texture();
+        void write_ball(const std::size_t index, const float x, const float y, const float radius);
+
+    public:
+        BatchedCircleRenderer(const Mode mode = Mode::TexturedQuad, const unsigned int segments = 16, const sf::Color& color = sf::Color::White);
+        Mode get_mode() const;
+        unsigned int get_segments() const;
+        std::size_t get_vertex_count() const;
+
+        void update(const double* x, const double* y, const double* radius, const std::size_t count);
+        // Positions blended between two snapshots, alpha = 0 is previous and alpha = 1 is latest.
+        void update(const Snapshot& latest, const Snapshot& previous, const double alpha);
+        void draw(sf::RenderTarget& target) const;
+};
+
+
+#endif // BATCHED_CIRCLE_RENDERER_H
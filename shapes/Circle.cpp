@@ -1,81 +1,97 @@
 #include "Circle.h"
 
 
-Circle::Circle(std::shared_ptr<Point> center, double radius) : center(center), radius(radius) {
-    this->velocity = std::make_shared<Point>();
-    this->acceleration = std::make_shared<Point>();
-    this->mass = 1.0;
+template <typename T>
+BasicCircle<T>::BasicCircle(std::shared_ptr<BasicPoint<T>> center, T radius) : center(center), radius(radius) {
+    this->velocity = make_pooled<BasicPoint<T>>();
+    this->acceleration = make_pooled<BasicPoint<T>>();
+    this->mass = T(1);
 }
 
-std::shared_ptr<Point> Circle::getCenter() const {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicCircle<T>::getCenter() const {
     return center;
 }
 
-double Circle::getRadius() const {
+template <typename T>
+T BasicCircle<T>::getRadius() const {
     return radius;
 }
 
-std::shared_ptr<Circle> Circle::setCenter(std::shared_ptr<Point> center) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setCenter(std::shared_ptr<BasicPoint<T>> center) {
     this->center = center;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Circle> Circle::setCenterX(double x) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setCenterX(T x) {
     this->center->set_x(x);
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Circle> Circle::setCenterY(double y) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setCenterY(T y) {
     this->center->set_y(y);
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
 
-std::shared_ptr<Circle> Circle::setRadius(double radius) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setRadius(T radius) {
     this->radius = radius;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Circle::getVelocity() const {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicCircle<T>::getVelocity() const {
     return velocity;
 }
 
-std::shared_ptr<Point> Circle::getAcceleration() const {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicCircle<T>::getAcceleration() const {
     return acceleration;
 }
 
-double Circle::getMass() const{
+template <typename T>
+T BasicCircle<T>::getMass() const{
     return mass;
 }
 
-std::shared_ptr<Circle> Circle::setVelocity(std::shared_ptr<Point> velocity) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setVelocity(std::shared_ptr<BasicPoint<T>> velocity) {
     this->velocity = velocity;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Circle> Circle::setAcceleration(std::shared_ptr<Point> acceleration) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setAcceleration(std::shared_ptr<BasicPoint<T>> acceleration) {
     this->acceleration = acceleration;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Circle> Circle::setVelocity(const double x, const double y) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setVelocity(const T x, const T y) {
     this->velocity->set_x(x);
     this->velocity->set_y(y);
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Circle> Circle::setAcceleration(const double x, const double y) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setAcceleration(const T x, const T y) {
     this->acceleration->set_x(x);
     this->acceleration->set_y(y);
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Circle> Circle::setMass(double mass) {
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::setMass(T mass) {
     this->mass = mass;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-void Circle::update_physics(const double delta_time){
+template <typename T>
+void BasicCircle<T>::update_physics(const T delta_time){
     if (velocity != nullptr && acceleration != nullptr) {
         velocity->set_x(velocity->get_x() + acceleration->get_x() * delta_time);
         velocity->set_y(velocity->get_y() + acceleration->get_y() * delta_time);
@@ -90,35 +106,54 @@ void Circle::update_physics(const double delta_time){
 }
 
 
-double Circle::area() const {
-    return M_PI * radius * radius;
+template <typename T>
+T BasicCircle<T>::area() const {
+    return static_cast<T>(M_PI) * radius * radius;
 }
 
-double Circle::circumference() const {
-    return 2 * M_PI * radius;
+template <typename T>
+T BasicCircle<T>::circumference() const {
+    return 2 * static_cast<T>(M_PI) * radius;
 }
 
-double Circle::diameter() const {
+template <typename T>
+T BasicCircle<T>::diameter() const {
     return 2 * radius;
 }
 
-bool Circle::contains(const std::shared_ptr<Point> point) const {
-    return center->distance_to(point) <= radius;
+template <typename T>
+bool BasicCircle<T>::contains(const std::shared_ptr<BasicPoint<T>> point) const {
+    return this->contains(point->to_vec2());
 }
 
-bool Circle::is_intersecting(const std::shared_ptr<Circle> other) const {
-    return center->distance_to(other->getCenter()) <= radius + other->getRadius();
+template <typename T>
+bool BasicCircle<T>::contains(const Vec2& point) const {
+    return center->to_vec2().distance_squared_to(point) <= radius * radius;
 }
 
-void Circle::move(const double dx, const double dy) {
+template <typename T>
+bool BasicCircle<T>::is_intersecting(const std::shared_ptr<BasicCircle> other) const {
+    return this->is_intersecting(other->getCenter()->to_vec2(), other->getRadius());
+}
+
+template <typename T>
+bool BasicCircle<T>::is_intersecting(const Vec2& other_center, const double other_radius) const {
+    double reach = radius + other_radius;
+    return center->to_vec2().distance_squared_to(other_center) <= reach * reach;
+}
+
+template <typename T>
+void BasicCircle<T>::move(const T dx, const T dy) {
     this->center->move(dx, dy);
 }
 
-void Circle::extend(const double factor) {
+template <typename T>
+void BasicCircle<T>::extend(const T factor) {
     this->radius *= factor;
 }
 
-std::shared_ptr<Line> Circle::solve_with(const std::shared_ptr<Line> line) const {
+template <typename T>
+std::shared_ptr<Line> BasicCircle<T>::solve_with(const std::shared_ptr<Line> line) const {
     double m = line->get_slope();
     double c = line->get_intercept();
 
@@ -126,51 +161,64 @@ std::shared_ptr<Line> Circle::solve_with(const std::shared_ptr<Line> line) const
     double b = this->center->get_y();
     double r = radius;
 
-    std::vector<double> roots = solve_quadratic(
+    double roots[2];
+    const int root_count = solve_quadratic(
         1 + m * m, 
         -2 * a + 2 * m * (c - b), 
-        a * a + (c - b) * (c - b) - r * r
+        a * a + (c - b) * (c - b) - r * r,
+        roots
     );
 
-    if (roots.size() == 1) {
-        return std::make_shared<Line>(
-            std::make_shared<Point>(roots[0], m * roots[0] + c),
-            std::make_shared<Point>(roots[0], m * roots[0] + c)
+    if (root_count == 1) {
+        return make_pooled<Line>(
+            make_pooled<Point>(roots[0], m * roots[0] + c),
+            make_pooled<Point>(roots[0], m * roots[0] + c)
         );
-    } else if (roots.size() == 2) { 
-        return std::make_shared<Line>( 
-            std::make_shared<Point>(roots[0], m * roots[0] + c),
-            std::make_shared<Point>(roots[1], m * roots[1] + c)
+    } else if (root_count == 2) { 
+        return make_pooled<Line>( 
+            make_pooled<Point>(roots[0], m * roots[0] + c),
+            make_pooled<Point>(roots[1], m * roots[1] + c)
         );
     }
-    return std::make_shared<Line>(std::make_shared<Point>(), std::make_shared<Point>()); // should never happen
+    return make_pooled<Line>(make_pooled<Point>(), make_pooled<Point>()); // should never happen
 
 }
 
-bool Circle::is_tangent(const std::shared_ptr<Circle> other) const {
-    return abs(this->center->distance_to(other->getCenter()) - this->radius + other->getRadius()) <= Shape::EPSILON_ERROR;
+template <typename T>
+bool BasicCircle<T>::is_tangent(const std::shared_ptr<BasicCircle> other) const {
+    return std::abs(this->center->distance_to(other->getCenter()) - this->radius + other->getRadius()) <= Shape::EPSILON_ERROR;
 }
 
-bool Circle::is_disjoint(const std::shared_ptr<Circle> other) const {
+template <typename T>
+bool BasicCircle<T>::is_disjoint(const std::shared_ptr<BasicCircle> other) const {
     return this->center->distance_to(other->getCenter()) > this->radius + other->getRadius();
 }
 
-bool Circle::is_equal(const std::shared_ptr<Circle> other) const {
+template <typename T>
+bool BasicCircle<T>::is_equal(const std::shared_ptr<BasicCircle> other) const {
     return this->center->is_equal(other->getCenter()) && this->radius == other->getRadius();
 }
 
-std::shared_ptr<sf::CircleShape> Circle::to_circle_shape(const sf::Color& color) const {
+#ifndef PHYSICS_HEADLESS
+template <typename T>
+std::shared_ptr<sf::CircleShape> BasicCircle<T>::to_circle_shape(const sf::Color& color) const {
     std::shared_ptr<sf::CircleShape> circle = std::make_shared<sf::CircleShape>(radius);
-    std::shared_ptr<Point> bottom_left = std::make_shared<Point>(center->get_x() - radius, center->get_y() - radius);
+    std::shared_ptr<BasicPoint<T>> bottom_left = make_pooled<BasicPoint<T>>(center->get_x() - radius, center->get_y() - radius);
     circle->setPosition(*bottom_left->to_vector2f());
     circle->setFillColor(color);
     return circle;
 }
+#endif
 
-std::string Circle::to_string() const {
+template <typename T>
+std::string BasicCircle<T>::to_string() const {
     return "Circle[" + this->center->to_string() + ", " + std::to_string(this->radius) + "]";
 }
 
-std::shared_ptr<Circle> Circle::clone() const {
-    return std::make_shared<Circle>(this->center, this->radius);
+template <typename T>
+std::shared_ptr<BasicCircle<T>> BasicCircle<T>::clone() const {
+    return make_pooled<BasicCircle>(this->center, this->radius);
 }
+
+template class BasicCircle<float>;
+template class BasicCircle<double>;
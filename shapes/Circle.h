@@ -4,48 +4,64 @@
 
 #include "Line.h"
 
-class Circle : public Shape, public std::enable_shared_from_this<Circle> {
+// A ball with center, velocity and acceleration of type T. As for BasicPoint, only the float and double
+// instantiations exist: Circle (double) is what the rest of the shapes and the physics take, Circlef is the
+// compact one. Line is double only, so solve_with returns the crossing points in double either way.
+template <typename T>
+class BasicCircle : public Shape, public std::enable_shared_from_this<BasicCircle<T>> {
     private:
-        std::shared_ptr<Point> center{}; // position
-        std::shared_ptr<Point> velocity{};
-        std::shared_ptr<Point> acceleration{};
-        double radius;
-        double mass;
+        std::shared_ptr<BasicPoint<T>> center{}; // position
+        std::shared_ptr<BasicPoint<T>> velocity{};
+        std::shared_ptr<BasicPoint<T>> acceleration{};
+        T radius;
+        T mass;
 
 
 
     public:
-        Circle(std::shared_ptr<Point> center, double radius);
-        std::shared_ptr<Point> getCenter() const;
-        double getRadius() const;
-        std::shared_ptr<Point> getVelocity() const;
-        std::shared_ptr<Point> getAcceleration() const;
-        double getMass() const;
-        std::shared_ptr<Circle> setCenter(std::shared_ptr<Point> center);
-        std::shared_ptr<Circle> setCenterX(double x);
-        std::shared_ptr<Circle> setCenterY(double y);
-        std::shared_ptr<Circle> setRadius(double radius);
-        std::shared_ptr<Circle> setVelocity(const double x, const double y);
-        std::shared_ptr<Circle> setAcceleration(const double x, const double y);
-        std::shared_ptr<Circle> setVelocity(std::shared_ptr<Point> velocity);
-        std::shared_ptr<Circle> setAcceleration(std::shared_ptr<Point> acceleration);
-        std::shared_ptr<Circle> setMass(double mass);
-        void update_physics(const double delta_time);
-        double area() const;
-        double circumference() const;
-        double diameter() const;
-        bool contains(const std::shared_ptr<Point> point) const;
-        bool is_intersecting(const std::shared_ptr<Circle> other) const;
-        void move (const double dx, const double dy);
-        void extend (const double factor);
+        typedef T scalar_type;
+
+        BasicCircle(std::shared_ptr<BasicPoint<T>> center, T radius);
+        std::shared_ptr<BasicPoint<T>> getCenter() const;
+        T getRadius() const;
+        std::shared_ptr<BasicPoint<T>> getVelocity() const;
+        std::shared_ptr<BasicPoint<T>> getAcceleration() const;
+        T getMass() const;
+        std::shared_ptr<BasicCircle> setCenter(std::shared_ptr<BasicPoint<T>> center);
+        std::shared_ptr<BasicCircle> setCenterX(T x);
+        std::shared_ptr<BasicCircle> setCenterY(T y);
+        std::shared_ptr<BasicCircle> setRadius(T radius);
+        std::shared_ptr<BasicCircle> setVelocity(const T x, const T y);
+        std::shared_ptr<BasicCircle> setAcceleration(const T x, const T y);
+        std::shared_ptr<BasicCircle> setVelocity(std::shared_ptr<BasicPoint<T>> velocity);
+        std::shared_ptr<BasicCircle> setAcceleration(std::shared_ptr<BasicPoint<T>> acceleration);
+        std::shared_ptr<BasicCircle> setMass(T mass);
+        void update_physics(const T delta_time);
+        T area() const;
+        T circumference() const;
+        T diameter() const;
+        bool contains(const std::shared_ptr<BasicPoint<T>> point) const;
+        bool contains(const Vec2& point) const;
+        bool is_intersecting(const std::shared_ptr<BasicCircle> other) const;
+        bool is_intersecting(const Vec2& other_center, const double other_radius) const;
+        void move (const T dx, const T dy);
+        void extend (const T factor);
         std::shared_ptr<Line> solve_with(const std::shared_ptr<Line> line) const;
-        bool is_tangent(const std::shared_ptr<Circle> other) const;
-        bool is_disjoint(const std::shared_ptr<Circle> other) const;
-        bool is_equal(const std::shared_ptr<Circle> other) const;
+        bool is_tangent(const std::shared_ptr<BasicCircle> other) const;
+        bool is_disjoint(const std::shared_ptr<BasicCircle> other) const;
+        bool is_equal(const std::shared_ptr<BasicCircle> other) const;
+#ifndef PHYSICS_HEADLESS
         std::shared_ptr<sf::CircleShape> to_circle_shape(const sf::Color& color) const;
+#endif
         std::string to_string() const;
-        std::shared_ptr<Circle> clone() const;
+        std::shared_ptr<BasicCircle> clone() const;
 };
 
+extern template class BasicCircle<float>;
+extern template class BasicCircle<double>;
+
+typedef BasicCircle<double> Circle;
+typedef BasicCircle<float> Circlef;
+
 
 #endif // CIRCLE_H
\ No newline at end of file
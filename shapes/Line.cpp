@@ -1,8 +1,6 @@
 #include "Line.h"
 
-Line::Line(std::shared_ptr<Point> start, std::shared_ptr<Point> end) : start(start), end(end) {
-    calculate_slope_intercept();
-}
+Line::Line(std::shared_ptr<Point> start, std::shared_ptr<Point> end) : start(start), end(end) {}
 
 std::shared_ptr<Point> Line::get_start() const {
     return this->start;
@@ -12,27 +10,30 @@ std::shared_ptr<Point> Line::get_end() const {
 }
 
 double Line::get_slope() const {
+    update_slope_intercept();
     return this->m;
 }
 
 double Line::get_intercept() const{
+    update_slope_intercept();
     return this->c;
 }
 
 std::shared_ptr<Line> Line::set_start(std::shared_ptr<Point> start){
     this->start = start;
-    calculate_slope_intercept();
+    this->cached = false;
     return shared_from_this();
 }
 
 std::shared_ptr<Line> Line::set_end(std::shared_ptr<Point> end){
     this->end = end;
-    calculate_slope_intercept();
+    this->cached = false;
     return shared_from_this();
 }
 
 double Line::length() const{
-    return this->start->distance_to(this->end);
+    update_cache();
+    return this->cached_length;
 }
 
 std::string Line::to_string() const{
@@ -40,103 +41,140 @@ std::string Line::to_string() const{
 }
 
 std::shared_ptr<Line> Line::clone() const{
-    return std::make_shared<Line>(this->start->clone(), this->end->clone());
+    return make_pooled<Line>(this->start->clone(), this->end->clone());
 }
 
 std::shared_ptr<Line> Line::set(const std::shared_ptr<Point> start, const std::shared_ptr<Point> end){
     this->start = start;
     this->end = end;
-    calculate_slope_intercept();
+    this->cached = false;
     return shared_from_this();
 }
 
 std::shared_ptr<Line> Line::set(const std::shared_ptr<Line> other){
     this->start = other->get_start();
     this->end = other->get_end();
-    calculate_slope_intercept();
+    this->cached = false;
     return shared_from_this();
 }
 
 std::shared_ptr<Line> Line::move(const std::shared_ptr<Point> offset){
+    const bool current = cache_current();
     this->start->move(offset->get_x(), offset->get_y());
     this->end->move(offset->get_x(), offset->get_y());
-    calculate_slope_intercept();
+    carry_cache(current, 1.0);
     return shared_from_this();
 }
 
 std::shared_ptr<Line> Line::scale(const double factor){
+    const bool current = cache_current();
     this->start->scale(factor);
     this->end->scale(factor);
-    calculate_slope_intercept();
+    carry_cache(current, std::abs(factor));
     return shared_from_this();
 }
 
 std::shared_ptr<Line> Line::extend(const double factor) {
+    const bool current = cache_current();
     // Compute the midpoint M of the current line.
-    auto mid = this->start->mid_point_to(this->end);
+    Vec2 mid = this->start->to_vec2().mid_point_to(this->end->to_vec2());
 
     // Compute the new endpoints by scaling the vector from M to each endpoint.
-    double new_start_x = mid->get_x() + factor * (this->start->get_x() - mid->get_x());
-    double new_start_y = mid->get_y() + factor * (this->start->get_y() - mid->get_y());
-    double new_end_x   = mid->get_x() + factor * (this->end->get_x() - mid->get_x());
-    double new_end_y   = mid->get_y() + factor * (this->end->get_y() - mid->get_y());
+    Vec2 new_start = mid + factor * (this->start->to_vec2() - mid);
+    Vec2 new_end = mid + factor * (this->end->to_vec2() - mid);
 
-    this->start->set(new_start_x, new_start_y);
-    this->end->set(new_end_x, new_end_y);
-    calculate_slope_intercept();
+    this->start->set(new_start.x, new_start.y);
+    this->end->set(new_end.x, new_end.y);
+    carry_cache(current, std::abs(factor));
 
     return shared_from_this();
 }
 
 std::shared_ptr<Line> Line::rotate_around(const std::shared_ptr<Point> center, const double angle){
+    return this->rotate_around(center->to_vec2(), angle);
+}
+
+std::shared_ptr<Line> Line::rotate_around(const Vec2& center, const double angle){
+    const bool current = cache_current();
     this->start->rotate(center, angle);
     this->end->rotate(center, angle);
-    calculate_slope_intercept();
+    carry_cache(current, 1.0);
     return shared_from_this();
 }
 
 std::shared_ptr<Line> Line::rotate_origin(const double angle){
-    return this->rotate_around(std::make_shared<Point>(), angle);
+    return this->rotate_around(Vec2(), angle);
 }
 
 std::shared_ptr<Line> Line::rotate_center(const double angle){
-    return this->rotate_around(this->start->mid_point_to(this->end), angle);
+    return this->rotate_around(this->start->to_vec2().mid_point_to(this->end->to_vec2()), angle);
+}
+
+bool Line::cache_current() const {
+    return this->cached && this->start->to_vec2() == this->cached_start && this->end->to_vec2() == this->cached_end;
+}
+
+void Line::update_cache() const {
+    if (cache_current()) return;
+    this->cached_start = this->start->to_vec2();
+    this->cached_end = this->end->to_vec2();
+    this->cached = true;
+    this->slope_cached = false;
+    this->cached_length = this->cached_start.distance_to(this->cached_end);
 }
 
-void Line::calculate_slope_intercept(){
-    double dx = this->end->get_x() - this->start->get_x();
+void Line::update_slope_intercept() const {
+    update_cache();
+    if (this->slope_cached) return;
+    double dx = this->cached_end.x - this->cached_start.x;
     if (dx == 0){
         this->m = 1.0 / EPSILON_ERROR;
         this->c = 0;
     } else {
-        this->m = (this->end->get_y() - this->start->get_y()) / dx;
-        this->c = this->start->get_y() - this->m * this->start->get_x();
+        this->m = (this->cached_end.y - this->cached_start.y) / dx;
+        this->c = this->cached_start.y - this->m * this->cached_start.x;
+    }
+    this->slope_cached = true;
+}
+
+void Line::carry_cache(const bool current, const double length_factor) const {
+    if (!current) {
+        this->cached = false;
+        return;
     }
+    this->cached_start = this->start->to_vec2();
+    this->cached_end = this->end->to_vec2();
+    this->slope_cached = false;
+    this->cached_length *= length_factor;
 }
 
 bool Line::on_extended_line(const std::shared_ptr<Point> point) const{
+    return this->on_extended_line(point->to_vec2());
+}
+
+bool Line::on_extended_line(const Vec2& point) const{
     double dx = end->get_x() - start->get_x();
     double dy = end->get_y() - start->get_y();
 
     if (std::abs(dx) < EPSILON_ERROR) {
-        return std::abs(point->get_x() - start->get_x()) < EPSILON_ERROR;
+        return std::abs(point.x - start->get_x()) < EPSILON_ERROR;
     } else if (std::abs(dy) <= EPSILON_ERROR) {
-        return std::abs(point->get_y() - start->get_y()) < EPSILON_ERROR;
+        return std::abs(point.y - start->get_y()) < EPSILON_ERROR;
     } else {
-        return std::abs(this->m * point->get_x() + this->c - point->get_y()) < EPSILON_ERROR;
+        return std::abs(this->get_slope() * point.x + this->get_intercept() - point.y) < EPSILON_ERROR;
     }
 }
 
 bool Line::is_parallel(const std::shared_ptr<Line> other) const {
     // Handle vertical lines: Two vertical lines are parallel.
-    bool thisIsVertical = std::abs(this->m) > 1.0 / Shape::EPSILON_ERROR;
+    bool thisIsVertical = std::abs(this->get_slope()) > 1.0 / Shape::EPSILON_ERROR;
     bool otherIsVertical = std::abs(other->get_slope()) > 1.0 / Shape::EPSILON_ERROR;
 
     if (thisIsVertical && otherIsVertical) return true;
     if (thisIsVertical || otherIsVertical) return false; // One vertical, one not, then not parallel
 
 
-    return std::abs(this->m - other->get_slope()) < Shape::EPSILON_ERROR; 
+    return std::abs(this->get_slope() - other->get_slope()) < Shape::EPSILON_ERROR; 
 }
 
 
@@ -162,23 +200,35 @@ bool Line::is_intersecting(const std::shared_ptr<Line> other) const{
 }
 
 bool Line::between_bounds(const std::shared_ptr<Point> point) const {
+    return this->between_bounds(point->to_vec2());
+}
+
+bool Line::between_bounds(const Vec2& point) const {
     double min_x = std::min(this->start->get_x(), this->end->get_x());
     double max_x = std::max(this->start->get_x(), this->end->get_x());
     double min_y = std::min(this->start->get_y(), this->end->get_y());
     double max_y = std::max(this->start->get_y(), this->end->get_y());
     
-    return (point->get_x() >= min_x && point->get_x() <= max_x &&
-            point->get_y() >= min_y && point->get_y() <= max_y);
+    return (point.x >= min_x && point.x <= max_x &&
+            point.y >= min_y && point.y <= max_y);
 }
 
 
 std::shared_ptr<Point> Line::intersection(const std::shared_ptr<Line> other) const {
-    if (std::abs(this->get_slope() - other->get_slope()) < EPSILON_ERROR) {
+    return make_pooled<Point>(this->intersection(other->get_start()->to_vec2(), other->get_end()->to_vec2()));
+}
+
+Vec2 Line::intersection(const Vec2& other_start, const Vec2& other_end) const {
+    // Parametric form p = start + t * direction, which unlike slope/intercept also handles vertical lines.
+    const Vec2 p = this->start->to_vec2();
+    const Vec2 r = this->end->to_vec2() - p;
+    const Vec2 s = other_end - other_start;
+    const double denominator = r.cross(s);
+    if (std::abs(denominator) <= EPSILON_ERROR * std::sqrt(r.length_squared() * s.length_squared())) {
         throw std::runtime_error("Lines are parallel or coincident; no unique intersection exists");
     }
-    double intersection_x = (other->get_intercept() - this->get_intercept()) / (this->get_slope() - other->get_slope());
-    double intersection_y = this->get_slope() * intersection_x + this->get_intercept();
-    return std::make_shared<Point>(intersection_x, intersection_y);
+    const double t = (other_start - p).cross(s) / denominator;
+    return p + r * t;
 }
 
 
@@ -193,9 +243,9 @@ std::shared_ptr<Line> Line::get_perpendicular_line(const std::shared_ptr<Point>
     if (std::abs(slope) < EPSILON_ERROR) {
         // Create a vertical line through 'point'. 
         // We choose an arbitrary offset in y (here, +1) to define the second point.
-        return std::make_shared<Line>(
+        return make_pooled<Line>(
             point,
-            std::make_shared<Point>(point->get_x(), point->get_y() + 1)
+            make_pooled<Point>(point->get_x(), point->get_y() + 1)
         );
     }
     
@@ -205,9 +255,9 @@ std::shared_ptr<Line> Line::get_perpendicular_line(const std::shared_ptr<Point>
     if (std::abs(slope) >= (1.0 - EPSILON_ERROR) / EPSILON_ERROR) {
         // Create a horizontal line through 'point'.
         // We choose an arbitrary offset in x (here, +1) to define the second point.
-        return std::make_shared<Line>(
+        return make_pooled<Line>(
             point,
-            std::make_shared<Point>(point->get_x() + 1, point->get_y())
+            make_pooled<Point>(point->get_x() + 1, point->get_y())
         );
     }
     
@@ -221,9 +271,9 @@ std::shared_ptr<Line> Line::get_perpendicular_line(const std::shared_ptr<Point>
     double newX = (perpendicular_intercept - this->get_intercept()) / (this->get_slope() - perpendicular_slope);
     double newY = perpendicular_slope * newX + perpendicular_intercept;
     
-    return std::make_shared<Line>(
+    return make_pooled<Line>(
         point,
-        std::make_shared<Point>(newX, newY)
+        make_pooled<Point>(newX, newY)
     );
 }
 
@@ -253,6 +303,7 @@ bool Line::is_equal(const std::shared_ptr<Line> other) const{
            abs(this->get_intercept() - other->get_intercept()) < EPSILON_ERROR;
 }
 
+#ifndef PHYSICS_HEADLESS
 std::shared_ptr<sf::VertexArray> Line::to_vertex_array() const{
     std::shared_ptr<sf::VertexArray> line = std::make_shared<sf::VertexArray>(sf::PrimitiveType::Lines, 2);
     line->operator[](0).position = *this->start->to_vector2f();
@@ -260,3 +311,4 @@ std::shared_ptr<sf::VertexArray> Line::to_vertex_array() const{
     return line;
 
 }
+#endif
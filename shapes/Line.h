@@ -9,8 +9,23 @@ class Line : public Shape, public std::enable_shared_from_this<Line> {
     private:
         std::shared_ptr<Point> start;
         std::shared_ptr<Point> end;
-        double m; // slope
-        double c; // intercept
+        // Derived values, computed on first use from the endpoint coordinates in cached_start and cached_end. They
+        // are stale once an endpoint has moved, by this line or through a Point shared with another shape.
+        mutable bool cached = false;
+        mutable bool slope_cached = false;      // m and c belong to cached_start and cached_end
+        mutable Vec2 cached_start;
+        mutable Vec2 cached_end;
+        mutable double m; // slope
+        mutable double c; // intercept
+        mutable double cached_length;
+
+        bool cache_current() const;
+        void update_cache() const;
+        // The cache brought up to date, and the slope and intercept computed if they are not yet.
+        void update_slope_intercept() const;
+        // After a motion of both endpoints that scales the length by length_factor: keeps the length if the cache
+        // was current before it, and leaves the slope and intercept to the next getter that needs them.
+        void carry_cache(const bool current, const double length_factor) const;
 
     public:
         Line(std::shared_ptr<Point> start, std::shared_ptr<Point> end);
@@ -29,20 +44,27 @@ class Line : public Shape, public std::enable_shared_from_this<Line> {
         std::shared_ptr<Line> scale(const double factor);
         std::shared_ptr<Line> extend(const double factor);
         std::shared_ptr<Line> rotate_around(const std::shared_ptr<Point> center, const double angle);
+        std::shared_ptr<Line> rotate_around(const Vec2& center, const double angle);
         std::shared_ptr<Line> rotate_origin(const double angle);
         std::shared_ptr<Line> rotate_center(const double angle);
-        void calculate_slope_intercept();
         bool on_extended_line(const std::shared_ptr<Point> point) const;
+        bool on_extended_line(const Vec2& point) const;
         bool is_parallel(const std::shared_ptr<Line> other) const;
         bool is_perpendicular(const std::shared_ptr<Line> other) const;
         bool is_intersecting(const std::shared_ptr<Line> other) const;
         bool between_bounds(const std::shared_ptr<Point> point) const;
+        bool between_bounds(const Vec2& point) const;
         std::shared_ptr<Point> intersection(const std::shared_ptr<Line> other) const;
+        // Intersection of the extended lines through this line and through other_start -> other_end.
+        // Throws std::runtime_error for parallel lines. Works for vertical lines as well.
+        Vec2 intersection(const Vec2& other_start, const Vec2& other_end) const;
         std::shared_ptr<Line> get_perpendicular_line(const std::shared_ptr<Point> point) const;
         double evaluate_y(const double x) const;
         double evaluate_x(const double y) const;
         bool is_equal(const std::shared_ptr<Line> other) const;
+#ifndef PHYSICS_HEADLESS
         std::shared_ptr<sf::VertexArray> to_vertex_array() const;
+#endif
 };
 
 
@@ -1,134 +1,198 @@
 #include "Point.h"
+#include <limits>
 
-Point::Point(double x, double y) : x(x), y(y) {}
+namespace {
 
-double Point::get_x() const {return x;}
-double Point::get_y() const {return y;}
+// Whether two coordinates match for is_equal. Shape::EPSILON_ERROR is far below the resolution of a float
+// coordinate away from the origin, so floats are compared to a few ulps of the larger magnitude (at least 1).
+template <typename T>
+bool coordinates_equal(const T a, const T b) {
+    return std::abs(a - b) < static_cast<T>(Shape::EPSILON_ERROR);
+}
+
+template <>
+bool coordinates_equal<float>(const float a, const float b) {
+    const float scale = std::max(1.0f, std::max(std::abs(a), std::abs(b)));
+    return std::abs(a - b) <= 4.0f * std::numeric_limits<float>::epsilon() * scale;
+}
+
+} // namespace
+
+template <typename T>
+BasicPoint<T>::BasicPoint(T x, T y) : x(x), y(y) {}
+
+template <typename T>
+BasicPoint<T>::BasicPoint(const Vec2& v) : x(static_cast<T>(v.x)), y(static_cast<T>(v.y)) {}
+
+template <typename T>
+T BasicPoint<T>::get_x() const {return x;}
+template <typename T>
+T BasicPoint<T>::get_y() const {return y;}
 
-void Point::set_x(double x) {this->x = x;}
-void Point::set_y(double y) {this->y = y;}
+template <typename T>
+void BasicPoint<T>::set_x(T x) {this->x = x;}
+template <typename T>
+void BasicPoint<T>::set_y(T y) {this->y = y;}
 
-double Point::distance_to(const std::shared_ptr<Point> other) const {
-    return sqrt(pow(x - other->get_x(), 2) + pow(y - other->get_y(), 2));
+template <typename T>
+T BasicPoint<T>::distance_to(const std::shared_ptr<BasicPoint> other) const {
+    return this->distance_to(other->to_vec2());
 }
 
-std::shared_ptr<Point> Point::clone() const {
-    return std::make_shared<Point>(x, y);
+template <typename T>
+T BasicPoint<T>::distance_to(const Vec2& other) const {
+    return Vec2(x, y).distance_to(other);
 }
 
-std::shared_ptr<Point> Point::set(const double x, const double y) {
+template <typename T>
+Vec2 BasicPoint<T>::to_vec2() const {
+    return Vec2(x, y);
+}
+
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::clone() const {
+    return make_pooled<BasicPoint>(x, y);
+}
+
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::set(const T x, const T y) {
     this->x = x;
     this->y = y;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::set(const std::shared_ptr<Point> other) {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::set(const std::shared_ptr<BasicPoint> other) {
     this->x = other->get_x();
     this->y = other->get_y();
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::move(const double dx, const double dy) {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::move(const T dx, const T dy) {
     this->x += dx;
     this->y += dy;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::add(const std::shared_ptr<Point> other) {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::add(const std::shared_ptr<BasicPoint> other) {
     this->x += other->get_x();
     this->y += other->get_y();
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::subtract(const std::shared_ptr<Point> other) {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::subtract(const std::shared_ptr<BasicPoint> other) {
     this->x -= other->get_x();
     this->y -= other->get_y();
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::multiply(const double factor){
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::multiply(const T factor){
     this->x *= factor;
     this->y *= factor;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::divide(const double factor) {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::divide(const T factor) {
     this->x /= factor;
     this->y /= factor;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-double Point::dot(const std::shared_ptr<Point> other) const {
+template <typename T>
+T BasicPoint<T>::dot(const std::shared_ptr<BasicPoint> other) const {
     return this->x * other->get_x() + this->y * other->get_y();
 }
 
-double Point::magnitude() const {
+template <typename T>
+T BasicPoint<T>::magnitude() const {
     return sqrt(pow(x, 2) + pow(y, 2));
 }
 
-double Point::angle() const {
+template <typename T>
+T BasicPoint<T>::angle() const {
     return atan2(y, x);
 }
 
-std::shared_ptr<Point> Point::reflect_over_x() const {
-    return std::make_shared<Point>(x, -y);
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::reflect_over_x() const {
+    return make_pooled<BasicPoint>(x, -y);
 }
 
-std::shared_ptr<Point> Point::reflect_over_y() const {
-    return std::make_shared<Point>(-x, y);
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::reflect_over_y() const {
+    return make_pooled<BasicPoint>(-x, y);
 }
 
-std::shared_ptr<Point> Point::reflect_over_origin() const {
-    return std::make_shared<Point>(-x, -y);
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::reflect_over_origin() const {
+    return make_pooled<BasicPoint>(-x, -y);
 }
 
-std::shared_ptr<Point> Point::scale(const double factor) {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::scale(const T factor) {
     this->x *= factor;
     this->y *= factor;
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::normalize() {
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::normalize() {
     this->set(this->divide(this->magnitude()));
-    return shared_from_this();
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::rotate(const std::shared_ptr<Point> center, const double angle) {
-    double translated_x = x - center->get_x();
-    double translated_y = y - center->get_y();
-
-    double new_x = translated_x * cos(angle) - translated_y * sin(angle);
-    double new_y = translated_x * sin(angle) + translated_y * cos(angle);
-
-    this->set(new_x + center->get_x(), new_y + center->get_y());
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::rotate(const std::shared_ptr<BasicPoint> center, const T angle) {
+    return this->rotate(center->to_vec2(), angle);
+}
 
-    return shared_from_this();
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::rotate(const Vec2& center, const T angle) {
+    Vec2 rotated = Vec2(x, y).rotate(center, angle);
+    this->x = rotated.x;
+    this->y = rotated.y;
+    return this->shared_from_this();
 }
 
-std::shared_ptr<Point> Point::rotate_origin(const double angle) {
-    return this->rotate(std::make_shared<Point>(), angle);
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::rotate_origin(const T angle) {
+    return this->rotate(Vec2(), angle);
 }
 
-std::shared_ptr<Point> Point::mid_point_to(const std::shared_ptr<Point> other) const {
-    return std::make_shared<Point>((this->get_x() + other->get_x()) / 2.0, (this->get_y() + other->get_y()) / 2.0);
+template <typename T>
+std::shared_ptr<BasicPoint<T>> BasicPoint<T>::mid_point_to(const std::shared_ptr<BasicPoint> other) const {
+    return make_pooled<BasicPoint>((this->get_x() + other->get_x()) / T(2), (this->get_y() + other->get_y()) / T(2));
 }
 
-std::shared_ptr<sf::Vector2f> Point::to_vector2f() const {
-    return std::make_shared<sf::Vector2f>(static_cast<float>(x), static_cast<float>(y));
+#ifndef PHYSICS_HEADLESS
+template <typename T>
+std::shared_ptr<sf::Vector2f> BasicPoint<T>::to_vector2f() const {
+    return make_pooled<sf::Vector2f>(static_cast<float>(x), static_cast<float>(y));
 }
 
-std::shared_ptr<sf::CircleShape> Point::point_to_circle_shape(const sf::Color& color, const double radius) const {
+template <typename T>
+std::shared_ptr<sf::CircleShape> BasicPoint<T>::point_to_circle_shape(const sf::Color& color, const T radius) const {
     std::shared_ptr<sf::CircleShape> circle = std::make_shared<sf::CircleShape>(radius);
     circle->setPosition(*this->clone()->move(-radius, -radius)->to_vector2f());
     circle->setFillColor(color);
     return circle;
 }
+#endif
 
-std::string Point::to_string() const {
+template <typename T>
+std::string BasicPoint<T>::to_string() const {
     return "(" + std::to_string(x) + ", " + std::to_string(y) + ")";
 }
 
-bool Point::is_equal(const std::shared_ptr<Point> other) const {
-    return abs(x - other->get_x()) < Shape::EPSILON_ERROR && abs(y - other->get_y()) < Shape::EPSILON_ERROR;
+template <typename T>
+bool BasicPoint<T>::is_equal(const std::shared_ptr<BasicPoint> other) const {
+    return coordinates_equal(x, other->get_x()) && coordinates_equal(y, other->get_y());
 }
 
+template class BasicPoint<float>;
+template class BasicPoint<double>;
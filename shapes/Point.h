@@ -2,47 +2,70 @@
 #define POINT_H
 
 #include "Shape.h"
+#include "Vec2.h"
 
-class Point : public Shape, public std::enable_shared_from_this<Point> {
+// A point with coordinates of type T. The members are defined in Point.cpp and instantiated there for float and
+// double only: Point (double) is the type of every other shape, Pointf holds half the bytes for large float scenes.
+template <typename T>
+class BasicPoint : public Shape, public std::enable_shared_from_this<BasicPoint<T>> {
     private:
-        double x; 
-        double y;
+        T x; 
+        T y;
 
     public:
-        Point(double x = 0.0, double y = 0.0);
-        double get_x() const;
-        double get_y() const;
-        void set_x(double x);
-        void set_y(double y);
+        typedef T scalar_type;
 
-        double distance_to(const std::shared_ptr<Point> other) const;
+        BasicPoint(T x = T(0), T y = T(0));
+        explicit BasicPoint(const Vec2& v);
+        // Rounds, or widens, the coordinates of a point of the other precision.
+        template <typename U>
+        explicit BasicPoint(const BasicPoint<U>& other) : x(static_cast<T>(other.get_x())), y(static_cast<T>(other.get_y())) {}
+        T get_x() const;
+        T get_y() const;
+        void set_x(T x);
+        void set_y(T y);
+
+        T distance_to(const std::shared_ptr<BasicPoint> other) const;
+        T distance_to(const Vec2& other) const;
+        Vec2 to_vec2() const;
         
-        std::shared_ptr<Point> clone() const;
-        std::shared_ptr<Point> set(const double x, const double y);
-        std::shared_ptr<Point> set(const std::shared_ptr<Point> other);
-        std::shared_ptr<Point> move(const double dx, const double dy);
-        std::shared_ptr<Point> add(const std::shared_ptr<Point> other);
-        std::shared_ptr<Point> subtract(const std::shared_ptr<Point> other);
-        std::shared_ptr<Point> multiply(const double factor);
-        std::shared_ptr<Point> divide(const double factor);
-        double dot(const std::shared_ptr<Point> other) const;
-        double magnitude() const;
-        double angle() const;
-        std::shared_ptr<Point> reflect_over_x() const;
-        std::shared_ptr<Point> reflect_over_y() const;
-        std::shared_ptr<Point> reflect_over_origin() const;
-        std::shared_ptr<Point> scale(const double factor);
-        std::shared_ptr<Point> normalize();
-        std::shared_ptr<Point> rotate(const std::shared_ptr<Point> center, const double angle);
-        std::shared_ptr<Point> rotate_origin(const double angle);
-        std::shared_ptr<Point> mid_point_to(const std::shared_ptr<Point> other) const;
+        std::shared_ptr<BasicPoint> clone() const;
+        std::shared_ptr<BasicPoint> set(const T x, const T y);
+        std::shared_ptr<BasicPoint> set(const std::shared_ptr<BasicPoint> other);
+        std::shared_ptr<BasicPoint> move(const T dx, const T dy);
+        std::shared_ptr<BasicPoint> add(const std::shared_ptr<BasicPoint> other);
+        std::shared_ptr<BasicPoint> subtract(const std::shared_ptr<BasicPoint> other);
+        std::shared_ptr<BasicPoint> multiply(const T factor);
+        std::shared_ptr<BasicPoint> divide(const T factor);
+        T dot(const std::shared_ptr<BasicPoint> other) const;
+        T magnitude() const;
+        T angle() const;
+        std::shared_ptr<BasicPoint> reflect_over_x() const;
+        std::shared_ptr<BasicPoint> reflect_over_y() const;
+        std::shared_ptr<BasicPoint> reflect_over_origin() const;
+        std::shared_ptr<BasicPoint> scale(const T factor);
+        std::shared_ptr<BasicPoint> normalize();
+        std::shared_ptr<BasicPoint> rotate(const std::shared_ptr<BasicPoint> center, const T angle);
+        std::shared_ptr<BasicPoint> rotate(const Vec2& center, const T angle);
+        std::shared_ptr<BasicPoint> rotate_origin(const T angle);
+        std::shared_ptr<BasicPoint> mid_point_to(const std::shared_ptr<BasicPoint> other) const;
+#ifndef PHYSICS_HEADLESS
         std::shared_ptr<sf::Vector2f> to_vector2f() const;
-        std::shared_ptr<sf::CircleShape> point_to_circle_shape(const sf::Color& color, const double radius = 5.0f) const;
+        std::shared_ptr<sf::CircleShape> point_to_circle_shape(const sf::Color& color, const T radius = 5.0f) const;
+#endif
         
         std::string to_string() const;
-        bool is_equal(const std::shared_ptr<Point> other) const;
+        // Equal up to Shape::EPSILON_ERROR for double, and for float to a few ulps of the larger coordinate
+        // (at least 1).
+        bool is_equal(const std::shared_ptr<BasicPoint> other) const;
 };
 
+extern template class BasicPoint<float>;
+extern template class BasicPoint<double>;
+
+typedef BasicPoint<double> Point;
+typedef BasicPoint<float> Pointf;
+
 
 
-#endif // POINT_H
\ No newline at end of file
+#endif // POINT_H
@@ -0,0 +1,230 @@
+#include "PoolAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+constexpr std::size_t SmallObjectPool::GRANULE;
+constexpr std::size_t SmallObjectPool::MAX_BLOCK;
+constexpr std::size_t SmallObjectPool::CHUNK_SIZE;
+constexpr std::size_t SmallObjectPool::MAX_TYPES;
+
+namespace {
+
+constexpr std::size_t CLASSES = SmallObjectPool::MAX_BLOCK / SmallObjectPool::GRANULE;
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Only the owning thread writes its counters; atomics with relaxed loads and stores keep the reads of stats()
+// well defined without a locked add on every allocation.
+struct ThreadCache {
+    FreeBlock* free[CLASSES] = {};
+    std::size_t free_count[CLASSES] = {};
+    std::atomic<std::uint64_t> allocations[SmallObjectPool::MAX_TYPES];
+    std::atomic<std::uint64_t> deallocations[SmallObjectPool::MAX_TYPES];
+
+    ThreadCache() {
+        for (std::size_t type = 0; type < SmallObjectPool::MAX_TYPES; ++type) {
+            allocations[type].store(0, std::memory_order_relaxed);
+            deallocations[type].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCache*> caches;                   // of the running threads
+    FreeBlock* depot[CLASSES] = {};
+    std::size_t depot_count[CLASSES] = {};
+    std::uint64_t retired_allocations[SmallObjectPool::MAX_TYPES] = {};
+    std::uint64_t retired_deallocations[SmallObjectPool::MAX_TYPES] = {};
+    std::atomic<std::size_t> types{0};
+};
+
+// Never destroyed: shared_ptrs in static storage may release their blocks after every destructor has run.
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+thread_local ThreadCache* current = nullptr;
+thread_local bool exited = false;
+
+// Registers the thread's cache on its first pooled allocation and hands its blocks and counts to the registry
+// when the thread exits.
+struct CacheOwner {
+    ThreadCache cache;
+
+    CacheOwner() {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        shared.caches.push_back(&cache);
+    }
+
+    ~CacheOwner() {
+        current = nullptr;
+        exited = true;
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (std::size_t c = 0; c < CLASSES; ++c) {
+            while (cache.free[c] != nullptr) {
+                FreeBlock* block = cache.free[c];
+                cache.free[c] = block->next;
+                block->next = shared.depot[c];
+                shared.depot[c] = block;
+                ++shared.depot_count[c];
+            }
+        }
+        for (std::size_t type = 0; type < SmallObjectPool::MAX_TYPES; ++type) {
+            shared.retired_allocations[type] += cache.allocations[type].load(std::memory_order_relaxed);
+            shared.retired_deallocations[type] += cache.deallocations[type].load(std::memory_order_relaxed);
+        }
+        shared.caches.erase(std::find(shared.caches.begin(), shared.caches.end(), &cache));
+    }
+};
+
+// Null once the thread's cache has been destroyed, during thread exit.
+ThreadCache* thread_cache() {
+    if (current == nullptr && !exited) {
+        thread_local CacheOwner owner;
+        current = &owner.cache;
+    }
+    return current;
+}
+
+void increment(std::atomic<std::uint64_t>& counter) {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+std::size_t blocks_per_chunk(const std::size_t c) {
+    return SmallObjectPool::CHUNK_SIZE / ((c + 1) * SmallObjectPool::GRANULE);
+}
+
+// The depot's blocks of class c if it has any, otherwise a new chunk cut into blocks of class c. Sets count to
+// the number of blocks in the returned list.
+FreeBlock* refill(const std::size_t c, std::size_t& count) {
+    Registry& shared = registry();
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        if (shared.depot[c] != nullptr) {
+            FreeBlock* blocks = shared.depot[c];
+            count = shared.depot_count[c];
+            shared.depot[c] = nullptr;
+            shared.depot_count[c] = 0;
+            return blocks;
+        }
+    }
+    const std::size_t block_size = (c + 1) * SmallObjectPool::GRANULE;
+    count = blocks_per_chunk(c);
+    char* chunk = static_cast<char*>(::operator new(SmallObjectPool::CHUNK_SIZE));
+    for (std::size_t k = 0; k + 1 < count; ++k) {
+        reinterpret_cast<FreeBlock*>(chunk + k * block_size)->next = reinterpret_cast<FreeBlock*>(chunk + (k + 1) * block_size);
+    }
+    reinterpret_cast<FreeBlock*>(chunk + (count - 1) * block_size)->next = nullptr;
+    return reinterpret_cast<FreeBlock*>(chunk);
+}
+
+// A thread that frees more than it allocates, such as the consumer of objects made on another thread, hands a
+// chunk's worth of blocks back to the depot once it holds two.
+void release(ThreadCache& cache, const std::size_t c) {
+    const std::size_t count = blocks_per_chunk(c);
+    FreeBlock* first = cache.free[c];
+    FreeBlock* last = first;
+    for (std::size_t k = 1; k < count; ++k) last = last->next;
+    cache.free[c] = last->next;
+    cache.free_count[c] -= count;
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    last->next = shared.depot[c];
+    shared.depot[c] = first;
+    shared.depot_count[c] += count;
+}
+
+bool pooled(const std::size_t bytes, const std::size_t alignment) {
+    return bytes > 0 && bytes <= SmallObjectPool::MAX_BLOCK && alignment <= SmallObjectPool::GRANULE;
+}
+
+} // namespace
+
+
+void* SmallObjectPool::allocate(const std::size_t bytes, const std::size_t alignment, const std::size_t type) {
+    if (!pooled(bytes, alignment)) return ::operator new(bytes);
+    const std::size_t c = (bytes - 1) / GRANULE;
+    ThreadCache* cache = thread_cache();
+    if (cache == nullptr) {
+        // A thread past its cache's destruction keeps one block and gives the rest back to the depot.
+        std::size_t count = 0;
+        FreeBlock* blocks = refill(c, count);
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        ++shared.retired_allocations[type];
+        for (FreeBlock* rest = blocks->next; rest != nullptr;) {
+            FreeBlock* next = rest->next;
+            rest->next = shared.depot[c];
+            shared.depot[c] = rest;
+            ++shared.depot_count[c];
+            rest = next;
+        }
+        return blocks;
+    }
+    if (cache->free[c] == nullptr) cache->free[c] = refill(c, cache->free_count[c]);
+    FreeBlock* block = cache->free[c];
+    cache->free[c] = block->next;
+    --cache->free_count[c];
+    increment(cache->allocations[type]);
+    return block;
+}
+
+void SmallObjectPool::deallocate(void* block, const std::size_t bytes, const std::size_t alignment, const std::size_t type) {
+    if (!pooled(bytes, alignment)) {
+        ::operator delete(block);
+        return;
+    }
+    const std::size_t c = (bytes - 1) / GRANULE;
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    ThreadCache* cache = thread_cache();
+    if (cache == nullptr) {
+        Registry& shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        ++shared.retired_deallocations[type];
+        freed->next = shared.depot[c];
+        shared.depot[c] = freed;
+        ++shared.depot_count[c];
+        return;
+    }
+    freed->next = cache->free[c];
+    cache->free[c] = freed;
+    increment(cache->deallocations[type]);
+    if (++cache->free_count[c] > 2 * blocks_per_chunk(c)) release(*cache, c);
+}
+
+std::size_t SmallObjectPool::register_type() {
+    return std::min(registry().types.fetch_add(1), MAX_TYPES - 1);
+}
+
+PoolStats SmallObjectPool::stats(const std::size_t type) {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    PoolStats stats;
+    stats.allocations = shared.retired_allocations[type];
+    stats.deallocations = shared.retired_deallocations[type];
+    for (const ThreadCache* cache : shared.caches) {
+        stats.allocations += cache->allocations[type].load(std::memory_order_relaxed);
+        stats.deallocations += cache->deallocations[type].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+PoolStats SmallObjectPool::total_stats() {
+    const std::size_t types = std::min(registry().types.load(), MAX_TYPES);
+    PoolStats total;
+    for (std::size_t type = 0; type < types; ++type) {
+        const PoolStats type_stats = stats(type);
+        total.allocations += type_stats.allocations;
+        total.deallocations += type_stats.deallocations;
+    }
+    return total;
+}
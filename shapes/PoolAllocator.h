@@ -0,0 +1,90 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Counters of the pooled allocations of one type, summed over all threads.
+struct PoolStats {
+    std::uint64_t allocations = 0;
+    std::uint64_t deallocations = 0;
+};
+
+// Small-block pool behind make_pooled. Blocks come in size classes GRANULE bytes apart and are carved from chunks
+// that are never given back to the system. Every thread keeps its own free list per class, so allocating and
+// freeing take no lock and share no cache line with other threads; a block freed on another thread than the one
+// that allocated it joins the freeing thread's list. A thread holding more than two chunks' worth of free blocks of a
+// class, and every thread on exit, gives blocks back to a shared depot that the threads refill from before carving
+// new chunks.
+class SmallObjectPool {
+    public:
+        static constexpr std::size_t GRANULE = 16;
+        // Larger blocks, and types aligned to more than GRANULE, go to operator new.
+        static constexpr std::size_t MAX_BLOCK = 256;
+        static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+        // Types past this many share the counters of the last one.
+        static constexpr std::size_t MAX_TYPES = 64;
+
+        static void* allocate(const std::size_t bytes, const std::size_t alignment, const std::size_t type);
+        static void deallocate(void* block, const std::size_t bytes, const std::size_t alignment, const std::size_t type);
+        // A new id for the counters of a type.
+        static std::size_t register_type();
+        static PoolStats stats(const std::size_t type);
+        // Summed over every type.
+        static PoolStats total_stats();
+};
+
+template <typename T>
+std::size_t pool_type_id() {
+    static const std::size_t id = SmallObjectPool::register_type();
+    return id;
+}
+
+// Allocator for std::allocate_shared that counts under Tag whatever it is rebound to, so the object and its
+// control block share one pooled block counted for the object's type.
+template <typename T, typename Tag = T>
+class PoolAllocator {
+    public:
+        typedef T value_type;
+        template <typename U>
+        struct rebind {
+            typedef PoolAllocator<U, Tag> other;
+        };
+
+        PoolAllocator() = default;
+        template <typename U>
+        PoolAllocator(const PoolAllocator<U, Tag>&) {}
+
+        T* allocate(const std::size_t n) {
+            return static_cast<T*>(SmallObjectPool::allocate(n * sizeof(T), alignof(T), pool_type_id<Tag>()));
+        }
+        void deallocate(T* block, const std::size_t n) {
+            SmallObjectPool::deallocate(block, n * sizeof(T), alignof(T), pool_type_id<Tag>());
+        }
+};
+
+template <typename T, typename U, typename Tag>
+bool operator==(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) {
+    return true;
+}
+
+template <typename T, typename U, typename Tag>
+bool operator!=(const PoolAllocator<T, Tag>&, const PoolAllocator<U, Tag>&) {
+    return false;
+}
+
+// std::make_shared from the calling thread's pool.
+template <typename T, typename... Args>
+std::shared_ptr<T> make_pooled(Args&&... args) {
+    return std::allocate_shared<T>(PoolAllocator<T>(), std::forward<Args>(args)...);
+}
+
+template <typename T>
+PoolStats pool_stats() {
+    return SmallObjectPool::stats(pool_type_id<T>());
+}
+
+
+#endif // POOL_ALLOCATOR_H
@@ -2,8 +2,8 @@
 
 
 Rectangle::Rectangle(std::shared_ptr<Point> upper_left, std::shared_ptr<Point> lower_right) : upper_left(upper_left), lower_right(lower_right) {
-    this->lower_left = std::make_shared<Point>(upper_left->get_x(), lower_right->get_y());
-    this->upper_right = std::make_shared<Point>(lower_right->get_x(),upper_left->get_y());
+    this->lower_left = make_pooled<Point>(upper_left->get_x(), lower_right->get_y());
+    this->upper_right = make_pooled<Point>(lower_right->get_x(),upper_left->get_y());
 }
 
 Rectangle::Rectangle(std::shared_ptr<Point> upper_left, std::shared_ptr<Point> upper_right, std::shared_ptr<Point> lower_right, std::shared_ptr<Point> lower_left) : upper_left(upper_left), upper_right(upper_right), lower_right(lower_right), lower_left(lower_left) {}
@@ -33,30 +33,36 @@ std::shared_ptr<Point> Rectangle::get_lower_left() const {
 }
 
 double Rectangle::area() const {
-    return upper_left->distance_to(upper_right) * upper_left->distance_to(lower_left);
+    update_cache();
+    return cached_area;
 }
 
 double Rectangle::perimeter() const {
-    return 2.0 * (upper_left->distance_to(upper_right) + upper_left->distance_to(lower_left));
+    update_cache();
+    return cached_perimeter;
 }
 
 std::shared_ptr<Rectangle> Rectangle::clone() const {
-    return std::make_shared<Rectangle>(upper_left, lower_right);
+    return make_pooled<Rectangle>(upper_left, lower_right);
 }
 
 std::shared_ptr<Rectangle> Rectangle::move(const std::shared_ptr<Point> offset) {
+    const bool current = cache_current();
     this->upper_left->add(offset);
     this->lower_right->add(offset);
     this->upper_right->add(offset);
     this->lower_left->add(offset);
+    carry_cache(current, 1.0);
     return shared_from_this();
 }
 
 std::shared_ptr<Rectangle> Rectangle::scale(const double factor) {
+    const bool current = cache_current();
     this->upper_left->scale(factor);
     this->lower_right->scale(factor);
     this->upper_right->scale(factor);
     this->lower_left->scale(factor);
+    carry_cache(current, std::abs(factor));
     return shared_from_this();
 }
 
@@ -66,22 +72,22 @@ std::shared_ptr<Rectangle> Rectangle::extend(const double factor) {
                  lower_left->get_x() + lower_right->get_x()) / 4.0;
     double cy = (upper_left->get_y() + upper_right->get_y() +
                  lower_left->get_y() + lower_right->get_y()) / 4.0;
-    auto centroid = std::make_shared<Point>(cx, cy);
+    auto centroid = make_pooled<Point>(cx, cy);
 
     // Compute new positions for each vertex.
-    auto new_upper_left = std::make_shared<Point>(
+    auto new_upper_left = make_pooled<Point>(
         cx + factor * (upper_left->get_x() - cx),
         cy + factor * (upper_left->get_y() - cy)
     );
-    auto new_upper_right = std::make_shared<Point>(
+    auto new_upper_right = make_pooled<Point>(
         cx + factor * (upper_right->get_x() - cx),
         cy + factor * (upper_right->get_y() - cy)
     );
-    auto new_lower_left = std::make_shared<Point>(
+    auto new_lower_left = make_pooled<Point>(
         cx + factor * (lower_left->get_x() - cx),
         cy + factor * (lower_left->get_y() - cy)
     );
-    auto new_lower_right = std::make_shared<Point>(
+    auto new_lower_right = make_pooled<Point>(
         cx + factor * (lower_right->get_x() - cx),
         cy + factor * (lower_right->get_y() - cy)
     );
@@ -103,17 +109,26 @@ std::shared_ptr<Rectangle> Rectangle::extend(const double factor) {
 }
 
 std::shared_ptr<Rectangle> Rectangle::rotate(const std::shared_ptr<Point> center, const double angle) {
+    return this->rotate(center->to_vec2(), angle);
+}
+
+std::shared_ptr<Rectangle> Rectangle::rotate(const Vec2& center, const double angle) {
+    const bool current = cache_current();
     this->upper_left->rotate(center, angle);
+    this->upper_right->rotate(center, angle);
+    this->lower_right->rotate(center, angle);
+    this->lower_left->rotate(center, angle);
+    carry_cache(current, 1.0);
     return shared_from_this();
 }
 
 std::shared_ptr<Rectangle> Rectangle::rotate_origin(const double angle) {
-    this->rotate(std::make_shared<Point>(), angle);
+    this->rotate(Vec2(), angle);
     return shared_from_this();
 }
 
 std::shared_ptr<Rectangle> Rectangle::rotate_center(const double angle) {
-    this->rotate(this->centroid(), angle);
+    this->rotate(centroid_vec2(), angle);
     return shared_from_this();
 }
 
@@ -157,19 +172,25 @@ bool Rectangle::is_equal(const std::shared_ptr<Rectangle> other) const {
 
 
 bool Rectangle::contains(const std::shared_ptr<Point> point) const {
+    return this->contains(point->to_vec2());
+}
+
+bool Rectangle::contains(const Vec2& point) const {
     // Helper lambda to compute the signed cross product (isLeft test)
-    auto cross = [](const std::shared_ptr<Point>& a,
-                    const std::shared_ptr<Point>& b,
-                    const std::shared_ptr<Point>& c) -> double {
-        return (b->get_x() - a->get_x()) * (c->get_y() - a->get_y()) -
-               (b->get_y() - a->get_y()) * (c->get_x() - a->get_x());
+    auto cross = [](const Vec2& a, const Vec2& b, const Vec2& c) -> double {
+        return (b - a).cross(c - a);
     };
 
+    const Vec2 ul = upper_left->to_vec2();
+    const Vec2 ur = upper_right->to_vec2();
+    const Vec2 lr = lower_right->to_vec2();
+    const Vec2 ll = lower_left->to_vec2();
+
     // Using the four vertices in order
-    double d1 = cross(upper_left, upper_right, point);
-    double d2 = cross(upper_right, lower_right, point);
-    double d3 = cross(lower_right, lower_left, point);
-    double d4 = cross(lower_left, upper_left, point);
+    double d1 = cross(ul, ur, point);
+    double d2 = cross(ur, lr, point);
+    double d3 = cross(lr, ll, point);
+    double d4 = cross(ll, ul, point);
 
     // If the signs of all cross products are either non-negative or non-positive,
     // the point is inside or on the edge.
@@ -180,14 +201,18 @@ bool Rectangle::contains(const std::shared_ptr<Point> point) const {
 }
 
 bool Rectangle::between_bounds(const std::shared_ptr<Point> point) const {
+    return this->between_bounds(point->to_vec2());
+}
+
+bool Rectangle::between_bounds(const Vec2& point) const {
     // Determine the axis-aligned bounding box of the rectangle
     double min_x = std::min({upper_left->get_x(), upper_right->get_x(), lower_left->get_x(), lower_right->get_x()});
     double max_x = std::max({upper_left->get_x(), upper_right->get_x(), lower_left->get_x(), lower_right->get_x()});
     double min_y = std::min({upper_left->get_y(), upper_right->get_y(), lower_left->get_y(), lower_right->get_y()});
     double max_y = std::max({upper_left->get_y(), upper_right->get_y(), lower_left->get_y(), lower_right->get_y()});
 
-    return (point->get_x() >= min_x && point->get_x() <= max_x &&
-            point->get_y() >= min_y && point->get_y() <= max_y);
+    return (point.x >= min_x && point.x <= max_x &&
+            point.y >= min_y && point.y <= max_y);
 }
 
 std::string Rectangle::to_string() const {
@@ -195,9 +220,48 @@ std::string Rectangle::to_string() const {
 }
 
 std::shared_ptr<Point> Rectangle::centroid() const {
-    return this->upper_left->mid_point_to(this->lower_right);
+    return make_pooled<Point>(centroid_vec2());
+}
+
+Vec2 Rectangle::centroid_vec2() const {
+    update_cache();
+    return cached_centroid;
+}
+
+bool Rectangle::cache_current() const {
+    return cached && upper_left->to_vec2() == cached_corners[0] && upper_right->to_vec2() == cached_corners[1] &&
+           lower_right->to_vec2() == cached_corners[2] && lower_left->to_vec2() == cached_corners[3];
+}
+
+void Rectangle::update_cache() const {
+    if (cache_current()) return;
+    cached_corners[0] = upper_left->to_vec2();
+    cached_corners[1] = upper_right->to_vec2();
+    cached_corners[2] = lower_right->to_vec2();
+    cached_corners[3] = lower_left->to_vec2();
+    cached = true;
+    const double width = cached_corners[0].distance_to(cached_corners[1]);
+    const double height = cached_corners[0].distance_to(cached_corners[3]);
+    cached_area = width * height;
+    cached_perimeter = 2.0 * (width + height);
+    cached_centroid = cached_corners[0].mid_point_to(cached_corners[2]);
+}
+
+void Rectangle::carry_cache(const bool current, const double factor) const {
+    if (!current) {
+        cached = false;
+        return;
+    }
+    cached_corners[0] = upper_left->to_vec2();
+    cached_corners[1] = upper_right->to_vec2();
+    cached_corners[2] = lower_right->to_vec2();
+    cached_corners[3] = lower_left->to_vec2();
+    cached_area *= factor * factor;
+    cached_perimeter *= factor;
+    cached_centroid = cached_corners[0].mid_point_to(cached_corners[2]);
 }
 
+#ifndef PHYSICS_HEADLESS
 std::shared_ptr<sf::ConvexShape> Rectangle::to_convex_shape(const sf::Color& color_fill, const sf::Color& color_outline, const double outline_thickness) const {
     std::shared_ptr<sf::ConvexShape> rectangle = std::make_shared<sf::ConvexShape>(4);
     rectangle->setPoint(0, *this->get_upper_left()->to_vector2f());
@@ -209,6 +273,7 @@ std::shared_ptr<sf::ConvexShape> Rectangle::to_convex_shape(const sf::Color& col
     rectangle->setOutlineThickness(outline_thickness);
     return rectangle;
 }
+#endif
 
 
 double Rectangle::get_left_boundry() const {
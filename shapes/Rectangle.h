@@ -10,6 +10,20 @@ class Rectangle : public Shape, public std::enable_shared_from_this<Rectangle> {
         std::shared_ptr<Point> lower_right;
         std::shared_ptr<Point> upper_right;
         std::shared_ptr<Point> lower_left;
+        // Derived values, computed on first use from the corner coordinates in cached_corners (upper left, upper
+        // right, lower right, lower left). They are stale once a corner has moved, by this rectangle or through a
+        // Point shared with another shape.
+        mutable bool cached = false;
+        mutable Vec2 cached_corners[4];
+        mutable double cached_area;
+        mutable double cached_perimeter;
+        mutable Vec2 cached_centroid;
+
+        bool cache_current() const;
+        void update_cache() const;
+        // After a rotation, translation or scaling of all corners that scales lengths by factor: keeps the area and
+        // perimeter if the cache was current before it, and recomputes only the centroid.
+        void carry_cache(const bool current, const double factor) const;
 
     public:
         Rectangle(std::shared_ptr<Point> upper_left, std::shared_ptr<Point> lower_right);
@@ -26,14 +40,20 @@ class Rectangle : public Shape, public std::enable_shared_from_this<Rectangle> {
         std::shared_ptr<Rectangle> scale(const double factor);
         std::shared_ptr<Rectangle> extend(const double factor);
         std::shared_ptr<Rectangle> rotate(const std::shared_ptr<Point> center, const double angle);
+        std::shared_ptr<Rectangle> rotate(const Vec2& center, const double angle);
         std::shared_ptr<Rectangle> rotate_origin(const double angle);
         std::shared_ptr<Rectangle> rotate_center(const double angle);
         bool is_equal(const std::shared_ptr<Rectangle> other) const;
         bool contains(const std::shared_ptr<Point> point) const;
+        bool contains(const Vec2& point) const;
         bool between_bounds(const std::shared_ptr<Point> point) const;
+        bool between_bounds(const Vec2& point) const;
         std::string to_string() const;
         std::shared_ptr<Point> centroid() const;
+        Vec2 centroid_vec2() const;
+#ifndef PHYSICS_HEADLESS
         std::shared_ptr<sf::ConvexShape> to_convex_shape(const sf::Color& color_fill, const sf::Color& color_outline, const double outline_thickness) const;
+#endif
         double get_left_boundry() const;
         double get_right_boundry() const;
         double get_top_boundry() const;
@@ -0,0 +1,151 @@
+#include "SegmentIntersection.h"
+#include <limits>
+
+namespace {
+
+// Sign of the turn a -> b -> c: positive counter-clockwise, negative clockwise, zero collinear.
+int orientation(const Vec2& a, const Vec2& b, const Vec2& c) {
+    const double turn = (b - a).cross(c - a);
+    return (turn > 0.0) - (turn < 0.0);
+}
+
+// For c collinear with a -> b: whether it lies within the bounding box of the segment.
+bool within(const Vec2& a, const Vec2& b, const Vec2& c) {
+    return c.x >= std::min(a.x, b.x) && c.x <= std::max(a.x, b.x) && c.y >= std::min(a.y, b.y) && c.y <= std::max(a.y, b.y);
+}
+
+struct SweepEntry {
+    double min_x;
+    double max_x;
+    double min_y;
+    double max_y;
+    std::uint32_t index;
+    std::uint32_t band;
+};
+
+} // namespace
+
+
+bool segments_intersect(const Segment& first, const Segment& second, Vec2& point) {
+    const Vec2& p = first.start;
+    const Vec2& q = second.start;
+    const int o1 = orientation(p, first.end, q);
+    const int o2 = orientation(p, first.end, second.end);
+    const int o3 = orientation(q, second.end, p);
+    const int o4 = orientation(q, second.end, first.end);
+    const Vec2 r = first.end - p;
+    const Vec2 s = second.end - q;
+
+    if (o1 != o2 && o3 != o4) {
+        // A proper crossing, or an endpoint on the other segment. Neither segment is a point here.
+        const double denominator = r.cross(s);
+        if (denominator != 0.0) {
+            point = p + r * ((q - p).cross(s) / denominator);
+        } else {
+            point = o1 == 0 ? q : second.end;
+        }
+        return true;
+    }
+    if (o1 != 0 || o2 != 0 || o3 != 0 || o4 != 0) return false;
+
+    // Collinear, or one of the segments is a point: they meet if an endpoint of one lies on the other. The
+    // overlap starts at the first such point along the first segment.
+    bool found = false;
+    double first_t = 0.0;
+    const double length_squared = r.length_squared();
+    auto consider = [&](const Vec2& candidate) {
+        const double t = length_squared > 0.0 ? (candidate - p).dot(r) / length_squared : 0.0;
+        if (!found || t < first_t) {
+            first_t = t;
+            point = candidate;
+            found = true;
+        }
+    };
+    if (within(q, second.end, p)) consider(p);
+    if (within(q, second.end, first.end)) consider(first.end);
+    if (within(p, first.end, q)) consider(q);
+    if (within(p, first.end, second.end)) consider(second.end);
+    return found;
+}
+
+std::vector<SegmentIntersection> find_intersections(const Segment* segments, const std::size_t count) {
+    std::vector<SegmentIntersection> found;
+    if (count == 0) return found;
+    std::vector<SweepEntry> boxes(count);
+    double low = std::numeric_limits<double>::max();
+    double high = std::numeric_limits<double>::lowest();
+    double total_height = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const Segment& segment = segments[i];
+        boxes[i] = {std::min(segment.start.x, segment.end.x), std::max(segment.start.x, segment.end.x),
+                    std::min(segment.start.y, segment.end.y), std::max(segment.start.y, segment.end.y),
+                    static_cast<std::uint32_t>(i), 0};
+        low = std::min(low, boxes[i].min_y);
+        high = std::max(high, boxes[i].max_y);
+        total_height += boxes[i].max_y - boxes[i].min_y;
+    }
+
+    // One sweep along x keeps every segment the sweep line crosses, and over a wide layout that is most of a
+    // column. The layout is cut into horizontal bands a few segments high, each swept on its own with the segments
+    // that reach into it; a pair is reported only in the band its y-overlap starts in.
+    const double band_height = std::max(4.0 * total_height / count, (high - low) / count);
+    std::size_t bands = 1;
+    if (band_height > 0.0) bands = std::min(count, static_cast<std::size_t>((high - low) / band_height) + 1);
+    auto band_of = [&](const double y) -> std::size_t {
+        if (bands == 1) return 0;
+        return std::min(bands - 1, static_cast<std::size_t>((y - low) / (high - low) * bands));
+    };
+    std::vector<SweepEntry> entries;
+    entries.reserve(count);
+    for (const SweepEntry& box : boxes) {
+        const std::size_t last = band_of(box.max_y);
+        for (std::size_t band = band_of(box.min_y); band <= last; ++band) {
+            entries.push_back(box);
+            entries.back().band = static_cast<std::uint32_t>(band);
+        }
+    }
+    // Within a band the sweep line stops at every left end; a vertical segment starts and ends at the same stop.
+    std::sort(entries.begin(), entries.end(), [](const SweepEntry& p, const SweepEntry& q) {
+        return p.band < q.band || (p.band == q.band && (p.min_x < q.min_x || (p.min_x == q.min_x && p.index < q.index)));
+    });
+
+    std::vector<SweepEntry> active;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const SweepEntry& entry = entries[i];
+        if (i > 0 && entries[i - 1].band != entry.band) active.clear();
+        // Segments that ended left of the sweep line leave the active set as it is scanned.
+        std::size_t kept = 0;
+        for (std::size_t k = 0; k < active.size(); ++k) {
+            const SweepEntry& other = active[k];
+            if (other.max_x < entry.min_x) continue;
+            active[kept++] = other;
+            if (other.max_y < entry.min_y || other.min_y > entry.max_y) continue;
+            if (band_of(std::max(other.min_y, entry.min_y)) != entry.band) continue;
+            const std::uint32_t a = std::min(other.index, entry.index);
+            const std::uint32_t b = std::max(other.index, entry.index);
+            Vec2 point;
+            // The point is reported along the lower index.
+            if (segments_intersect(segments[a], segments[b], point)) found.push_back({a, b, point});
+        }
+        active.resize(kept);
+        active.push_back(entry);
+    }
+
+    std::sort(found.begin(), found.end(), [](const SegmentIntersection& p, const SegmentIntersection& q) {
+        return p.a < q.a || (p.a == q.a && p.b < q.b);
+    });
+    return found;
+}
+
+std::vector<SegmentIntersection> find_intersections(const std::vector<Segment>& segments) {
+    return find_intersections(segments.data(), segments.size());
+}
+
+std::vector<SegmentIntersection> find_intersections(const std::vector<std::shared_ptr<Line>>& lines) {
+    std::vector<Segment> segments;
+    segments.reserve(lines.size());
+    for (const std::shared_ptr<Line>& line : lines) {
+        segments.push_back({line->get_start()->to_vec2(), line->get_end()->to_vec2()});
+    }
+    return find_intersections(segments);
+}
@@ -0,0 +1,35 @@
+#ifndef SEGMENT_INTERSECTION_H
+#define SEGMENT_INTERSECTION_H
+
+#include <cstdint>
+#include "Line.h"
+
+// A line segment held by value, for the batch queries over many segments.
+struct Segment {
+    Vec2 start;
+    Vec2 end;
+};
+
+// Two segments that share at least one point. a < b index the input; point is the crossing, or for collinear
+// segments that overlap the first point of the overlap along segment a.
+struct SegmentIntersection {
+    std::uint32_t a;
+    std::uint32_t b;
+    Vec2 point;
+};
+
+// Whether two segments share a point, touching endpoints included. Vertical and zero-length segments work too:
+// the test uses orientations instead of slopes.
+bool segments_intersect(const Segment& first, const Segment& second, Vec2& point);
+
+// Every intersecting pair among count segments, sorted by a then b. A sweep line moves along x over the left ends
+// of the segments and keeps the ones it currently crosses; a new segment is only tested against those whose y-range
+// overlaps its own. The sweep runs per horizontal band, so layouts of many short segments cost about O(n log n + k)
+// instead of the n^2 / 2 pairs.
+std::vector<SegmentIntersection> find_intersections(const Segment* segments, const std::size_t count);
+std::vector<SegmentIntersection> find_intersections(const std::vector<Segment>& segments);
+// Same for Line objects, indexed by their position in lines.
+std::vector<SegmentIntersection> find_intersections(const std::vector<std::shared_ptr<Line>>& lines);
+
+
+#endif // SEGMENT_INTERSECTION_H
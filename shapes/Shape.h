@@ -6,7 +6,16 @@
 #include <memory>
 #include <cmath>
 #include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+// The shapes create their results through make_pooled, from a per-thread pool instead of the global allocator.
+#include "PoolAllocator.h"
+// Headless builds (PHYSICS_HEADLESS) leave out every SFML conversion, so the core links without SFML.
+#ifndef PHYSICS_HEADLESS
 #include <SFML/Graphics.hpp>
+#endif
 
 
 
@@ -16,18 +25,24 @@ class Shape {
         static constexpr double EPSILON_ERROR = 1e-10;
 
         std::vector<double> static solve_quadratic(double a, double b, double c){
-            std::vector<double> roots{};
+            double found[2];
+            int count = solve_quadratic(a, b, c, found);
+            return std::vector<double>(found, found + count);
+        }
+
+        // Same roots in the same order, written to roots instead of a new vector; returns how many there are.
+        // For the hot loops that solve one quadratic per pair.
+        int static solve_quadratic(double a, double b, double c, double roots[2]){
             double discriminant = b * b - 4 * a * c;
             if (discriminant > 0) {
-                double root1 = (-b + sqrt(discriminant)) / (2.0 * a);
-                double root2 = (-b - sqrt(discriminant)) / (2.0 * a);
-                roots.push_back(root1);
-                roots.push_back(root2);
+                roots[0] = (-b + sqrt(discriminant)) / (2.0 * a);
+                roots[1] = (-b - sqrt(discriminant)) / (2.0 * a);
+                return 2;
             } else if (discriminant == 0) {
-                double root = -b / (2 * a);
-                roots.push_back(root);  
+                roots[0] = -b / (2 * a);
+                return 1;
             }
-            return roots;
+            return 0;
         }
 
 };
@@ -16,43 +16,60 @@ std::shared_ptr<Point> Triangle::get_p3() const {
 
 void Triangle::set_p1(std::shared_ptr<Point> p1) {
     this->p1 = p1;
+    this->cached = false;
 }
 void Triangle::set_p2(std::shared_ptr<Point> p2) {
     this->p2 = p2;
+    this->cached = false;
 }
 
 void Triangle::set_p3(std::shared_ptr<Point> p3) {
     this->p3 = p3;
+    this->cached = false;
 }
 
 double Triangle::calculate_perimeter() const {
-    return p1->distance_to(p2) + p2->distance_to(p3) + p3->distance_to(p1);
+    update_cache();
+    return cached_perimeter;
 }
 
 double Triangle::calculate_area() const {
-    return this->calculate_area(p1, p2, p3);
+    update_cache();
+    return cached_area;
 }
 
 double Triangle::calculate_area(const std::shared_ptr<Point> a_, const std::shared_ptr<Point> b_, const std::shared_ptr<Point> c_) const {
-    return abs(
-        a_->get_x() * (b_->get_y() - c_->get_y()) +
-        b_->get_x() * (c_->get_y() - a_->get_y()) +
-        c_->get_x() * (a_->get_y() - b_->get_y())
+    return calculate_area(a_->to_vec2(), b_->to_vec2(), c_->to_vec2());
+}
+
+double Triangle::calculate_area(const Vec2& a_, const Vec2& b_, const Vec2& c_) {
+    return std::abs(
+        a_.x * (b_.y - c_.y) +
+        b_.x * (c_.y - a_.y) +
+        c_.x * (a_.y - b_.y)
     ) * 0.5;
 }
 
 std::vector<double> Triangle::angles() const {
-    std::vector<double> angles{};
-    angles.push_back(this->angles(p1, p2, p3));
-    angles.push_back(this->angles(p2, p3, p1));
-    angles.push_back(this->angles(p3, p1, p2));
-    return angles;
+    update_cache();
+    return std::vector<double>(cached_angles, cached_angles + 3);
+}
+
+void Triangle::angles(double out[3]) const {
+    update_cache();
+    out[0] = cached_angles[0];
+    out[1] = cached_angles[1];
+    out[2] = cached_angles[2];
 }
 
 double Triangle::angles(std::shared_ptr<Point> a_, std::shared_ptr<Point> b_, std::shared_ptr<Point> c_) const {
-            double length_ab = a_->distance_to(b_);
-            double length_bc = b_->distance_to(c_);
-            double length_ac = a_->distance_to(c_);
+    return angles(a_->to_vec2(), b_->to_vec2(), c_->to_vec2());
+}
+
+double Triangle::angles(const Vec2& a_, const Vec2& b_, const Vec2& c_) {
+            double length_ab = a_.distance_to(b_);
+            double length_bc = b_.distance_to(c_);
+            double length_ac = a_.distance_to(c_);
             double cos_angle_a = (length_ab * length_ab + length_ac * length_ac - length_bc * length_bc) / 
                                  (2.0 * length_ab * length_ac + EPSILON_ERROR);
 
@@ -63,68 +80,120 @@ double Triangle::angles(std::shared_ptr<Point> a_, std::shared_ptr<Point> b_, st
 }
 
 std::shared_ptr<Triangle> Triangle::clone() const {
-    return std::make_shared<Triangle>(p1, p2, p3);
+    return make_pooled<Triangle>(p1, p2, p3);
 }
 
 std::shared_ptr<Triangle> Triangle::move(const std::shared_ptr<Point> offset) {
+    const bool current = cache_current();
     this->p1->add(offset);
     this->p2->add(offset);
     this->p3->add(offset);
+    carry_cache(current, 1.0);
     return shared_from_this();
 }
 
 std::shared_ptr<Triangle> Triangle::scale(const double factor) {
+    const bool current = cache_current();
     this->p1->scale(factor);
     this->p2->scale(factor);
     this->p3->scale(factor);
+    carry_cache(current, std::abs(factor));
     return shared_from_this();
 }
 
 std::shared_ptr<Triangle> Triangle::extend(const double factor) {
-    std::shared_ptr<Point> centroid = this->centroid();
+    const bool current = cache_current();
+    Vec2 centroid = current ? cached_centroid : center(p1->to_vec2(), p2->to_vec2(), p3->to_vec2());
 
         // Compute the new positions for each vertex.
-    double new_p1_x = centroid->get_x() + factor * (p1->get_x() - centroid->get_x());
-    double new_p1_y = centroid->get_y() + factor * (p1->get_y() - centroid->get_y());
-    double new_p2_x = centroid->get_x() + factor * (p2->get_x() - centroid->get_x());
-    double new_p2_y = centroid->get_y() + factor * (p2->get_y() - centroid->get_y());
-    double new_p3_x = centroid->get_x() + factor * (p3->get_x() - centroid->get_x());
-    double new_p3_y = centroid->get_y() + factor * (p3->get_y() - centroid->get_y());
+    Vec2 new_p1 = centroid + factor * (p1->to_vec2() - centroid);
+    Vec2 new_p2 = centroid + factor * (p2->to_vec2() - centroid);
+    Vec2 new_p3 = centroid + factor * (p3->to_vec2() - centroid);
 
-    this->p1->set(new_p1_x, new_p1_y);
-    this->p2->set(new_p2_x, new_p2_y);
-    this->p3->set(new_p3_x, new_p3_y);
+    this->p1->set(new_p1.x, new_p1.y);
+    this->p2->set(new_p2.x, new_p2.y);
+    this->p3->set(new_p3.x, new_p3.y);
 
-    // auto new_p1 = std::make_shared<Point>(new_p1_x, new_p1_y);
-    // auto new_p2 = std::make_shared<Point>(new_p2_x, new_p2_y);
-    // auto new_p3 = std::make_shared<Point>(new_p3_x, new_p3_y);
+    // auto new_p1 = make_pooled<Point>(new_p1_x, new_p1_y);
+    // auto new_p2 = make_pooled<Point>(new_p2_x, new_p2_y);
+    // auto new_p3 = make_pooled<Point>(new_p3_x, new_p3_y);
 
+    carry_cache(current, std::abs(factor));
     return shared_from_this();
 }
 
 std::shared_ptr<Triangle> Triangle::rotate(const std::shared_ptr<Point> center, const double angle) {
+    return this->rotate(center->to_vec2(), angle);
+}
+
+std::shared_ptr<Triangle> Triangle::rotate(const Vec2& center, const double angle) {
+    const bool current = cache_current();
     this->p1->rotate(center, angle);
     this->p2->rotate(center, angle);
     this->p3->rotate(center, angle);
+    carry_cache(current, 1.0);
     return shared_from_this();
 }
 
 std::shared_ptr<Triangle> Triangle::rotate_origin(const double angle) {
-    this->rotate(std::make_shared<Point>(0.0, 0.0), angle);
+    this->rotate(Vec2(), angle);
     return shared_from_this();
 }
 
 std::shared_ptr<Triangle> Triangle::rotate_center(const double angle) {
-    this->rotate(this->centroid(), angle);
+    this->rotate(centroid_vec2(), angle);
     return shared_from_this();
 }
 
 std::shared_ptr<Point> Triangle::center(std::shared_ptr<Point> a_, std::shared_ptr<Point> b_, std::shared_ptr<Point> c_) const {
-    return std::make_shared<Point>((a_->get_x() + b_->get_x() + c_->get_x()) / 3.0, (a_->get_y() + b_->get_y() + c_->get_y()) / 3.0);
+    return make_pooled<Point>(center(a_->to_vec2(), b_->to_vec2(), c_->to_vec2()));
+}
+
+Vec2 Triangle::center(const Vec2& a_, const Vec2& b_, const Vec2& c_) {
+    return (a_ + b_ + c_) / 3.0;
 }
 
 std::shared_ptr<Point> Triangle::centroid() const {
-    return this->center(p1, p2, p3);
+    return make_pooled<Point>(centroid_vec2());
+}
+
+Vec2 Triangle::centroid_vec2() const {
+    update_cache();
+    return cached_centroid;
+}
+
+bool Triangle::cache_current() const {
+    return cached && p1->to_vec2() == cached_vertices[0] && p2->to_vec2() == cached_vertices[1] && p3->to_vec2() == cached_vertices[2];
+}
+
+void Triangle::update_cache() const {
+    if (cache_current()) return;
+    const Vec2 a = p1->to_vec2();
+    const Vec2 b = p2->to_vec2();
+    const Vec2 c = p3->to_vec2();
+    cached_vertices[0] = a;
+    cached_vertices[1] = b;
+    cached_vertices[2] = c;
+    cached = true;
+    cached_perimeter = a.distance_to(b) + b.distance_to(c) + c.distance_to(a);
+    cached_area = calculate_area(a, b, c);
+    cached_angles[0] = angles(a, b, c);
+    cached_angles[1] = angles(b, c, a);
+    cached_angles[2] = angles(c, a, b);
+    cached_centroid = center(a, b, c);
+}
+
+void Triangle::carry_cache(const bool current, const double factor) const {
+    if (!current) {
+        cached = false;
+        return;
+    }
+    cached_vertices[0] = p1->to_vec2();
+    cached_vertices[1] = p2->to_vec2();
+    cached_vertices[2] = p3->to_vec2();
+    cached_perimeter *= factor;
+    cached_area *= factor * factor;
+    cached_centroid = center(cached_vertices[0], cached_vertices[1], cached_vertices[2]);
 }
 
 bool Triangle::is_equal(const std::shared_ptr<Triangle> other) const {
@@ -133,6 +202,7 @@ bool Triangle::is_equal(const std::shared_ptr<Triangle> other) const {
            (this->p3->is_equal(other->get_p3()));
 }
 
+#ifndef PHYSICS_HEADLESS
 std::shared_ptr<sf::ConvexShape> Triangle::to_convex_shape(const sf::Color& color_fill, const sf::Color& color_outline, const double outline_thickness) const {
     std::shared_ptr<sf::ConvexShape> triangle = std::make_shared<sf::ConvexShape>(3);
     triangle->setPoint(0, *p1->to_vector2f());
@@ -143,6 +213,7 @@ std::shared_ptr<sf::ConvexShape> Triangle::to_convex_shape(const sf::Color& colo
     triangle->setOutlineThickness(outline_thickness);
     return triangle;
 }
+#endif
 
 std::string Triangle::to_string() const {
     return "Triangle(" + p1->to_string() + ", " + p2->to_string() + ", " + p3->to_string() + ")";
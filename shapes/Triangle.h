@@ -8,7 +8,21 @@ class Triangle : public Shape, public std::enable_shared_from_this<Triangle> {
         std::shared_ptr<Point> p1;
         std::shared_ptr<Point> p2;
         std::shared_ptr<Point> p3;
-        
+        // Derived values, computed on first use from the vertex coordinates in cached_vertices. They are stale once a
+        // vertex has moved, by this triangle or through a Point shared with another shape (clone shares them).
+        mutable bool cached = false;
+        mutable Vec2 cached_vertices[3];
+        mutable double cached_perimeter;
+        mutable double cached_area;
+        mutable double cached_angles[3];
+        mutable Vec2 cached_centroid;
+
+        bool cache_current() const;
+        void update_cache() const;
+        // After a rotation, translation or scaling of all vertices that scales lengths by factor: keeps the angles,
+        // perimeter and area if the cache was current before it, and recomputes only the centroid.
+        void carry_cache(const bool current, const double factor) const;
+
     public:
         Triangle(std::shared_ptr<Point> p1, std::shared_ptr<Point> p2, std::shared_ptr<Point> p3);
         std::shared_ptr<Point> get_p1() const;
@@ -20,19 +34,28 @@ class Triangle : public Shape, public std::enable_shared_from_this<Triangle> {
         double calculate_perimeter() const;
         double calculate_area() const;
         double calculate_area(const std::shared_ptr<Point> a_, const std::shared_ptr<Point> b_, const std::shared_ptr<Point> c_) const;
+        static double calculate_area(const Vec2& a_, const Vec2& b_, const Vec2& c_);
         std::vector<double> angles() const;
+        // The angles at p1, p2 and p3, without allocating.
+        void angles(double out[3]) const;
         double angles(std::shared_ptr<Point> a_, std::shared_ptr<Point> b_, std::shared_ptr<Point> c_) const;
+        static double angles(const Vec2& a_, const Vec2& b_, const Vec2& c_);
         std::shared_ptr<Triangle> clone() const;
         std::shared_ptr<Triangle> move(const std::shared_ptr<Point> offset);
         std::shared_ptr<Triangle> scale(const double factor);
         std::shared_ptr<Triangle> extend(const double factor);
         std::shared_ptr<Triangle> rotate(const std::shared_ptr<Point> center, const double angle);
+        std::shared_ptr<Triangle> rotate(const Vec2& center, const double angle);
         std::shared_ptr<Triangle> rotate_origin(const double angle);
         std::shared_ptr<Triangle> rotate_center(const double angle);
         std::shared_ptr<Point> center(std::shared_ptr<Point> a_, std::shared_ptr<Point> b_, std::shared_ptr<Point> c_) const;
+        static Vec2 center(const Vec2& a_, const Vec2& b_, const Vec2& c_);
         std::shared_ptr<Point> centroid() const;
+        Vec2 centroid_vec2() const;
         bool is_equal(const std::shared_ptr<Triangle> other) const;
+#ifndef PHYSICS_HEADLESS
         std::shared_ptr<sf::ConvexShape> to_convex_shape(const sf::Color& color_fill, const sf::Color& color_outline, const double outline_thickness) const;
+#endif
         std::string to_string() const;
 };
 
@@ -0,0 +1,60 @@
+#ifndef VEC2_H
+#define VEC2_H
+
+#include <cmath>
+#include <type_traits>
+
+// A 2D vector/point held by value. Unlike Point it is not reference counted and never allocates, so it is the
+// type to use in hot geometric queries; the shared_ptr<Point> API is a thin wrapper over it.
+struct Vec2 {
+    double x;
+    double y;
+
+    constexpr Vec2() : x(0.0), y(0.0) {}
+    constexpr Vec2(const double x, const double y) : x(x), y(y) {}
+
+    constexpr Vec2 operator+(const Vec2& other) const { return Vec2(x + other.x, y + other.y); }
+    constexpr Vec2 operator-(const Vec2& other) const { return Vec2(x - other.x, y - other.y); }
+    constexpr Vec2 operator-() const { return Vec2(-x, -y); }
+    constexpr Vec2 operator*(const double factor) const { return Vec2(x * factor, y * factor); }
+    constexpr Vec2 operator/(const double factor) const { return Vec2(x / factor, y / factor); }
+    constexpr Vec2& operator+=(const Vec2& other) { x += other.x; y += other.y; return *this; }
+    constexpr Vec2& operator-=(const Vec2& other) { x -= other.x; y -= other.y; return *this; }
+    constexpr Vec2& operator*=(const double factor) { x *= factor; y *= factor; return *this; }
+    constexpr Vec2& operator/=(const double factor) { x /= factor; y /= factor; return *this; }
+    constexpr bool operator==(const Vec2& other) const { return x == other.x && y == other.y; }
+    constexpr bool operator!=(const Vec2& other) const { return !(*this == other); }
+
+    constexpr double dot(const Vec2& other) const { return x * other.x + y * other.y; }
+    // z component of the 3D cross product, positive when other is counter-clockwise from this.
+    constexpr double cross(const Vec2& other) const { return x * other.y - y * other.x; }
+    constexpr double length_squared() const { return x * x + y * y; }
+    constexpr double distance_squared_to(const Vec2& other) const { return (*this - other).length_squared(); }
+    constexpr Vec2 mid_point_to(const Vec2& other) const { return Vec2((x + other.x) / 2.0, (y + other.y) / 2.0); }
+    constexpr Vec2 reflect_over_x() const { return Vec2(x, -y); }
+    constexpr Vec2 reflect_over_y() const { return Vec2(-x, y); }
+    constexpr Vec2 reflect_over_origin() const { return Vec2(-x, -y); }
+    constexpr Vec2 perpendicular() const { return Vec2(-y, x); }
+
+    double length() const { return std::sqrt(length_squared()); }
+    double distance_to(const Vec2& other) const { return std::sqrt(distance_squared_to(other)); }
+    double angle() const { return std::atan2(y, x); }
+    Vec2 normalized() const {
+        double l = length();
+        return l > 0.0 ? *this / l : Vec2();
+    }
+    Vec2 rotate(const Vec2& center, const double angle) const {
+        const double c = std::cos(angle);
+        const double s = std::sin(angle);
+        const Vec2 d = *this - center;
+        return Vec2(d.x * c - d.y * s + center.x, d.x * s + d.y * c + center.y);
+    }
+    Vec2 rotate_origin(const double angle) const { return rotate(Vec2(), angle); }
+};
+
+constexpr Vec2 operator*(const double factor, const Vec2& v) { return v * factor; }
+
+static_assert(std::is_trivially_copyable<Vec2>::value, "Vec2 must stay a plain value type");
+
+
+#endif // VEC2_H